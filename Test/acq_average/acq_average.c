@@ -0,0 +1,135 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya on-board frame averaging test
+ *
+ * Runs rp_AcqAverageFrames() on the simulator backend (RP_BACKEND=sim). Channel A
+ * carries a sine with uniform noise, triggered on the rising edge of the same sine
+ * without noise on channel B: the average has to
+ * follow the noiseless sine and the variance has to match the noise. External triggers
+ * that stop arriving have to end in RP_ETMO with the frames captured so far averaged,
+ * and a zero frame count has to be rejected.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "rp.h"
+
+/* The simulator falls behind at decimation 1 and skips samples, at 64 it keeps up */
+#define DECIMATION       RP_DEC_64
+#define SAMPLE_RATE      (125e6 / 64)
+#define SIZE             1024
+#define PRE_TRIGGER      256
+#define FRAMES           200
+#define SINE_FREQ        15625  // 125 samples per period
+#define SINE_AMP         0.5
+#define NOISE            0.1    // uniform, V
+#define AVG_TOLERANCE    0.025  // V, the residual noise is NOISE/sqrt(3*FRAMES) rms
+#define VAR_TOLERANCE    0.15   // relative, of the mean variance
+#define EXT_TRIGGERS     5
+#define TIMEOUT_MS       200
+
+static int check(bool ok, const char *what)
+{
+    printf("%-48s %s\n", what, ok ? "ok" : "FAIL");
+    return !ok;
+}
+
+/* Trigger level crossed at the pre-trigger sample, the rest follows the sine. Noise on the
+ * trigger channel would jitter the trigger point, so channel B triggers on a clean copy. */
+static int sineAverage()
+{
+    static float avg[SIZE], var[SIZE];
+    uint32_t count = FRAMES;
+    int failed = 0;
+
+    rp_SimSetWaveform(RP_CH_1, RP_SIM_WAVE_SINE, SINE_FREQ, SINE_AMP, 0, NOISE);
+    rp_SimSetWaveform(RP_CH_2, RP_SIM_WAVE_SINE, SINE_FREQ, SINE_AMP, 0, 0);
+    rp_AcqReset();
+    rp_AcqSetDecimation(DECIMATION);
+    rp_AcqSetTriggerLevel(0);
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHB_PE);
+
+    int ret = rp_AcqAverageFrames(&count, SIZE, PRE_TRIGGER, avg, NULL, var, NULL, 1000);
+    failed += check(ret == RP_OK && count == FRAMES, "sine: all frames averaged");
+
+    double err = 0, mean_var = 0;
+    for (int i = 0; i < SIZE; ++i) {
+        double t = (double) (i - PRE_TRIGGER) / SAMPLE_RATE;
+        err = fmax(err, fabs(avg[i] - SINE_AMP * sin(2 * M_PI * SINE_FREQ * t)));
+        mean_var += var[i] / SIZE;
+    }
+    printf("max deviation %.4f V, mean variance %.5f V^2 (noise %.5f V^2)\n", err, mean_var, NOISE * NOISE / 3);
+    failed += check(err < AVG_TOLERANCE, "sine: average follows the signal");
+    failed += check(fabs(mean_var / (NOISE * NOISE / 3) - 1) < VAR_TOLERANCE, "sine: variance matches the noise");
+    return failed;
+}
+
+static void *extTriggers(void *arg)
+{
+    for (int i = 0; i < EXT_TRIGGERS; ++i) {
+        usleep(20000);
+        rp_SimExtTrigger();
+    }
+    return NULL;
+}
+
+/* Triggers stop after EXT_TRIGGERS, the average of those is returned with RP_ETMO */
+static int partialAverage()
+{
+    static float avg[SIZE];
+    uint32_t count = FRAMES;
+    pthread_t thread;
+    int failed = 0;
+
+    rp_SimSetWaveform(RP_CH_1, RP_SIM_WAVE_SINE, SINE_FREQ, 0, 0.25, 0);
+    rp_AcqReset();
+    rp_AcqSetDecimation(DECIMATION);
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_EXT_PE);
+
+    pthread_create(&thread, NULL, extTriggers, NULL);
+    int ret = rp_AcqAverageFrames(&count, SIZE, PRE_TRIGGER, avg, NULL, NULL, NULL, TIMEOUT_MS);
+    pthread_join(thread, NULL);
+
+    printf("partial: %s after %u frames, average %.4f V\n", rp_GetError(ret), count, avg[SIZE / 2]);
+    failed += check(ret == RP_ETMO && count > 0 && count <= EXT_TRIGGERS, "timeout: frames so far counted");
+    failed += check(fabs(avg[SIZE / 2] - 0.25) < AVG_TOLERANCE, "timeout: frames so far averaged");
+
+    count = 0;
+    failed += check(rp_AcqAverageFrames(&count, SIZE, PRE_TRIGGER, avg, NULL, NULL, NULL, TIMEOUT_MS) == RP_EOOR,
+                    "zero frames rejected");
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    if (rp_Init() != RP_OK) {
+        printf("initialization failed, RP_BACKEND=sim selects the simulator\n");
+        return 1;
+    }
+
+    failed += sineAverage();
+    failed += partialAverage();
+
+    rp_Release();
+    if (failed) {
+        printf("%d check(s) failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
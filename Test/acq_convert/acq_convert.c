@@ -0,0 +1,117 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya ADC counts to voltage conversion test and benchmark
+ *
+ * Compares bulk conversion (cmn_CnvCntToVBuf) against the reference per sample
+ * conversion (cmn_CnvCntToV) for all 14 bit codes and a set of gain/calibration
+ * states, then measures the time needed to convert a full 16k ADC buffer.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "common.h"
+
+#define ADC_BITS        14
+#define ADC_BUFFER_SIZE (16 * 1024)
+#define BENCH_LOOPS     200
+
+typedef struct {
+    float gainV;
+    uint32_t calibScale;
+    int dc_offs;
+} conv_state_t;
+
+static const conv_state_t states[] = {
+    {  1.0, 0,          0    },
+    {  1.0, 0x2FAF0800, 12   },
+    {  1.0, 0x2A5C3A2C, -35  },
+    { 20.0, 0,          0    },
+    { 20.0, 0x3ED5B8D6, 150  },
+    { 20.0, 0x3B2A1234, -300 },
+};
+
+static uint32_t raw[ADC_BUFFER_SIZE];
+static float ref[ADC_BUFFER_SIZE];
+static float out[ADC_BUFFER_SIZE];
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Reference implementation, as acq_GetDataV used to read the ring buffer */
+static void convertReference(uint32_t pos, const conv_state_t *st)
+{
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; ++i) {
+        ref[i] = cmn_CnvCntToV(ADC_BITS, raw[(pos + i) % ADC_BUFFER_SIZE], st->gainV, st->calibScale, st->dc_offs, 0.0);
+    }
+}
+
+/* Bulk implementation, split into two contiguous spans */
+static void convertBulk(uint32_t pos, const conv_state_t *st, float scale, float offset)
+{
+    uint32_t first = ADC_BUFFER_SIZE - pos;
+    cmn_CnvCntToVBuf(ADC_BITS, &raw[pos], first, st->dc_offs, scale, offset, out);
+    cmn_CnvCntToVBuf(ADC_BITS, raw, ADC_BUFFER_SIZE - first, st->dc_offs, scale, offset, &out[first]);
+}
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    const uint32_t pos = 5000;
+
+    /* every 14 bit code exactly once */
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; ++i) {
+        raw[i] = i;
+    }
+
+    for (size_t s = 0; s < sizeof(states) / sizeof(states[0]); ++s) {
+        const conv_state_t *st = &states[s];
+        float scale, offset;
+        cmn_CnvCntToVCoef(ADC_BITS, st->gainV, st->calibScale, 0.0, &scale, &offset);
+
+        convertReference(pos, st);
+        convertBulk(pos, st, scale, offset);
+
+        double max_err = 0;
+        for (uint32_t i = 0; i < ADC_BUFFER_SIZE; ++i) {
+            max_err = fmax(max_err, fabs((double)out[i] - (double)ref[i]));
+        }
+        double lsb = fabs(scale);
+        int ok = max_err <= lsb;
+        failed |= !ok;
+
+        double t0 = now_s();
+        for (int l = 0; l < BENCH_LOOPS; ++l) {
+            convertReference(pos, st);
+        }
+        double t1 = now_s();
+        for (int l = 0; l < BENCH_LOOPS; ++l) {
+            convertBulk(pos, st, scale, offset);
+        }
+        double t2 = now_s();
+
+        double t_ref = (t1 - t0) / BENCH_LOOPS * 1e6;
+        double t_bulk = (t2 - t1) / BENCH_LOOPS * 1e6;
+        printf("gain %4.1f V scale 0x%08x dc %4d: max err %.3g V (%.4f LSB) %s, 16k ref %8.1f us, bulk %7.1f us, x%.1f\n",
+               st->gainV, st->calibScale, st->dc_offs, max_err, max_err / lsb, ok ? "OK" : "FAIL",
+               t_ref, t_bulk, t_ref / t_bulk);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
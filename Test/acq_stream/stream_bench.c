@@ -0,0 +1,170 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya acquisition streaming benchmark
+ *
+ * Runs the librp streaming engine against a simulated ADC: a thread writes a ramp
+ * into two 16k ring buffers and advances the write pointer at 125 MS/s / decimation.
+ * Reports throughput, overruns, lost samples and underruns and checks that every
+ * chunk holds consecutive samples.
+ *
+ * Usage: stream_bench <decimation> [seconds] [consumer delay per chunk in us]
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "calib.h"
+#include "acq_handler.h"
+#include "acq_stream.h"
+
+#define ADC_BUFFER_SIZE (16 * 1024)
+#define RAMP_MASK       0x1FFF
+#define CHUNK_SIZE      2048
+#define CHUNK_NUM       64
+
+static uint32_t sim_buffer[2][ADC_BUFFER_SIZE];
+static volatile uint32_t sim_wp = ADC_BUFFER_SIZE - 1;
+static volatile bool sim_running = true;
+static uint32_t sim_decimation = 8;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Simulated ADC: writes ramp samples in real time and publishes the write pointer */
+static void *simThread(void *arg)
+{
+    uint64_t t0 = now_ns();
+    uint64_t written = 0;
+    uint64_t period = 8 * (uint64_t)sim_decimation;
+
+    while (sim_running) {
+        uint64_t target = (now_ns() - t0) / period;
+        for (; written < target; ++written) {
+            uint32_t p = written % ADC_BUFFER_SIZE;
+            sim_buffer[0][p] = written & RAMP_MASK;
+            sim_buffer[1][p] = (written + 1) & RAMP_MASK;
+        }
+        if (target > 0) {
+            __atomic_store_n(&sim_wp, (target - 1) % ADC_BUFFER_SIZE, __ATOMIC_RELEASE);
+        }
+        usleep(20);
+    }
+    return NULL;
+}
+
+/* librp functions used by the streaming engine, served by the simulator */
+
+const char* rp_GetError(int errorCode) { return "simulated error"; }
+rp_calib_params_t calib_GetParams() { rp_calib_params_t calib; memset(&calib, 0, sizeof(calib)); return calib; }
+uint32_t acq_GetNormalizedDataPos(uint32_t pos) { return pos % ADC_BUFFER_SIZE; }
+int acq_SetTriggerSrc(rp_acq_trig_src_t source) { return RP_OK; }
+int acq_Start() { return RP_OK; }
+int acq_Stop() { return RP_OK; }
+
+int acq_GetWritePointer(uint32_t* pos)
+{
+    *pos = __atomic_load_n(&sim_wp, __ATOMIC_ACQUIRE);
+    return RP_OK;
+}
+
+int acq_GetDecimationFactor(uint32_t* decimation)
+{
+    *decimation = sim_decimation;
+    return RP_OK;
+}
+
+int acq_GetDecimationRatio(uint32_t* ratio)
+{
+    *ratio = sim_decimation;
+    return RP_OK;
+}
+
+int acq_GetRawSpans(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_raw_spans_t* spans)
+{
+    const uint32_t *raw = sim_buffer[channel == RP_CH_1 ? 0 : 1];
+    spans->pos = pos % ADC_BUFFER_SIZE;
+    spans->size[0] = MIN(size, ADC_BUFFER_SIZE - spans->pos);
+    spans->size[1] = size - spans->size[0];
+    spans->data[0] = &raw[spans->pos];
+    spans->data[1] = raw;
+    return RP_OK;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <decimation> [seconds] [consumer delay per chunk in us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    sim_decimation = atoi(argv[1]);
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    int delay_us = argc > 3 ? atoi(argv[3]) : 0;
+
+    static int16_t ch1[CHUNK_SIZE], ch2[CHUNK_SIZE];
+    pthread_t sim;
+    pthread_create(&sim, NULL, simThread, NULL);
+    usleep(1000);
+
+    if (acq_StreamStart(CHUNK_SIZE, CHUNK_NUM) != RP_OK) {
+        fprintf(stderr, "Failed to start stream\n");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t t0 = now_ns();
+    uint64_t chunks = 0, gaps = 0, errors = 0, last_seq = 0;
+    while (now_ns() - t0 < seconds * 1e9) {
+        uint64_t seq;
+        if (acq_StreamRead(ch1, ch2, &seq, 100) != RP_OK) {
+            continue;
+        }
+        for (int i = 1; i < CHUNK_SIZE; ++i) {
+            if (ch1[i] != ((ch1[i - 1] + 1) & RAMP_MASK) || ch2[i] != ((ch1[i] + 1) & RAMP_MASK)) {
+                errors++;
+                break;
+            }
+        }
+        if (chunks > 0 && seq != last_seq + 1) {
+            gaps++;
+        }
+        last_seq = seq;
+        chunks++;
+        if (delay_us) {
+            usleep(delay_us);
+        }
+    }
+    double elapsed = (now_ns() - t0) * 1e-9;
+
+    rp_acq_stream_stats_t stats;
+    acq_StreamGetStats(&stats);
+    acq_StreamStop();
+    sim_running = false;
+    pthread_join(sim, NULL);
+
+    printf("decimation %5u: %.0f chunks/s, %.2f MS/s per channel (ADC %.2f MS/s), "
+           "produced %llu, overruns %llu, lost samples %llu, underruns %llu, sequence gaps %llu, corrupted chunks %llu\n",
+           sim_decimation, chunks / elapsed, chunks * CHUNK_SIZE / elapsed * 1e-6, 125.0 / sim_decimation,
+           (unsigned long long)stats.chunks, (unsigned long long)stats.overruns,
+           (unsigned long long)stats.lost_samples, (unsigned long long)stats.underruns,
+           (unsigned long long)gaps, (unsigned long long)errors);
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
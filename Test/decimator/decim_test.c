@@ -0,0 +1,159 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya software decimator test and benchmark
+ *
+ * For a set of ratios checks the designed response (passband flatness, rejection of
+ * everything that aliases into the passband), compares it with tones measured through
+ * the streaming filter and reports the throughput in input samples per second. Ratios
+ * whose FIR stage would be too long have to be rejected.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "common.h"
+#include "decimator.h"
+
+#define BLOCK_SIZE       4096
+#define MEASURE_OUT      2048
+#define TONE_AMPLITUDE   16000
+#define MAX_RIPPLE_DB    0.1
+#define MIN_REJECTION_DB 70.0
+#define MAX_MEASURE_ERR  0.01
+
+const char* rp_GetError(int errorCode) { return "error"; }
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double toDb(double gain)
+{
+    return 20 * log10(MAX(gain, 1e-12));
+}
+
+/* Runs a tone at 'freq' (relative to output rate) through the decimator, returns output amplitude */
+static double measureTone(rp_decimator_t* dec, uint32_t ratio, double freq)
+{
+    static int16_t in[BLOCK_SIZE];
+    static float out[BLOCK_SIZE + 1];
+    float delay;
+    uint32_t produced = 0, size;
+    uint64_t n = 0;
+    double power = 0;
+
+    decim_Reset(dec);
+    decim_GetDelay(dec, &delay);
+    uint32_t settle = (uint32_t)(2 * delay) + 1;
+
+    while (produced < settle + MEASURE_OUT) {
+        for (int i = 0; i < BLOCK_SIZE; ++i, ++n) {
+            in[i] = lrint(TONE_AMPLITUDE * sin(2 * M_PI * freq / ratio * n));
+        }
+        decim_Process(dec, in, BLOCK_SIZE, out, &size);
+        for (uint32_t i = 0; i < size; ++i, ++produced) {
+            if (produced >= settle && produced < settle + MEASURE_OUT) {
+                power += out[i] * out[i];
+            }
+        }
+    }
+    return sqrt(2 * power / MEASURE_OUT) / TONE_AMPLITUDE;
+}
+
+static double throughput(rp_decimator_t* dec)
+{
+    static int16_t in[BLOCK_SIZE];
+    static float out[BLOCK_SIZE + 1];
+    uint32_t size;
+    uint64_t total = 0;
+
+    for (int i = 0; i < BLOCK_SIZE; ++i) {
+        in[i] = rand() % 16384 - 8192;
+    }
+    double t0 = now_s();
+    while (now_s() - t0 < 0.2) {
+        for (int k = 0; k < 64; ++k) {
+            decim_Process(dec, in, BLOCK_SIZE, out, &size);
+        }
+        total += 64 * BLOCK_SIZE;
+    }
+    return total / (now_s() - t0) * 1e-6;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t ratios[] = { 2, 3, 8, 16, 24, 31, 125, 128, 1000, 1024 };
+    static const uint32_t rejected[] = { 1, 37, 74, 1021, 1025 };
+    int failures = 0;
+
+    for (int r = 0; r < sizeof(rejected) / sizeof(rejected[0]); ++r) {
+        rp_decimator_t* dec;
+        if (decim_Create(rejected[r], &dec) == RP_OK) {
+            printf("ratio %4u: not rejected FAIL\n", rejected[r]);
+            decim_Destroy(dec);
+            failures++;
+        }
+    }
+
+    for (int r = 0; r < sizeof(ratios) / sizeof(ratios[0]); ++r) {
+        uint32_t ratio = ratios[r];
+        rp_decimator_t* dec;
+        float gain;
+
+        if (decim_Create(ratio, &dec) != RP_OK) {
+            printf("ratio %4u: create failed\n", ratio);
+            failures++;
+            continue;
+        }
+
+        /* Designed response over passband and alias bands */
+        double pass_min = 1e9, pass_max = 0, alias_max = 0;
+        for (int k = 0; k <= 400; ++k) {
+            decim_GetResponse(dec, DECIM_PASSBAND * k / 400, &gain);
+            pass_min = MIN(pass_min, gain);
+            pass_max = MAX(pass_max, gain);
+        }
+        /* CIC nulls take care of far alias bands, check the nearest ones */
+        for (double f = 1 - DECIM_PASSBAND; f <= MIN(ratio / 2.0, 16); f += 0.01) {
+            /* only frequencies that fold into the passband matter */
+            double folded = fabs(f - round(f));
+            if (folded <= DECIM_PASSBAND) {
+                decim_GetResponse(dec, f, &gain);
+                alias_max = MAX(alias_max, gain);
+            }
+        }
+        double ripple = toDb(pass_max) - toDb(pass_min);
+        double rejection = -toDb(alias_max);
+
+        /* Measured tones must follow the designed response */
+        double measure_err = 0;
+        for (double f = 0.05; f < DECIM_PASSBAND; f += 0.1) {
+            decim_GetResponse(dec, f, &gain);
+            measure_err = MAX(measure_err, fabs(measureTone(dec, ratio, f) - gain));
+        }
+
+        bool ok = ripple <= MAX_RIPPLE_DB && rejection >= MIN_REJECTION_DB && measure_err <= MAX_MEASURE_ERR;
+        failures += !ok;
+        printf("ratio %4u: passband ripple %.3f dB, alias rejection %.1f dB, measured error %.4f, %6.1f MS/s %s\n",
+               ratio, ripple, rejection, measure_err, throughput(dec), ok ? "OK" : "FAIL");
+        decim_Destroy(dec);
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
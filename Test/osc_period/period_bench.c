@@ -0,0 +1,255 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya oscilloscope period estimator test and benchmark
+ *
+ * Measures the period of a set of reference signals (view sized, known fractional period)
+ * with meas_Period() and with the previous O(n^2) autocorrelation search, checks the new
+ * estimator is within MAX_REL_ERR of the true period and reports the time per measurement of both.
+ * Also checks the fused scalar measurement kernel meas_Frame() against separate passes
+ * over the view, as osc_measure* did them, and reports the time of both.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+
+#include "common.h"
+#include "measure.h"
+#include "osciloscopeApp.h"
+#include "../../rpbase/src/common.h"
+
+#define VIEW_SIZE        VIEW_SIZE_DEFAULT
+#define MAX_REL_ERR      0.01   // new estimator, relative to the period
+#define BENCH_TIME_S     0.2
+#define FRAME_TOLERANCE  1e-4
+
+const char* rpApp_GetError(int errorCode) { return "error"; }
+int rp_AcqGetSamplingRateHz(float* sampling_rate) { *sampling_rate = 125e6; return RP_OK; }
+
+typedef enum { SINE, SQUARE, TRIANGLE, PULSE, HARMONIC } shape_t;
+
+typedef struct {
+    const char *name;
+    shape_t shape;
+    double period;  // view points
+    double noise;   // rms, relative to amplitude 1
+} ref_signal_t;
+
+static const ref_signal_t signals[] = {
+    { "sine",          SINE,      97.31, 0    },
+    { "sine long",     SINE,     411.7,  0    },
+    { "sine short",    SINE,      13.37, 0    },
+    { "square",        SQUARE,   123.45, 0    },
+    { "triangle",      TRIANGLE,  77.7,  0    },
+    { "pulse 10%",     PULSE,    150.2,  0    },
+    { "sine + 3rd",    HARMONIC, 201.3,  0    },
+    { "sine noise 5%", SINE,      97.31, 0.05 },
+    { "sine noise 30%",SINE,     180.9,  0.3  },
+    { "square noise",  SQUARE,   123.45, 0.2  },
+    { "short noise",   SINE,      21.7,  0.2  },
+    { "harmonic noise",HARMONIC, 201.3,  0.3  },
+};
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double gauss()
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+static void generate(const ref_signal_t *s, float *data, int size)
+{
+    srand(1);
+    for (int i = 0; i < size; ++i) {
+        double ph = fmod(i / s->period + 0.123, 1.0);
+        double v;
+        switch (s->shape) {
+            case SQUARE:   v = ph < 0.5 ? 1 : -1;                      break;
+            case TRIANGLE: v = ph < 0.5 ? 4 * ph - 1 : 3 - 4 * ph;     break;
+            case PULSE:    v = ph < 0.1 ? 1 : 0;                       break;
+            case HARMONIC: v = sin(2 * M_PI * ph) + 0.5 * sin(6 * M_PI * ph); break;
+            default:       v = sin(2 * M_PI * ph);                     break;
+        }
+        data[i] = 0.3 + 0.5 * (v + s->noise * gauss());
+    }
+}
+
+/* Period search used by osc_measurePeriod() before, O(n^2) autocorrelation */
+static int referencePeriod(const float *in, int size, float *period)
+{
+    float data[size];
+    float mean = 0;
+    for (int i = 0; i < size; ++i) {
+        data[i] = in[i];
+        mean += data[i];
+    }
+    mean = mean / size;
+    for (int i = 0; i < size; ++i){
+        data[i] -= mean;
+    }
+
+    float xcorr[size];
+    for (int i = 0; i < size; ++i) {
+        xcorr[i] = 0;
+        for (int j = 0; j < size-i; ++j) {
+            xcorr[i] += data[j] * data[j+i];
+        }
+        xcorr[i] /= size-i;
+    }
+
+    int left_idx = 0, right_idx = 0, left_edge_idx = 0, right_edge_idx = size-2;
+    for (int i = 1; i < size-1; ++i) {
+        if((xcorr[i] / xcorr[0]) < PERIOD_EXISTS_MIN_THRESHOLD) { left_edge_idx = i; break; }
+    }
+    if(left_edge_idx == 0) return RP_APP_ECP;
+    for (int i = left_edge_idx; i < size-1; ++i) {
+        if((xcorr[i] / xcorr[0]) >= PERIOD_EXISTS_MAX_THRESHOLD) { left_idx = i; break; }
+    }
+    if(left_idx == 0) return RP_APP_ECP;
+    for (int i = left_idx; i < size-1; ++i) {
+        if((xcorr[i] / xcorr[0]) < PERIOD_EXISTS_MIN_THRESHOLD) { right_edge_idx = i; break; }
+    }
+    for (int i = right_edge_idx; i >= left_idx; --i) {
+        if((xcorr[i] / xcorr[0]) >= PERIOD_EXISTS_MAX_THRESHOLD) { right_idx = i; break; }
+    }
+    float loc_max = xcorr[left_idx];
+    int max_idx = left_idx;
+    for (int i = left_idx; i <= right_idx; ++i) {
+        if(loc_max < xcorr[i]) { loc_max = xcorr[i]; max_idx = i; }
+    }
+    int left_amax_idx = max_idx, right_amax_idx = max_idx;
+    for (int i = left_idx; i <= right_idx; ++i) {
+        if(xcorr[i] >= loc_max * PERIOD_EXISTS_PEAK_THRESHOLD) { left_amax_idx = i; break; }
+    }
+    for (int i = right_edge_idx; i >= left_idx; --i) {
+        if(xcorr[i] >= loc_max * PERIOD_EXISTS_PEAK_THRESHOLD) { right_amax_idx = i; break; }
+    }
+    *period = (left_amax_idx + right_amax_idx) / 2.f;
+    return RP_OK;
+}
+
+/* Separate passes per measurement, as osc_measure* did them before meas_Frame() */
+static void __attribute__((noinline)) referenceFrame(const float *data, uint32_t size, meas_frame_t *res)
+{
+    double sum = 0, sum_sq = 0;
+    float max = -FLT_MAX, min = FLT_MAX;
+    int high = 0;
+    for (int i = 0; i < size; ++i) max = data[i] > max ? data[i] : max;
+    for (int i = 0; i < size; ++i) min = data[i] < min ? data[i] : min;
+    for (int i = 0; i < size; ++i) sum += data[i];
+    for (int i = 0; i < size; ++i) sum_sq += data[i] * data[i];
+    float mean = sum / size;
+    for (int i = 0; i < size; ++i) high += data[i] > mean;
+    res->size = size;
+    res->min = min;
+    res->max = max;
+    res->mean = mean;
+    res->var = sum_sq / size - (double)mean * mean;
+    res->duty = (float)high / size;
+}
+
+static double benchFrame(void (*fn)(const float*, uint32_t, meas_frame_t*), const float *data, int size)
+{
+    static volatile meas_frame_t res;
+    int n = 0;
+    double start = now_s(), t;
+    do {
+        fn(data, size, (meas_frame_t *) &res);
+        ++n;
+        t = now_s() - start;
+    } while (t < BENCH_TIME_S);
+    return t / n * 1e6;
+}
+
+/* Average time of one call in microseconds */
+static double bench(int (*fn)(const float*, uint32_t, float*), const float *data, int size)
+{
+    float period;
+    int n = 0;
+    double start = now_s(), t;
+    do {
+        fn(data, size, &period);
+        ++n;
+        t = now_s() - start;
+    } while (t < BENCH_TIME_S);
+    return t / n * 1e6;
+}
+
+static int reference(const float *data, uint32_t size, float *period)
+{
+    return referencePeriod(data, size, period);
+}
+
+int main(int argc, char **argv)
+{
+    static float data[VIEW_SIZE];
+    int failed = 0;
+    double ref_time = 0, new_time = 0;
+
+    printf("%-16s %9s %9s %9s %9s %9s\n", "signal", "period", "ref", "new", "ref us", "new us");
+    for (int k = 0; k < sizeof(signals) / sizeof(signals[0]); ++k) {
+        const ref_signal_t *s = &signals[k];
+        float p_ref = NAN, p_new = NAN;
+        generate(s, data, VIEW_SIZE);
+
+        referencePeriod(data, VIEW_SIZE, &p_ref);
+        int ret_new = meas_Period(data, VIEW_SIZE, &p_new);
+        double t_ref = bench(reference, data, VIEW_SIZE);
+        double t_new = bench(meas_Period, data, VIEW_SIZE);
+        ref_time += t_ref;
+        new_time += t_new;
+
+        double err_new = (ret_new == RP_OK) ? fabs(p_new - s->period) / s->period : INFINITY;
+        bool ok = err_new <= MAX_REL_ERR;
+        failed += !ok;
+
+        printf("%-16s %9.3f %9.3f %9.3f %9.1f %9.1f%s\n", s->name, s->period, p_ref, p_new, t_ref, t_new, ok ? "" : "  FAIL");
+    }
+    printf("total: reference %.1f us, new %.1f us, speedup %.1fx\n", ref_time, new_time, ref_time / new_time);
+
+    ref_time = new_time = 0;
+    printf("\n%-16s %9s %9s %9s\n", "frame kernel", "ref us", "new us", "max err");
+    for (int k = 0; k < sizeof(signals) / sizeof(signals[0]); ++k) {
+        const ref_signal_t *s = &signals[k];
+        meas_frame_t ref, res;
+        generate(s, data, VIEW_SIZE);
+        referenceFrame(data, VIEW_SIZE, &ref);
+        meas_Frame(data, VIEW_SIZE, &res);
+        double err = MAX(MAX(fabs(ref.min - res.min), fabs(ref.max - res.max)),
+                         MAX(MAX(fabs(ref.mean - res.mean), fabs(ref.var - res.var)), fabs(ref.duty - res.duty)));
+        double t_ref = benchFrame(referenceFrame, data, VIEW_SIZE);
+        double t_new = benchFrame(meas_Frame, data, VIEW_SIZE);
+        ref_time += t_ref;
+        new_time += t_new;
+        bool ok = err <= FRAME_TOLERANCE;
+        failed += !ok;
+        printf("%-16s %9.2f %9.2f %9.2g%s\n", s->name, t_ref, t_new, err, ok ? "" : "  FAIL");
+    }
+    printf("total: reference %.1f us, new %.1f us, speedup %.1fx\n", ref_time, new_time, ref_time / new_time);
+
+    meas_Release();
+    if (failed) {
+        printf("%d check(s) failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,371 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya spectrum analyzer DSP test and benchmark
+ *
+ * Runs 16k sample frames of both channels, as raw ADC counts in the FPGA ring layout,
+ * through the fused single precision rp_spectr_process() and through the previous
+ * double precision chain (conversion to double, Hann filter, FFT amplitude, decimation
+ * to power, dBm conversion). Checks the spectra and peaks agree and reports the time
+ * per frame of both. Then checks Welch segments and averaging smooth the noise floor
+ * without moving the tone power, and that the hold traces bracket the spectrum.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "spec_dsp.h"
+#include "spec_fpga.h"
+#include "kiss_fftr.h"
+
+#define N                SPECTR_FPGA_SIG_LEN
+#define BENCH_TIME_S     0.5
+#define DB_RANGE         100.0  // compared bins, below the peak of the reference
+#define DB_TOLERANCE     0.01   // dB
+#define PEAK_TOLERANCE   0.001  // dB
+#define AVG_FRAMES       32
+#define AVG_PEAK_TOL     0.2    // dB, Welch segments against a single segment
+
+/* Stand-ins for the FPGA module, the full 125 MS/s range in MHz */
+float g_spectr_fpga_adc_max_v = 1.0;
+const int c_spectr_fpga_adc_bits = 14;
+float spectr_get_fpga_smpl_freq() { return 125e6; }
+int spectr_fpga_cnv_freq_range_to_dec(int freq_range) { return 1; }
+int spectr_fpga_cnv_freq_range_to_unit(int freq_range) { return 2; }
+
+typedef struct {
+    const char *name;
+    double freq_a[2], amp_a[2];  // relative to the sampling rate and to full scale
+    double freq_b[2], amp_b[2];
+    double noise;                // rms, counts
+    int start;                   // ring position of the oldest sample
+} ref_signal_t;
+
+static const ref_signal_t signals[] = {
+    { "tones",        { 0.1234, 0 },     { 0.5, 0 },    { 0.0311, 0 },   { 0.9, 0 },      0.5,    0 },
+    { "tones wrap",   { 0.1234, 0 },     { 0.5, 0 },    { 0.0311, 0 },   { 0.9, 0 },      0.5, 9731 },
+    { "two tones",    { 0.2, 0.2017 },   { 0.4, 0.01 }, { 0.01, 0.4 },   { 0.3, 1e-3 },   2,   4097 },
+    { "noise floor",  { 0.3, 0 },        { 1e-4, 0 },   { 0.45, 0 },     { 0, 0 },        20,   123 },
+    { "low level",    { 0.0007, 0 },     { 1e-3, 0 },   { 0.49, 0 },     { 1e-3, 0 },     1,  16383 },
+};
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double gauss()
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/* 14 bit two's complement counts, as the FPGA buffers hold them, written to the
+ * ring so the frame begins at start */
+static void generate(const double *freq, const double *amp, double noise, int start, int *raw)
+{
+    for (int i = 0; i < N; ++i) {
+        double v = gauss() * noise;
+        for (int k = 0; k < 2; ++k) {
+            v += amp[k] * 8191 * sin(2 * M_PI * freq[k] * i + k);
+        }
+        int c = (int) lrint(v);
+        c = c > 8191 ? 8191 : (c < -8192 ? -8192 : c);
+        raw[(start + i) % N] = c & 0x3fff;
+    }
+}
+
+/*
+ * Previous processing chain, double precision kiss_fft
+ */
+
+static double *ref_window;
+static double *ref_a, *ref_b, *ref_fft_a, *ref_fft_b;
+static kiss_fft_cpx *ref_out1, *ref_out2;
+static kiss_fftr_cfg ref_cfg;
+
+static void referenceInit()
+{
+    ref_window = malloc(N * sizeof(double));
+    ref_a = malloc(N * sizeof(double));
+    ref_b = malloc(N * sizeof(double));
+    ref_fft_a = malloc(c_dsp_sig_len * sizeof(double));
+    ref_fft_b = malloc(c_dsp_sig_len * sizeof(double));
+    ref_out1 = malloc(N * sizeof(kiss_fft_cpx));
+    ref_out2 = malloc(N * sizeof(kiss_fft_cpx));
+    ref_cfg = kiss_fftr_alloc(N, 0, NULL, NULL);
+    for (int i = 0; i < N; i++) {
+        ref_window[i] = RP_SPECTR_HANN_AMP * (1 - cos(2*M_PI*i / (double)(N-1)));
+    }
+}
+
+static void referenceRelease()
+{
+    free(ref_window);
+    free(ref_a);
+    free(ref_b);
+    free(ref_fft_a);
+    free(ref_fft_b);
+    free(ref_out1);
+    free(ref_out2);
+    free(ref_cfg);
+}
+
+static void reference(const int *raw_a, const int *raw_b, int start, float *out_a, float *out_b,
+                      float *peak_pw_a, float *peak_freq_a, float *peak_pw_b, float *peak_freq_b)
+{
+    int i, k;
+
+    /* ring copy converted to signed, as the former spectr_fpga_get_signal() */
+    for (i = 0; i < N; i++) {
+        ref_a[i] = raw_a[(start + i) % N];
+        ref_b[i] = raw_b[(start + i) % N];
+        if (ref_a[i] > (double)(1<<13))
+            ref_a[i] -= (double)(1<<14);
+        if (ref_b[i] > (double)(1<<13))
+            ref_b[i] -= (double)(1<<14);
+    }
+
+    /* rp_spectr_hann_filter() */
+    for (i = 0; i < N; i++) {
+        ref_a[i] = ref_a[i] * ref_window[i];
+        ref_b[i] = ref_b[i] * ref_window[i];
+    }
+
+    /* rp_spectr_fft() */
+    kiss_fftr(ref_cfg, (kiss_fft_scalar *)ref_a, ref_out1);
+    kiss_fftr(ref_cfg, (kiss_fft_scalar *)ref_b, ref_out2);
+    for (i = 0; i < c_dsp_sig_len; i++) {
+        ref_fft_a[i] = sqrt(pow(ref_out1[i].r, 2) + pow(ref_out1[i].i, 2));
+        ref_fft_b[i] = sqrt(pow(ref_out2[i].r, 2) + pow(ref_out2[i].i, 2));
+    }
+
+    /* rp_spectr_decimate() */
+    int step = (int)round((float)c_dsp_sig_len / (float)SPECTR_OUT_SIG_LEN);
+    for (i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
+        double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
+        out_a[i] = 0;
+        out_b[i] = 0;
+        for (k = i * step; k < (i + 1) * step; k++) {
+            out_a[i] += (float)(pow(ref_fft_a[k] * c2v, 2) / 50 / (double)N / (double)N * 2);
+            out_b[i] += (float)(pow(ref_fft_b[k] * c2v, 2) / 50 / (double)N / (double)N * 2);
+        }
+    }
+
+    /* rp_spectr_cnv_to_dBm() */
+    double max_pw_a = -1e5, max_pw_b = -1e5;
+    int idx_a = 0, idx_b = 0;
+    for (i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
+        double pa = out_a[i], pb = out_b[i];
+        out_a[i] = (pa * 1000 > 1.0e-12) ? 10 * log10(pa * 1000) : 10 * log10(1.0e-12);
+        out_b[i] = (pb * 1000 > 1.0e-12) ? 10 * log10(pb * 1000) : 10 * log10(1.0e-12);
+        if (i < 2) {
+            out_a[i] = -80.0;
+            out_b[i] = -80.0;
+        }
+        if (out_a[i] > max_pw_a) {
+            max_pw_a = out_a[i];
+            idx_a = i;
+        }
+        if (out_b[i] > max_pw_b) {
+            max_pw_b = out_b[i];
+            idx_b = i;
+        }
+    }
+    float pwr_a = 0, pwr_b = 0;
+    for (i = -3; i <= 3; i++) {
+        if (idx_a + i >= 0 && idx_a + i < SPECTR_OUT_SIG_LEN)
+            pwr_a += pow(10.0, out_a[idx_a + i] / 10.0);
+        if (idx_b + i >= 0 && idx_b + i < SPECTR_OUT_SIG_LEN)
+            pwr_b += pow(10.0, out_b[idx_b + i] / 10.0);
+    }
+    *peak_pw_a = (pwr_a <= 1.0e-10) ? -200.0 : 10.0 * log10(pwr_a);
+    *peak_pw_b = (pwr_b <= 1.0e-10) ? -200.0 : 10.0 * log10(pwr_b);
+    *peak_freq_a = ((float)idx_a / (float)SPECTR_OUT_SIG_LEN * spectr_get_fpga_smpl_freq() / 2) / 1e6;
+    *peak_freq_b = ((float)idx_b / (float)SPECTR_OUT_SIG_LEN * spectr_get_fpga_smpl_freq() / 2) / 1e6;
+}
+
+/* Largest difference over the bins within DB_RANGE of the reference peak */
+static double compare(const float *ref, const float *res)
+{
+    float peak = -1e9;
+    double err = 0;
+    for (int i = 0; i < SPECTR_OUT_SIG_LEN; ++i) {
+        peak = ref[i] > peak ? ref[i] : peak;
+    }
+    for (int i = 0; i < SPECTR_OUT_SIG_LEN; ++i) {
+        if (ref[i] > peak - DB_RANGE) {
+            double e = fabs(ref[i] - res[i]);
+            err = e > err ? e : err;
+        }
+    }
+    return err;
+}
+
+/* Standard deviation in dB of the noise only bins */
+static double floorSpread(const float *db)
+{
+    double sum = 0, sum2 = 0;
+    int n = 0;
+    for (int i = SPECTR_OUT_SIG_LEN / 16; i < SPECTR_OUT_SIG_LEN - 16; ++i, ++n) {
+        sum += db[i];
+        sum2 += db[i] * db[i];
+    }
+    return sqrt(sum2 / n - (sum / n) * (sum / n));
+}
+
+/* Runs AVG_FRAMES fresh noisy frames, channel A a tone and channel B noise only,
+ * returns the last spectra and the time per frame */
+static double averaged(int segments, rp_spectr_avg_mode_t mode, int count,
+                       float *out_a, float *out_b, float *peak_a)
+{
+    static int raw_a[N], raw_b[N];
+    const double tone[2] = { 0.1234, 0 }, amp[2] = { 0.5, 0 }, none[2] = { 0, 0 };
+    float f_a, p_b, f_b;
+    double t = 0;
+
+    rp_spectr_set_welch(segments);
+    rp_spectr_set_avg(mode, count);
+    for (int k = 0; k < AVG_FRAMES; ++k) {
+        generate(tone, amp, 20, 0, raw_a);
+        generate(tone, none, 20, 0, raw_b);
+        double start = now_s();
+        rp_spectr_process(raw_a, raw_b, 0, out_a, out_b, NULL, NULL, peak_a, &f_a, &p_b, &f_b, 0);
+        t += now_s() - start;
+    }
+    return t / AVG_FRAMES * 1e3;
+}
+
+static int checkAveraging()
+{
+    static float a[SPECTR_OUT_SIG_LEN], b[SPECTR_OUT_SIG_LEN];
+    static float max_a[SPECTR_OUT_SIG_LEN], max_b[SPECTR_OUT_SIG_LEN];
+    static float min_a[SPECTR_OUT_SIG_LEN], min_b[SPECTR_OUT_SIG_LEN];
+    static const struct { int segments; rp_spectr_avg_mode_t mode; int count; } cases[] = {
+        { 1, rp_spectr_avg_linear, 1 }, { 3, rp_spectr_avg_linear, 1 }, { 7, rp_spectr_avg_linear, 1 },
+        { 1, rp_spectr_avg_linear, 8 }, { 7, rp_spectr_avg_exp, 16 },
+    };
+    int failed = 0;
+    float single_peak = 0, single_spread = 0;
+
+    printf("%-14s %9s %9s %9s %9s\n", "averaging", "segments", "peak", "floor dB", "ms");
+    for (int k = 0; k < sizeof(cases) / sizeof(cases[0]); ++k) {
+        float peak;
+        double t = averaged(cases[k].segments, cases[k].mode, cases[k].count, a, b, &peak);
+        double spread = floorSpread(b);
+        bool ok = true;
+
+        if (k == 0) {
+            single_peak = peak;
+            single_spread = spread;
+        } else {
+            ok = fabs(peak - single_peak) <= AVG_PEAK_TOL && spread < single_spread;
+        }
+        /* spectra since the settings changed stay within the holds */
+        rp_spectr_get_hold(max_a, max_b, min_a, min_b);
+        for (int i = 0; i < SPECTR_OUT_SIG_LEN; ++i) {
+            ok = ok && min_a[i] <= a[i] && a[i] <= max_a[i] && min_b[i] <= b[i] && b[i] <= max_b[i];
+        }
+        failed += !ok;
+        printf("%-14s %9d %9.3f %9.2f %9.2f%s\n",
+               cases[k].count == 1 ? "off" : (cases[k].mode == rp_spectr_avg_exp ? "exponential" : "linear"),
+               cases[k].segments, peak, spread, t, ok ? "" : "  FAIL");
+    }
+
+    rp_spectr_set_welch(1);
+    rp_spectr_set_avg(rp_spectr_avg_linear, 1);
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    static int raw_a[N], raw_b[N];
+    static float ref_a_db[SPECTR_OUT_SIG_LEN], ref_b_db[SPECTR_OUT_SIG_LEN];
+    static float new_a_db[SPECTR_OUT_SIG_LEN], new_b_db[SPECTR_OUT_SIG_LEN];
+    static double amp_a[c_dsp_sig_len], amp_b[c_dsp_sig_len];
+    int failed = 0;
+    double ref_time = 0, new_time = 0;
+
+    referenceInit();
+    if (rp_spectr_hann_init() < 0 || rp_spectr_fft_init() < 0) {
+        printf("initialization failed\n");
+        return 1;
+    }
+
+    printf("%d samples, both channels\n", N);
+    printf("%-14s %9s %9s %9s %9s %9s %9s\n", "signal", "ref peak", "new peak", "max dB", "ref ms", "new ms", "+wf ms");
+    for (int k = 0; k < sizeof(signals) / sizeof(signals[0]); ++k) {
+        const ref_signal_t *s = &signals[k];
+        float rp_a, rf_a, rp_b, rf_b, np_a, nf_a, np_b, nf_b;
+        generate(s->freq_a, s->amp_a, s->noise, s->start, raw_a);
+        generate(s->freq_b, s->amp_b, s->noise, s->start, raw_b);
+
+        reference(raw_a, raw_b, s->start, ref_a_db, ref_b_db, &rp_a, &rf_a, &rp_b, &rf_b);
+        rp_spectr_process(raw_a, raw_b, s->start, new_a_db, new_b_db, NULL, NULL,
+                          &np_a, &nf_a, &np_b, &nf_b, 0);
+
+        double err = fmax(compare(ref_a_db, new_a_db), compare(ref_b_db, new_b_db));
+        bool ok = err <= DB_TOLERANCE && rf_a == nf_a && rf_b == nf_b &&
+                  fabs(rp_a - np_a) <= PEAK_TOLERANCE && fabs(rp_b - np_b) <= PEAK_TOLERANCE;
+        failed += !ok;
+
+        int n = 0;
+        double start = now_s(), t_ref, t_new, t_wf;
+        do {
+            reference(raw_a, raw_b, s->start, ref_a_db, ref_b_db, &rp_a, &rf_a, &rp_b, &rf_b);
+            ++n;
+        } while ((t_ref = now_s() - start) < BENCH_TIME_S);
+        t_ref = t_ref / n * 1e3;
+
+        n = 0;
+        start = now_s();
+        do {
+            rp_spectr_process(raw_a, raw_b, s->start, new_a_db, new_b_db, NULL, NULL,
+                              &np_a, &nf_a, &np_b, &nf_b, 0);
+            ++n;
+        } while ((t_new = now_s() - start) < BENCH_TIME_S);
+        t_new = t_new / n * 1e3;
+
+        /* with the FFT amplitudes for the waterfall */
+        n = 0;
+        start = now_s();
+        do {
+            rp_spectr_process(raw_a, raw_b, s->start, new_a_db, new_b_db, amp_a, amp_b,
+                              &np_a, &nf_a, &np_b, &nf_b, 0);
+            ++n;
+        } while ((t_wf = now_s() - start) < BENCH_TIME_S);
+        t_wf = t_wf / n * 1e3;
+
+        ref_time += t_ref;
+        new_time += t_new;
+        printf("%-14s %9.3f %9.3f %9.2g %9.2f %9.2f %9.2f%s\n", s->name, rp_a, np_a, err,
+               t_ref, t_new, t_wf, ok ? "" : "  FAIL");
+    }
+    printf("total: reference %.1f ms, new %.1f ms, speedup %.1fx\n", ref_time, new_time, ref_time / new_time);
+
+    failed += checkAveraging();
+
+    rp_spectr_fft_clean();
+    rp_spectr_hann_clean();
+    referenceRelease();
+    if (failed) {
+        printf("%d check(s) failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
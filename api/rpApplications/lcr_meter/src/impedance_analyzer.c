@@ -136,15 +136,11 @@ int imp_SafeThreadAcqData(rp_channel_t channel,
 
 	pthread_mutex_lock(&mutex);	
 	
-	rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
-	
 	ECHECK_APP(rp_AcqSetDecimation(decimation));
 	ECHECK_APP(rp_AcqSetTriggerSrc(RP_TRIG_SRC_CHA_PE));
 	ECHECK_APP(rp_AcqStart());
 
-	while(state == RP_TRIG_STATE_WAITING){
-		ECHECK_APP(rp_AcqGetTriggerState(&state));
-	}
+	ECHECK_APP(rp_AcqWaitTrigger(-1));
 
 	ECHECK_APP(rp_AcqGetOldestDataV(channel, &acq_size, data));
 	pthread_mutex_unlock(&mutex);
@@ -14,6 +14,10 @@
 
 
 #include <math.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #include "common.h"
 
 
@@ -42,4 +46,77 @@ int64_t timeToIndex(float time) {
     float samplingRate;
     ECHECK_APP(rp_AcqGetSamplingRateHz(&samplingRate));
     return (int64_t) round(samplingRate * time / 1000.0);
-}
\ No newline at end of file
+}
+
+// Minimum and maximum of data[0..size-1], size must be at least 1
+void cmn_MinMax(const float* data, uint32_t size, float* min, float* max) {
+    float lo = data[0], hi = data[0];
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (size >= 4) {
+        float32x4_t v_lo = vld1q_f32(data);
+        float32x4_t v_hi = v_lo;
+        for (i = 4; i + 4 <= size; i += 4) {
+            float32x4_t v = vld1q_f32(&data[i]);
+            v_lo = vminq_f32(v_lo, v);
+            v_hi = vmaxq_f32(v_hi, v);
+        }
+        float32x2_t p_lo = vpmin_f32(vget_low_f32(v_lo), vget_high_f32(v_lo));
+        float32x2_t p_hi = vpmax_f32(vget_low_f32(v_hi), vget_high_f32(v_hi));
+        lo = vget_lane_f32(vpmin_f32(p_lo, p_lo), 0);
+        hi = vget_lane_f32(vpmax_f32(p_hi, p_hi), 0);
+    }
+#endif
+
+    for (; i < size; ++i) {
+        lo = data[i] < lo ? data[i] : lo;
+        hi = data[i] > hi ? data[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+// Min/max pyramid of data[0..size-1]: level k >= 1 holds the extremes of the aligned
+// blocks of 2^k samples and starts right after level k-1, in total less than size entries
+void cmn_PyramidBuild(const float* data, uint32_t size, float* min, float* max) {
+    const float *lo = data, *hi = data;
+    for (uint32_t n = size >> 1; n > 0; n >>= 1) {
+        for (uint32_t b = 0; b < n; ++b) {
+            min[b] = lo[2*b] < lo[2*b + 1] ? lo[2*b] : lo[2*b + 1];
+            max[b] = hi[2*b] > hi[2*b + 1] ? hi[2*b] : hi[2*b + 1];
+        }
+        lo = min;
+        hi = max;
+        min += n;
+        max += n;
+    }
+}
+
+// Minimum and maximum of data[from..to-1] from its pyramid, from < to <= size
+void cmn_PyramidMinMax(const float* data, const float* pmin, const float* pmax, uint32_t size,
+                       uint32_t from, uint32_t to, float* min, float* max) {
+    const float *lmin = data, *lmax = data;
+    float lo = data[from], hi = data[from];
+    uint32_t base = 0;
+
+    for (uint32_t k = 1; from < to; ++k) {
+        if (from & 1) {
+            lo = lmin[from] < lo ? lmin[from] : lo;
+            hi = lmax[from] > hi ? lmax[from] : hi;
+            ++from;
+        }
+        if (to & 1) {
+            --to;
+            lo = lmin[to] < lo ? lmin[to] : lo;
+            hi = lmax[to] > hi ? lmax[to] : hi;
+        }
+        from >>= 1;
+        to >>= 1;
+        lmin = pmin + base;
+        lmax = pmax + base;
+        base += size >> k;
+    }
+    *min = lo;
+    *max = hi;
+}
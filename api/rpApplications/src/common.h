@@ -93,4 +93,9 @@ int intCmp(const void *a, const void *b);
 float indexToTime(int64_t index);
 int64_t timeToIndex(float time);
 
+void cmn_MinMax(const float* data, uint32_t size, float* min, float* max);
+void cmn_PyramidBuild(const float* data, uint32_t size, float* min, float* max);
+void cmn_PyramidMinMax(const float* data, const float* pmin, const float* pmax, uint32_t size,
+                       uint32_t from, uint32_t to, float* min, float* max);
+
 #endif /* COMMON_APP_H_ */
@@ -0,0 +1,94 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library view interpolation implementation
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#include <math.h>
+#include <pthread.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "interp.h"
+
+#define HALF_TAPS                     (INTERP_TAPS / 2)
+
+/* Polyphase table of the Blackman windowed sinc. Row p weights the samples n-7 .. n+8
+ * around a point at n + p/INTERP_PHASES, the extra last row is the next sample itself
+ * so rounding the phase up never has to carry into n. */
+static float sinc_table[INTERP_PHASES + 1][INTERP_TAPS] __attribute__((aligned(16)));
+static pthread_once_t sinc_once = PTHREAD_ONCE_INIT;
+
+static void buildTable() {
+    for (int p = 0; p <= INTERP_PHASES; ++p) {
+        float frac = (float) p / INTERP_PHASES;
+        float sum = 0;
+        for (int k = 0; k < INTERP_TAPS; ++k) {
+            double t = k - (HALF_TAPS - 1) - frac;
+            double s = (t == 0) ? 1 : sin(M_PI * t) / (M_PI * t);
+            double w = 0.42 + 0.5 * cos(M_PI * t / HALF_TAPS) + 0.08 * cos(2 * M_PI * t / HALF_TAPS);
+            sinc_table[p][k] = (float) (s * w);
+            sum += sinc_table[p][k];
+        }
+        // unity gain at DC for every phase, otherwise a flat trace ripples with the phase
+        for (int k = 0; k < INTERP_TAPS; ++k) {
+            sinc_table[p][k] /= sum;
+        }
+    }
+}
+
+static inline float dot(const float *x, const float *h) {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t acc = vmulq_f32(vld1q_f32(x), vld1q_f32(h));
+    for (int k = 4; k < INTERP_TAPS; k += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(&x[k]), vld1q_f32(&h[k]));
+    }
+    float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#else
+    // four partial sums, the same association the NEON path uses
+    float acc[4] = {0, 0, 0, 0};
+    for (int k = 0; k < INTERP_TAPS; k += 4) {
+        acc[0] += x[k] * h[k];
+        acc[1] += x[k + 1] * h[k + 1];
+        acc[2] += x[k + 2] * h[k + 2];
+        acc[3] += x[k + 3] * h[k + 3];
+    }
+    return (acc[0] + acc[2]) + (acc[1] + acc[3]);
+#endif
+}
+
+/* Band-limited value of src at x0 + i*delta for i in [first, last), written to dst[i] as
+ * value*gain + offset. The coefficient row is picked per point from the sub-sample
+ * position, so any delta below one sample per point reuses the same table. Taps falling
+ * outside the capture repeat its edge samples. */
+void interp_Sinc(const float *src, uint32_t size, float x0, float delta, int first, int last, float gain, float offset, float *dst) {
+    pthread_once(&sinc_once, buildTable);
+
+    float edge[INTERP_TAPS];
+    for (int i = first; i < last; ++i) {
+        float x = x0 + (float)i * delta;
+        int n = (int) x;
+        int p = (int) ((x - (float)n) * INTERP_PHASES + 0.5f);
+        int base = n - (HALF_TAPS - 1);
+        const float *taps = &src[base];
+
+        if (base < 0 || base + INTERP_TAPS > (int) size) {
+            for (int k = 0; k < INTERP_TAPS; ++k) {
+                int j = base + k;
+                edge[k] = src[j < 0 ? 0 : (j >= (int) size ? (int) size - 1 : j)];
+            }
+            taps = edge;
+        }
+        dst[i] = dot(taps, sinc_table[p]) * gain + offset;
+    }
+}
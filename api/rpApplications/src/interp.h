@@ -0,0 +1,25 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library view interpolation interface
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#ifndef __INTERP_H
+#define __INTERP_H
+
+#include <stdint.h>
+
+#define INTERP_TAPS                   16     // samples weighted per view point, multiple of 4
+#define INTERP_PHASES                 256    // sub-sample positions of the coefficient table
+
+void interp_Sinc(const float *src, uint32_t size, float x0, float delta, int first, int last, float gain, float offset, float *dst);
+
+#endif /* __INTERP_H */
@@ -0,0 +1,244 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library math channel kernels implementation
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "kiss_fftr.h"
+#include "mathop.h"
+
+// Cached FFT plan, Hann window and work buffers of the FFT magnitude operation
+static kiss_fftr_cfg fft_cfg = NULL;
+static kiss_fft_scalar *fft_buf = NULL;
+static kiss_fft_cpx *fft_spec = NULL;
+static float *fft_win = NULL;
+static float fft_win_sum = 0;
+static uint32_t fft_size = 0, win_size = 0;
+static pthread_mutex_t fft_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Binary operations, one kernel per operation so the loops carry no dispatch
+ */
+
+// (x*a1 + b1) + (y*a2 + b2), folded into x*p + y*q + s
+static void addKernel(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k, float sign) {
+    const float p = k->c * k->a1, q = sign * k->c * k->a2, s = k->c * (k->b1 + sign * k->b2) + k->d;
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t v_p = vdupq_n_f32(p), v_q = vdupq_n_f32(q), v_s = vdupq_n_f32(s);
+    for (; i + 4 <= size; i += 4) {
+        float32x4_t v = vmlaq_f32(v_s, vld1q_f32(&x[i]), v_p);
+        vst1q_f32(&out[i], vmlaq_f32(v, vld1q_f32(&y[i]), v_q));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        out[i] = x[i] * p + y[i] * q + s;
+    }
+}
+
+static void mathAdd(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k) {
+    addKernel(x, y, out, size, k, 1.f);
+}
+
+static void mathSub(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k) {
+    addKernel(x, y, out, size, k, -1.f);
+}
+
+static void mathMul(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k) {
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t a1 = vdupq_n_f32(k->a1), b1 = vdupq_n_f32(k->b1);
+    const float32x4_t a2 = vdupq_n_f32(k->a2), b2 = vdupq_n_f32(k->b2);
+    const float32x4_t c = vdupq_n_f32(k->c), d = vdupq_n_f32(k->d);
+    for (; i + 4 <= size; i += 4) {
+        float32x4_t u = vmlaq_f32(b1, vld1q_f32(&x[i]), a1);
+        float32x4_t w = vmlaq_f32(b2, vld1q_f32(&y[i]), a2);
+        vst1q_f32(&out[i], vmlaq_f32(d, vmulq_f32(u, w), c));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        out[i] = (x[i] * k->a1 + k->b1) * (y[i] * k->a2 + k->b2) * k->c + k->d;
+    }
+}
+
+// Armv7 NEON has no exact division, this one stays scalar
+static void mathDiv(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k) {
+    for (uint32_t i = 0; i < size; ++i) {
+        float v1 = x[i] * k->a1 + k->b1;
+        float v2 = y[i] * k->a2 + k->b2;
+        float r = (v2 != 0) ? v1 / v2 : (v1 > 0 ? MATHOP_DIV_ZERO : -MATHOP_DIV_ZERO);
+        out[i] = r * k->c + k->d;
+    }
+}
+
+static void mathAbs(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k) {
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t a1 = vdupq_n_f32(k->a1), b1 = vdupq_n_f32(k->b1);
+    const float32x4_t c = vdupq_n_f32(k->c), d = vdupq_n_f32(k->d);
+    for (; i + 4 <= size; i += 4) {
+        float32x4_t u = vabsq_f32(vmlaq_f32(b1, vld1q_f32(&x[i]), a1));
+        vst1q_f32(&out[i], vmlaq_f32(d, u, c));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        out[i] = fabsf(x[i] * k->a1 + k->b1) * k->c + k->d;
+    }
+}
+
+/* Kernel of a two operand operation (ABS ignores y), NULL for the others */
+mop_binary_fn mop_SelectBinary(rpApp_osc_math_oper_t op) {
+    switch (op) {
+        case RPAPP_OSC_MATH_ADD:
+            return mathAdd;
+        case RPAPP_OSC_MATH_SUB:
+            return mathSub;
+        case RPAPP_OSC_MATH_MUL:
+            return mathMul;
+        case RPAPP_OSC_MATH_DIV:
+            return mathDiv;
+        case RPAPP_OSC_MATH_ABS:
+            return mathAbs;
+        default:
+            return NULL;
+    }
+}
+
+/* Forward difference of x*a1 + b1 over dt, the last point repeats the one before */
+void mop_Derivative(const float *x, float *out, uint32_t size, const mop_coef_t *k, float dt) {
+    if (size < 2) {
+        if (size == 1) {
+            out[0] = k->d;
+        }
+        return;
+    }
+
+    const float g = k->c * k->a1 / dt;
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t v_g = vdupq_n_f32(g), v_d = vdupq_n_f32(k->d);
+    for (; i + 5 <= size; i += 4) {
+        float32x4_t diff = vsubq_f32(vld1q_f32(&x[i + 1]), vld1q_f32(&x[i]));
+        vst1q_f32(&out[i], vmlaq_f32(v_d, diff, v_g));
+    }
+#endif
+
+    for (; i < size - 1; ++i) {
+        out[i] = (x[i + 1] - x[i]) * g + k->d;
+    }
+    out[size - 1] = out[size - 2];
+}
+
+/* Running sum of (x*a1 + b1)*dt, a prefix sum does not vectorize */
+void mop_Integral(const float *x, float *out, uint32_t size, const mop_coef_t *k, float dt) {
+    const float g = k->a1 * dt, h = k->b1 * dt;
+    float acc = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        acc += x[i] * g + h;
+        out[i] = acc * k->c + k->d;
+    }
+}
+
+static void releaseFft() {
+    kiss_fftr_free(fft_cfg);
+    free(fft_buf);
+    free(fft_spec);
+    free(fft_win);
+    fft_cfg = NULL;
+    fft_buf = NULL;
+    fft_win = NULL;
+    fft_spec = NULL;
+    fft_size = win_size = 0;
+}
+
+/* Amplitude spectrum of x*a1 + b1 in volts, Hann windowed and zero padded to a power
+ * of two. The bins from DC to half the view sample rate are spread over the size
+ * output points, each point shows the largest bin it covers. */
+int mop_FftMagnitude(const float *x, float *out, uint32_t size, const mop_coef_t *k) {
+    if (size < 2) {
+        if (size == 1) {
+            out[0] = k->d;
+        }
+        return RP_OK;
+    }
+
+    uint32_t nfft = 2;
+    while (nfft < size) {
+        nfft <<= 1;
+    }
+
+    pthread_mutex_lock(&fft_mutex);
+    if (fft_size != nfft) {
+        releaseFft();
+        fft_cfg = kiss_fftr_alloc(nfft, 0, NULL, NULL);
+        fft_buf = malloc(nfft * sizeof(kiss_fft_scalar));
+        fft_spec = malloc((nfft / 2 + 1) * sizeof(kiss_fft_cpx));
+        fft_win = malloc(nfft * sizeof(float));
+        if (fft_cfg == NULL || fft_buf == NULL || fft_spec == NULL || fft_win == NULL) {
+            releaseFft();
+            pthread_mutex_unlock(&fft_mutex);
+            return RP_EAA;
+        }
+        fft_size = nfft;
+    }
+    if (win_size != size) {
+        fft_win_sum = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+            fft_win[i] = 0.5f - 0.5f * cosf(2.f * (float) M_PI * i / (size - 1));
+            fft_win_sum += fft_win[i];
+        }
+        win_size = size;
+    }
+
+    for (uint32_t i = 0; i < size; ++i) {
+        fft_buf[i] = (x[i] * k->a1 + k->b1) * fft_win[i];
+    }
+    for (uint32_t i = size; i < nfft; ++i) {
+        fft_buf[i] = 0;
+    }
+    kiss_fftr(fft_cfg, fft_buf, fft_spec);
+
+    const uint32_t bins = nfft / 2 + 1;
+    const float scale = 2.f / fft_win_sum;
+    for (uint32_t j = 0; j < size; ++j) {
+        uint32_t b0 = (uint64_t) j * bins / size;
+        uint32_t b1 = (uint64_t) (j + 1) * bins / size;
+        float peak = 0;
+        for (uint32_t b = b0; b < b1 || b == b0; ++b) {
+            float p = fft_spec[b].r * fft_spec[b].r + fft_spec[b].i * fft_spec[b].i;
+            peak = p > peak ? p : peak;
+        }
+        // DC has no mirror image, its amplitude is not doubled
+        out[j] = sqrtf(peak) * (b0 == 0 ? scale / 2.f : scale) * k->c + k->d;
+    }
+    pthread_mutex_unlock(&fft_mutex);
+    return RP_OK;
+}
+
+void mop_Release() {
+    pthread_mutex_lock(&fft_mutex);
+    releaseFft();
+    pthread_mutex_unlock(&fft_mutex);
+}
@@ -0,0 +1,40 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library math channel kernels interface
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#ifndef __MATHOP_H
+#define __MATHOP_H
+
+#include <float.h>
+#include <stdint.h>
+#include "rpApp.h"
+
+#define MATHOP_DIV_ZERO               (FLT_MAX * 0.9f)  // quotient shown for a zero divisor
+
+/* Math channel scaling folded once per frame: the operands are x*a1 + b1 and
+ * y*a2 + b2 in volts, the result r is written as r*c + d in math view units */
+typedef struct {
+    float a1, b1;
+    float a2, b2;
+    float c, d;
+} mop_coef_t;
+
+typedef void (*mop_binary_fn)(const float *x, const float *y, float *out, uint32_t size, const mop_coef_t *k);
+
+mop_binary_fn mop_SelectBinary(rpApp_osc_math_oper_t op);
+void mop_Derivative(const float *x, float *out, uint32_t size, const mop_coef_t *k, float dt);
+void mop_Integral(const float *x, float *out, uint32_t size, const mop_coef_t *k, float dt);
+int mop_FftMagnitude(const float *x, float *out, uint32_t size, const mop_coef_t *k);
+void mop_Release();
+
+#endif /* __MATHOP_H */
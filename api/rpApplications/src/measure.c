@@ -0,0 +1,432 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library signal measurement module implementation
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "kiss_fftr.h"
+#include "measure.h"
+#include "osciloscopeApp.h"
+#include "common.h"
+#include "../../rpbase/src/common.h"
+
+// Cached real FFT plans for the autocorrelation, shared by all callers
+static kiss_fftr_cfg fwd_cfg = NULL;
+static kiss_fftr_cfg inv_cfg = NULL;
+static uint32_t plan_size = 0;
+static pthread_mutex_t plan_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void releasePlans() {
+    kiss_fftr_free(fwd_cfg);
+    kiss_fftr_free(inv_cfg);
+    fwd_cfg = inv_cfg = NULL;
+    plan_size = 0;
+}
+
+/* All scalar measurements of a trace: extremes and moments in a single pass, then the
+ * points above mean are counted. Moments are taken about the first point, so a trace
+ * with a large offset keeps its variance. The first pass processes four points per
+ * iteration, explicitly on NEON capable targets. */
+void meas_Frame(const float *data, uint32_t size, meas_frame_t *res) {
+    res->size = size;
+    if (size == 0) {
+        res->min = res->max = res->mean = res->var = res->duty = 0;
+        return;
+    }
+
+    const float shift = data[0];
+    float lo = data[0], hi = data[0];
+    double sum = 0, sum_sq = 0;
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (size >= 4) {
+        const float32x4_t v_shift = vdupq_n_f32(shift);
+        float32x4_t v_lo = vld1q_f32(data);
+        float32x4_t v_hi = v_lo;
+        float32x4_t v_sum = vdupq_n_f32(0);
+        float32x4_t v_sum_sq = vdupq_n_f32(0);
+        for (; i + 4 <= size; i += 4) {
+            float32x4_t v = vld1q_f32(&data[i]);
+            float32x4_t d = vsubq_f32(v, v_shift);
+            v_lo = vminq_f32(v_lo, v);
+            v_hi = vmaxq_f32(v_hi, v);
+            v_sum = vaddq_f32(v_sum, d);
+            v_sum_sq = vmlaq_f32(v_sum_sq, d, d);
+        }
+        float32x2_t p_lo = vpmin_f32(vget_low_f32(v_lo), vget_high_f32(v_lo));
+        float32x2_t p_hi = vpmax_f32(vget_low_f32(v_hi), vget_high_f32(v_hi));
+        lo = vget_lane_f32(vpmin_f32(p_lo, p_lo), 0);
+        hi = vget_lane_f32(vpmax_f32(p_hi, p_hi), 0);
+        sum = (double)vgetq_lane_f32(v_sum, 0) + vgetq_lane_f32(v_sum, 1) + vgetq_lane_f32(v_sum, 2) + vgetq_lane_f32(v_sum, 3);
+        sum_sq = (double)vgetq_lane_f32(v_sum_sq, 0) + vgetq_lane_f32(v_sum_sq, 1) + vgetq_lane_f32(v_sum_sq, 2) + vgetq_lane_f32(v_sum_sq, 3);
+    }
+#else
+    // four independent lanes, so the compiler can keep them in one vector register each
+    if (size >= 4) {
+        float l_lo[4], l_hi[4], l_sum[4] = { 0 }, l_sum_sq[4] = { 0 };
+        for (int k = 0; k < 4; ++k) {
+            l_lo[k] = l_hi[k] = data[k];
+        }
+        for (; i + 4 <= size; i += 4) {
+            for (int k = 0; k < 4; ++k) {
+                float v = data[i + k];
+                float d = v - shift;
+                l_lo[k] = v < l_lo[k] ? v : l_lo[k];
+                l_hi[k] = v > l_hi[k] ? v : l_hi[k];
+                l_sum[k] += d;
+                l_sum_sq[k] += d * d;
+            }
+        }
+        for (int k = 0; k < 4; ++k) {
+            lo = MIN(lo, l_lo[k]);
+            hi = MAX(hi, l_hi[k]);
+            sum += l_sum[k];
+            sum_sq += l_sum_sq[k];
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        float d = data[i] - shift;
+        lo = data[i] < lo ? data[i] : lo;
+        hi = data[i] > hi ? data[i] : hi;
+        sum += d;
+        sum_sq += d * d;
+    }
+
+    double mean = sum / size;
+    res->min = lo;
+    res->max = hi;
+    res->mean = shift + mean;
+    res->var = MAX(sum_sq / size - mean * mean, 0);
+
+    uint32_t high = 0;
+    const float m = res->mean;
+    for (i = 0; i < size; ++i) {
+        high += data[i] > m;
+    }
+    res->duty = (float)high / (float)size;
+}
+
+/* Parabolic vertex of the largest of xcorr[from..to], to within the range */
+static float xcorrVertex(const float *xcorr, int from, int to) {
+    int max_idx = from;
+    for (int i = from + 1; i <= to; ++i) {
+        if (xcorr[i] > xcorr[max_idx]) {
+            max_idx = i;
+        }
+    }
+    float y0 = xcorr[max_idx - 1], y1 = xcorr[max_idx], y2 = xcorr[max_idx + 1];
+    float den = y0 - 2 * y1 + y2;
+    float shift = den < 0 ? 0.5f * (y0 - y2) / den : 0;
+    return max_idx + MAX(-0.5f, MIN(0.5f, shift));
+}
+
+/* Period from the autocorrelation peaks. The lag 0 lobe ends where the correlation
+ * first turns negative; the period peak is the first run of lags after it above
+ * PERIOD_PEAK_FRACTION of the highest correlation up to PERIOD_MAX_LAG of the view, so
+ * multiples of the period that come out higher on noise are not taken. The peaks at
+ * the multiples of that estimate are then located as well and the period is fitted
+ * through all of them, which averages out the noise of a single peak. Fails with
+ * RP_APP_ECP when the highest correlation is below PERIOD_EXISTS_MIN_THRESHOLD of the
+ * lag 0 energy. */
+static int xcorrPeak(const float *xcorr, int size, float *idx) {
+    const int last = MIN((int) (size * PERIOD_MAX_LAG), size - 2);
+
+    int start = 1;
+    while (start <= last && xcorr[start] > 0) {
+        ++start;
+    }
+    if (start > last) {
+        return RP_APP_ECP;
+    }
+
+    float global_max = xcorr[start];
+    for (int i = start + 1; i <= last; ++i) {
+        global_max = MAX(global_max, xcorr[i]);
+    }
+    if (global_max < xcorr[0] * PERIOD_EXISTS_MIN_THRESHOLD) {
+        return RP_APP_ECP;
+    }
+
+    const float level = global_max * PERIOD_PEAK_FRACTION;
+    int from = start;
+    while (xcorr[from] < level) {
+        ++from;
+    }
+    int to = from;
+    while (to < last && xcorr[to + 1] >= level) {
+        ++to;
+    }
+    float period = xcorrVertex(xcorr, from, to);
+
+    // least squares line through the origin and the peaks at k periods
+    double sum_kl = period, sum_kk = 1;
+    for (int k = 2; ; ++k) {
+        int lo = (int) ceilf((k - 0.25f) * period);
+        int hi = (int) floorf((k + 0.25f) * period);
+        if (hi > last || hi < lo) {
+            break;
+        }
+        float lag = xcorrVertex(xcorr, MAX(lo, 1), hi);
+        sum_kl += k * lag;
+        sum_kk += k * k;
+    }
+    *idx = sum_kl / sum_kk;
+    return RP_OK;
+}
+
+/* Period from rising zero crossings of the mean free signal. A crossing counts only
+ * after the signal went below -h and then above +h, with h = PERIOD_HYSTERESIS of half
+ * the peak to peak; its position is interpolated between the samples around zero.
+ * Fails with RP_APP_ECP when there is less than one period, or when crossing intervals
+ * differ by more than PERIOD_JITTER_MAX (noise or several crossings per period). */
+int meas_PeriodZeroCross(const float *data, uint32_t size, float *period) {
+    if (size < 2) {
+        return RP_APP_ECP;
+    }
+
+    double sum = 0;
+    for (int i = 0; i < size; ++i) {
+        sum += data[i];
+    }
+    float mean = sum / size;
+    float min, max;
+    cmn_MinMax(data, size, &min, &max);
+    float h = PERIOD_HYSTERESIS * (max - min) / 2.f;
+    if (h <= 0) {
+        return RP_APP_ECP;
+    }
+
+    bool armed = false;
+    int last_neg = -1, count = 0;
+    float first = 0, last = 0, prev = 0, min_int = 0, max_int = 0;
+    for (int i = 0; i < size; ++i) {
+        float x = data[i] - mean;
+        if (x < 0) {
+            armed |= x < -h;
+            last_neg = i;
+        } else if (armed && x >= h) {
+            float x0 = data[last_neg] - mean;
+            float x1 = data[last_neg + 1] - mean;
+            float pos = last_neg + x0 / (x0 - x1);
+            if (count == 0) {
+                first = pos;
+            } else {
+                float interval = pos - prev;
+                min_int = (count == 1) ? interval : MIN(min_int, interval);
+                max_int = (count == 1) ? interval : MAX(max_int, interval);
+            }
+            prev = last = pos;
+            ++count;
+            armed = false;
+        }
+    }
+
+    if (count < 2) {
+        return RP_APP_ECP;
+    }
+
+    float p = (last - first) / (count - 1);
+    if (max_int - min_int > PERIOD_JITTER_MAX * p) {
+        return RP_APP_ECP;
+    }
+    *period = p;
+    return RP_OK;
+}
+
+/* Amplitude histogram and rising crossings of a capture in one pass after the extremes.
+ * The crossings are taken at the middle of the extremes with the hysteresis of
+ * meas_PeriodZeroCross(), the period is their mean interval if the intervals agree
+ * within PERIOD_JITTER_MAX. The levels are read from the histogram, so spikes holding
+ * less than tail of the points do not widen the range. */
+void meas_Shape(const float *data, uint32_t size, float tail, meas_shape_t *res) {
+    res->low = res->high = res->period = 0;
+    res->crossings = 0;
+    if (size == 0) {
+        return;
+    }
+
+    float min, max;
+    cmn_MinMax(data, size, &min, &max);
+    res->low = min;
+    res->high = max;
+    if (max <= min) {
+        return;
+    }
+
+    uint32_t hist[SHAPE_HIST_BINS] = { 0 };
+    const float mid = (min + max) / 2.f;
+    const float h = PERIOD_HYSTERESIS * (max - min) / 2.f;
+    const float bin_scale = (SHAPE_HIST_BINS - 1) / (max - min);
+    bool armed = false;
+    int last_neg = -1;
+    uint32_t count = 0;
+    float first = 0, prev = 0, min_int = 0, max_int = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        float x = data[i] - mid;
+        ++hist[(uint32_t) ((data[i] - min) * bin_scale)];
+        if (x < 0) {
+            armed |= x < -h;
+            last_neg = i;
+        } else if (armed && x >= h) {
+            float x0 = data[last_neg] - mid;
+            float x1 = data[last_neg + 1] - mid;
+            float pos = last_neg + x0 / (x0 - x1);
+            if (count == 0) {
+                first = pos;
+            } else {
+                float interval = pos - prev;
+                min_int = (count == 1) ? interval : MIN(min_int, interval);
+                max_int = (count == 1) ? interval : MAX(max_int, interval);
+            }
+            prev = pos;
+            ++count;
+            armed = false;
+        }
+    }
+    res->crossings = count;
+    if (count >= 2) {
+        float p = (prev - first) / (count - 1);
+        if (max_int - min_int <= PERIOD_JITTER_MAX * p) {
+            res->period = p;
+        }
+    }
+
+    const uint32_t limit = (uint32_t) (tail * size);
+    uint32_t lo = 0, hi = SHAPE_HIST_BINS - 1, acc = hist[0];
+    while (acc <= limit && lo < hi) {
+        acc += hist[++lo];
+    }
+    acc = hist[hi];
+    while (acc <= limit && hi > lo) {
+        acc += hist[--hi];
+    }
+    res->low = min + lo / bin_scale;
+    res->high = MIN(min + (hi + 1) / bin_scale, max);
+}
+
+/* Period from the first autocorrelation peak. The biased autocorrelation is computed
+ * with zero padded real FFTs (O(n log n)) and normalized by the overlap length, the
+ * peak is picked by xcorrPeak(). Peaks below PERIOD_MIN_LAG are rejected. */
+int meas_PeriodAutocorr(const float *data, uint32_t size, float *period) {
+    if (size < 3) {
+        return RP_APP_ECP;
+    }
+
+    uint32_t nfft = 2;
+    while (nfft < 2 * size) {
+        nfft <<= 1;
+    }
+
+    double sum = 0;
+    for (int i = 0; i < size; ++i) {
+        sum += data[i];
+    }
+    float mean = sum / size;
+
+    kiss_fft_scalar *buf = malloc(nfft * sizeof(kiss_fft_scalar));
+    kiss_fft_cpx *spec = malloc((nfft / 2 + 1) * sizeof(kiss_fft_cpx));
+    float *xcorr = malloc(size * sizeof(float));
+    if (buf == NULL || spec == NULL || xcorr == NULL) {
+        free(buf);
+        free(spec);
+        free(xcorr);
+        return RP_EAA;
+    }
+    for (int i = 0; i < size; ++i) {
+        buf[i] = data[i] - mean;
+    }
+    for (int i = size; i < nfft; ++i) {
+        buf[i] = 0;
+    }
+
+    // kiss_fftr plans carry scratch memory, so transforms are serialized with the plan cache
+    pthread_mutex_lock(&plan_mutex);
+    if (plan_size != nfft) {
+        releasePlans();
+        fwd_cfg = kiss_fftr_alloc(nfft, 0, NULL, NULL);
+        inv_cfg = kiss_fftr_alloc(nfft, 1, NULL, NULL);
+        if (fwd_cfg == NULL || inv_cfg == NULL) {
+            releasePlans();
+            pthread_mutex_unlock(&plan_mutex);
+            free(buf);
+            free(spec);
+            free(xcorr);
+            return RP_EAA;
+        }
+        plan_size = nfft;
+    }
+    kiss_fftr(fwd_cfg, buf, spec);
+    for (int i = 0; i <= nfft / 2; ++i) {
+        spec[i].r = spec[i].r * spec[i].r + spec[i].i * spec[i].i;
+        spec[i].i = 0;
+    }
+    kiss_fftri(inv_cfg, spec, buf);
+    pthread_mutex_unlock(&plan_mutex);
+
+    // inverse transform is not scaled, nfft cancels in the ratios below
+    for (int i = 0; i < size; ++i) {
+        xcorr[i] = buf[i] / (size - i);
+    }
+
+    // a constant signal has no energy to normalize by
+    float idx = 0;
+    int ret = xcorr[0] > 0 ? xcorrPeak(xcorr, size, &idx) : RP_APP_ECP;
+    if (ret == RP_OK && idx < PERIOD_MIN_LAG) {
+        ret = RP_APP_ECP;
+    }
+    free(buf);
+    free(spec);
+    free(xcorr);
+    if (ret == RP_OK) {
+        *period = idx;
+    }
+    return ret;
+}
+
+/* Period of data in samples. Clean signals are measured on zero crossings in
+ * linear time, the rest falls back to the autocorrelation. */
+int meas_Period(const float *data, uint32_t size, float *period) {
+    if (meas_PeriodZeroCross(data, size, period) == RP_OK) {
+        return RP_OK;
+    }
+    return meas_PeriodAutocorr(data, size, period);
+}
+
+/* Adds one value to running statistics in O(1). Welford's update keeps the spread
+ * accurate when the values share a large offset, where sum of squares would cancel. */
+void meas_StatsAdd(meas_stats_t *stats, double value) {
+    double delta = value - stats->mean;
+    ++stats->count;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    if (stats->count == 1) {
+        stats->min = stats->max = value;
+    } else {
+        stats->min = MIN(stats->min, value);
+        stats->max = MAX(stats->max, value);
+    }
+}
+
+void meas_Release() {
+    pthread_mutex_lock(&plan_mutex);
+    releasePlans();
+    pthread_mutex_unlock(&plan_mutex);
+}
@@ -0,0 +1,62 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library signal measurement module interface
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#ifndef __MEASURE_H
+#define __MEASURE_H
+
+#include <stdint.h>
+
+#define PERIOD_HYSTERESIS             0.1f  // of half peak to peak
+#define PERIOD_JITTER_MAX             0.05f // crossing interval spread, relative to period
+#define PERIOD_MIN_LAG                2     // samples, shortest autocorrelation period
+#define PERIOD_MAX_LAG                0.75f // of the view, longest autocorrelation period
+#define PERIOD_PEAK_FRACTION          0.8f  // of the highest autocorrelation, first peak level
+#define SHAPE_HIST_BINS               256   // amplitude histogram resolution of meas_Shape()
+
+/* Scalar measurements of one view trace, all in view units */
+typedef struct {
+    uint32_t size;
+    float min;
+    float max;
+    float mean;
+    float var;      // population variance
+    float duty;     // ratio of points above mean
+} meas_frame_t;
+
+/* Levels and period of a raw capture, see meas_Shape() */
+typedef struct {
+    float low;          // level with at most tail of the points below it
+    float high;         // level with at most tail of the points above it
+    float period;       // in samples, 0 when the crossings are not periodic
+    uint32_t crossings; // rising crossings of the mid level
+} meas_shape_t;
+
+/* Running statistics of one measurement (Welford), see meas_StatsAdd() */
+typedef struct {
+    uint32_t count;
+    double mean;
+    double m2;      // sum of squared differences from the running mean
+    double min;
+    double max;
+} meas_stats_t;
+
+void meas_Frame(const float *data, uint32_t size, meas_frame_t *res);
+int meas_Period(const float *data, uint32_t size, float *period);
+int meas_PeriodZeroCross(const float *data, uint32_t size, float *period);
+int meas_PeriodAutocorr(const float *data, uint32_t size, float *period);
+void meas_Shape(const float *data, uint32_t size, float tail, meas_shape_t *res);
+void meas_StatsAdd(meas_stats_t *stats, double value);
+void meas_Release();
+
+#endif /* __MEASURE_H */
@@ -16,11 +16,17 @@
 #include <math.h>
 #include <float.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include "osciloscopeApp.h"
+#include "measure.h"
+#include "mathop.h"
+#include "interp.h"
+#include "persist.h"
 #include "common.h"
 #include "../../rpbase/src/common.h"
 
@@ -32,6 +38,61 @@ volatile bool clear = false;
 volatile bool continuousMode = false;
 volatile uint32_t viewSize = VIEW_SIZE_DEFAULT;
 float *view;
+float *viewMin, *viewMax;
+volatile bool peakDetect = false;
+volatile rpApp_osc_interp_t interpolation = RPAPP_OSC_INTERP_LINEAR;
+volatile bool rollMode = false;
+volatile rpApp_osc_persist_t persistMode = RPAPP_OSC_PERSIST_OFF;
+volatile float persistTime = PERSIST_TIME_DEFAULT;
+volatile bool envelopeValid = false;
+
+// Bumped whenever view contents or limits change, keys the measurement cache
+volatile uint32_t viewGeneration = 0;
+static uint32_t measGeneration = (uint32_t) -1;
+static meas_frame_t frameMeas[3];
+
+/* The view is composed in the back frame (view, viewMin, viewMax, viewStartPos, viewEndPos)
+ * under mutex and published by flipping frontFrame inside a sequence lock. Readers copy
+ * from the front frame without locking and retry when a flip happened meanwhile, so the
+ * acquisition thread never waits for them. viewReaders counts readers inside a read section,
+ * frames replaced on resize are freed only once it drops to zero. */
+typedef struct {
+    float *data;            // 3 sources, followed by envelope min and max of 2 channels
+    float *min;
+    float *max;
+    uint32_t size;
+    uint32_t start;
+    uint32_t end;
+    bool envelope;
+    uint32_t generation;
+    meas_frame_t meas[3];
+} view_frame_t;
+
+#define VIEW_FRAME_POINTS(SIZE)   (7 * (SIZE))
+
+static view_frame_t frames[2];
+static volatile uint32_t frontFrame = 0;
+static volatile uint32_t viewSeq = 0;
+static volatile uint32_t viewReaders = 0;
+
+// Period is computed on demand, once per published frame
+static pthread_mutex_t periodMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t periodGeneration[3] = { (uint32_t) -1, (uint32_t) -1, (uint32_t) -1 };
+static int periodResult[3];
+static float framePeriod[3];
+
+// Running statistics of the enabled measurements, fed by the worker with every acquired frame
+#define MEAS_STATS_COUNT          (RPAPP_OSC_MEAS_RMS + 1)
+static pthread_mutex_t statsMutex = PTHREAD_MUTEX_INITIALIZER;
+static meas_stats_t measStats[3][MEAS_STATS_COUNT];
+static bool measStatsEnabled[3][MEAS_STATS_COUNT];
+
+// Persistence image of 3 sources, each persistColumns x PERSIST_BINS hit counts, fed by the worker
+static pthread_mutex_t persistMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t *persistImage = NULL;
+static uint32_t persistColumns = 0;
+static bool persistStale = true;
+static double persistDecayTs = 0;
 volatile double ch1_ampOffset, ch2_ampOffset, math_ampOffset;
 volatile double ch1_ampScale,  ch2_ampScale,  math_ampScale;
 volatile float ch1_probeAtt, ch2_probeAtt;
@@ -58,6 +119,19 @@ volatile uint32_t viewEndPos = VIEW_SIZE_DEFAULT;
 pthread_t mainThread = (pthread_t) -1;
 pthread_mutex_t mutex;
 
+// Wakes the worker on run/stop, acquisition start and view changes
+static pthread_cond_t workerEvent = PTHREAD_COND_INITIALIZER;
+
+static inline void signalWorker() {
+    pthread_mutex_lock(&mutex);
+    pthread_cond_broadcast(&workerEvent);
+    pthread_mutex_unlock(&mutex);
+}
+
+static void unlockMutex(void *arg) {
+    pthread_mutex_unlock((pthread_mutex_t *) arg);
+}
+
 static inline double _clock() {
     struct timespec tp;
     clock_gettime(CLOCK_REALTIME, &tp);
@@ -74,12 +148,131 @@ static inline float linear(float x0, float y0, float x1, float y1, float x) {
     return (k * x) + b;
 }
 
+/* Scalar measurements of all sources for the current view generation. The first query
+ * of the back frame after a view change runs the fused kernel, publishView() makes sure
+ * every published frame carries its results. With a valid peak-detect envelope
+ * the extremes between the displayed points are included. Call locked. */
+static const meas_frame_t *measureFrame(rpApp_osc_source source) {
+    if (measGeneration != viewGeneration) {
+        uint32_t size = (viewEndPos > viewStartPos) ? viewEndPos - viewStartPos : 0;
+        for (int s = RPAPP_OSC_SOUR_CH1; s <= RPAPP_OSC_SOUR_MATH; ++s) {
+            meas_Frame(view + s*viewSize + viewStartPos, size, &frameMeas[s]);
+            if (envelopeValid && s != RPAPP_OSC_SOUR_MATH && size > 0) {
+                float unused;
+                cmn_MinMax(viewMin + s*viewSize + viewStartPos, size, &frameMeas[s].min, &unused);
+                cmn_MinMax(viewMax + s*viewSize + viewStartPos, size, &unused, &frameMeas[s].max);
+            }
+        }
+        measGeneration = viewGeneration;
+    }
+    return &frameMeas[source];
+}
+
+static inline void setBackFrame() {
+    view_frame_t *back = &frames[1 - frontFrame];
+    view = back->data;
+    viewMin = back->min;
+    viewMax = back->max;
+}
+
+/* Replaces both frames with zeroed ones of the new size. Call locked. */
+static int allocFrames(uint32_t size) {
+    float *blocks[2];
+    blocks[0] = calloc(VIEW_FRAME_POINTS(size), sizeof(float));
+    blocks[1] = calloc(VIEW_FRAME_POINTS(size), sizeof(float));
+    if (blocks[0] == NULL || blocks[1] == NULL) {
+        free(blocks[0]);
+        free(blocks[1]);
+        return RP_EAA;
+    }
+
+    float *retired[2] = { frames[0].data, frames[1].data };
+    ++viewSeq;
+    __sync_synchronize();
+    for (int k = 0; k < 2; ++k) {
+        frames[k].data = blocks[k];
+        frames[k].min = blocks[k] + 3 * size;
+        frames[k].max = blocks[k] + 5 * size;
+        frames[k].size = size;
+        frames[k].start = 0;
+        frames[k].end = size;
+        frames[k].envelope = false;
+        frames[k].generation = viewGeneration;
+        memset(frames[k].meas, 0, sizeof(frames[k].meas));
+    }
+    __sync_synchronize();
+    ++viewSeq;
+    setBackFrame();
+
+    /* Readers entering from now on see the new frames, wait for the ones still copying */
+    while (__sync_fetch_and_add(&viewReaders, 0) != 0) {
+        sched_yield();
+    }
+    free(retired[0]);
+    free(retired[1]);
+    return RP_OK;
+}
+
+/* Makes the back frame visible to readers, then continues composing on a copy of it. Call locked. */
+static void publishView() {
+    view_frame_t *back = &frames[1 - frontFrame];
+    measureFrame(RPAPP_OSC_SOUR_CH1);
+    back->start = viewStartPos;
+    back->end = viewEndPos;
+    back->envelope = envelopeValid;
+    back->generation = viewGeneration;
+    memcpy(back->meas, frameMeas, sizeof(frameMeas));
+
+    ++viewSeq;
+    __sync_synchronize();
+    frontFrame = 1 - frontFrame;
+    __sync_synchronize();
+    ++viewSeq;
+
+    memcpy(frames[1 - frontFrame].data, back->data, VIEW_FRAME_POINTS(back->size) * sizeof(float));
+    setBackFrame();
+}
+
+static inline uint32_t viewReadBegin() {
+    uint32_t seq;
+    __sync_fetch_and_add(&viewReaders, 1);
+    while ((seq = viewSeq) & 1) {
+    }
+    __sync_synchronize();
+    return seq;
+}
+
+/* Ends the read section begun by viewReadBegin() */
+static inline bool viewReadRetry(uint32_t seq) {
+    __sync_synchronize();
+    bool retry = viewSeq != seq;
+    __sync_fetch_and_sub(&viewReaders, 1);
+    return retry;
+}
+
+static void publishedMeas(rpApp_osc_source source, meas_frame_t *meas) {
+    uint32_t seq;
+    do {
+        seq = viewReadBegin();
+        *meas = frames[frontFrame].meas[source];
+    } while (viewReadRetry(seq));
+}
+
+// Hits drawn with other view settings no longer line up, the image restarts
+static void persistInvalidate() {
+    pthread_mutex_lock(&persistMutex);
+    persistStale = true;
+    pthread_mutex_unlock(&persistMutex);
+}
+
 static inline void update_view() {
+    persistInvalidate();
     if((trigSweep == RPAPP_OSC_TRIG_AUTO) && oscRunning) {
         clearView();
         updateView = false;
     } else {
         updateView = true;
+        signalWorker();
     }
 }
 
@@ -92,7 +285,7 @@ static inline int scaleChannel(rp_channel_t channel, float vpp, float vMean) {
     return RP_OK;
 }
 
-void checkAutoscale(bool fromThread);
+static void autoscaleStart();
 
 int osc_Init() {
     pthread_mutexattr_t attr;
@@ -100,12 +293,7 @@ int osc_Init() {
     pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
     pthread_mutex_init(&mutex, &attr);
     
-    view = calloc(3 * viewSize, sizeof(float));
-    if (view == NULL) {
-        free(view);
-        view = NULL;
-        return RP_EAA;
-    }
+    ECHECK_APP(allocFrames(viewSize));
     viewStartPos = 0;
     viewEndPos = viewSize;
     return RP_OK;
@@ -113,11 +301,19 @@ int osc_Init() {
 
 int osc_Release() {
     STOP_THREAD(mainThread);
+    meas_Release();
+    mop_Release();
+    pthread_mutex_lock(&persistMutex);
+    free(persistImage);
+    persistImage = NULL;
+    persistColumns = 0;
+    pthread_mutex_unlock(&persistMutex);
     pthread_mutex_destroy(&mutex);
-    if (view != NULL) {
-        free(view);
-        view = NULL;
+    for (int k = 0; k < 2; ++k) {
+        free(frames[k].data);
+        frames[k].data = NULL;
     }
+    view = viewMin = viewMax = NULL;
     return RP_OK;
 }
 
@@ -148,6 +344,7 @@ int osc_SetDefaultValues() {
 int osc_run() {
     clearView();
     EXECUTE_ATOMICALLY(mutex, oscRunning = true);
+    signalWorker();
     ECHECK_APP(threadSafe_acqStart());
 
     if (trigSweep == RPAPP_OSC_TRIG_SINGLE) {
@@ -191,7 +388,7 @@ int osc_autoScale() {
         osc_setTriggerSweep(RPAPP_OSC_TRIG_AUTO);
     }
 
-    checkAutoscale(false);
+    autoscaleStart();
 
     return RP_OK;
 }
@@ -538,59 +735,207 @@ int osc_isInverted(rpApp_osc_source source, bool *inverted) {
     return RP_OK;
 }
 
-int osc_getViewPart(float *ratio) {
-    *ratio = ((float)viewSize * (float)timeToIndex(timeScale) / samplesPerDivision) / (float)ADC_BUFFER_SIZE;
+int osc_setPeakDetect(bool enable) {
+    pthread_mutex_lock(&mutex);
+    peakDetect = enable;
+    update_view();
+    pthread_mutex_unlock(&mutex);
     return RP_OK;
 }
 
-int osc_measureVpp(rpApp_osc_source source, float *Vpp) {
-    float resMax, resMin, max = -FLT_MAX, min = FLT_MAX;
+int osc_getPeakDetect(bool *enable) {
+    *enable = peakDetect;
+    return RP_OK;
+}
 
+int osc_setInterpolation(rpApp_osc_interp_t interp) {
+    if (interp != RPAPP_OSC_INTERP_LINEAR && interp != RPAPP_OSC_INTERP_SINC) {
+        return RP_EOOR;
+    }
     pthread_mutex_lock(&mutex);
-    for (int i = viewStartPos; i < viewEndPos; ++i) {
-        if (view[source*viewSize + i] > max) {
-            max = view[source*viewSize + i];
+    interpolation = interp;
+    update_view();
+    pthread_mutex_unlock(&mutex);
+    return RP_OK;
+}
+
+int osc_getInterpolation(rpApp_osc_interp_t *interp) {
+    *interp = interpolation;
+    return RP_OK;
+}
+
+int osc_setRollMode(bool enable) {
+    pthread_mutex_lock(&mutex);
+    rollMode = enable;
+    pthread_cond_broadcast(&workerEvent);
+    pthread_mutex_unlock(&mutex);
+    return RP_OK;
+}
+
+int osc_getRollMode(bool *enable) {
+    *enable = rollMode;
+    return RP_OK;
+}
+
+/* Makes the image match the view size and clears it when stale. Call with persistMutex. */
+static int persistPrepare(uint32_t columns) {
+    if (persistColumns != columns) {
+        free(persistImage);
+        persistImage = malloc(3 * columns * PERSIST_BINS * sizeof(uint16_t));
+        persistColumns = (persistImage != NULL) ? columns : 0;
+        persistStale = true;
+        if (persistImage == NULL) {
+            return RP_EAA;
         }
-        if (view[source*viewSize + i] < min) {
-            min = view[source*viewSize + i];
+    }
+    if (persistStale) {
+        memset(persistImage, 0, 3 * persistColumns * PERSIST_BINS * sizeof(uint16_t));
+        persistDecayTs = _clock();
+        persistStale = false;
+    }
+    return RP_OK;
+}
+
+/* Exponential decay in whole PERSIST_DECAY_PERIOD steps, applied at most once per period
+ * however many frames arrive in between. Call with persistMutex. */
+static void persistDecay(double now) {
+    if (persistMode != RPAPP_OSC_PERSIST_DECAY) {
+        persistDecayTs = now;
+        return;
+    }
+    double steps = floor((now - persistDecayTs) / PERSIST_DECAY_PERIOD);
+    if (steps < 1) {
+        return;
+    }
+    uint32_t factor = (uint32_t) (65536.0 * exp(-steps * PERSIST_DECAY_PERIOD / persistTime));
+    if (factor == 0) {
+        memset(persistImage, 0, 3 * persistColumns * PERSIST_BINS * sizeof(uint16_t));
+    } else if (factor < 65536) {
+        persist_Decay(persistImage, 3 * persistColumns * PERSIST_BINS, factor);
+    }
+    persistDecayTs += steps * PERSIST_DECAY_PERIOD;
+}
+
+/* Adds the frame composed in the back view to the persistence image. Call locked. */
+static void updatePersistence() {
+    if (persistMode == RPAPP_OSC_PERSIST_OFF) {
+        return;
+    }
+    rpApp_osc_source last = (operation != RPAPP_OSC_MATH_NONE) ? RPAPP_OSC_SOUR_MATH : RPAPP_OSC_SOUR_CH2;
+
+    pthread_mutex_lock(&persistMutex);
+    if (persistPrepare(viewSize) == RP_OK) {
+        persistDecay(_clock());
+        for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= last; ++source) {
+            bool envelope = envelopeValid && source != RPAPP_OSC_SOUR_MATH;
+            persist_Accumulate(&persistImage[source * viewSize * PERSIST_BINS], &view[source * viewSize],
+                               envelope ? &viewMin[source * viewSize] : NULL,
+                               envelope ? &viewMax[source * viewSize] : NULL,
+                               viewStartPos, viewEndPos, -DIVISIONS_COUNT_Y / 2.f, DIVISIONS_COUNT_Y);
         }
     }
-    pthread_mutex_unlock(&mutex);
+    pthread_mutex_unlock(&persistMutex);
+}
+
+int osc_setPersistence(rpApp_osc_persist_t mode) {
+    if (mode != RPAPP_OSC_PERSIST_OFF && mode != RPAPP_OSC_PERSIST_DECAY && mode != RPAPP_OSC_PERSIST_INFINITE) {
+        return RP_EOOR;
+    }
+    pthread_mutex_lock(&persistMutex);
+    persistMode = mode;
+    persistStale = true;
+    if (mode == RPAPP_OSC_PERSIST_OFF) {
+        free(persistImage);
+        persistImage = NULL;
+        persistColumns = 0;
+    }
+    pthread_mutex_unlock(&persistMutex);
+    return RP_OK;
+}
+
+int osc_getPersistence(rpApp_osc_persist_t *mode) {
+    *mode = persistMode;
+    return RP_OK;
+}
+
+int osc_setPersistenceTime(float time) {
+    if (!(time > 0.f)) {
+        return RP_EOOR;
+    }
+    EXECUTE_ATOMICALLY(persistMutex, persistTime = time);
+    return RP_OK;
+}
+
+int osc_getPersistenceTime(float *time) {
+    *time = persistTime;
+    return RP_OK;
+}
+
+int osc_resetPersistence() {
+    persistInvalidate();
+    return RP_OK;
+}
+
+int osc_getPersistenceImage(rpApp_osc_source source, uint8_t *image, uint32_t size) {
+    uint32_t columns = viewSize;
+    if (source > RPAPP_OSC_SOUR_MATH || size < columns * PERSIST_BINS) {
+        return RP_EOOR;
+    }
+    if (persistMode == RPAPP_OSC_PERSIST_OFF) {
+        memset(image, 0, columns * PERSIST_BINS);
+        return RP_OK;
+    }
 
-    ECHECK_APP(unscaleAmplitudeChannel(source, max, &resMax));
-    ECHECK_APP(unscaleAmplitudeChannel(source, min, &resMin));
+    pthread_mutex_lock(&persistMutex);
+    int ret = persistPrepare(columns);
+    if (ret == RP_OK) {
+        // without new frames the image still fades
+        persistDecay(_clock());
+        persist_Render(&persistImage[source * columns * PERSIST_BINS], columns, image);
+    }
+    pthread_mutex_unlock(&persistMutex);
+    return ret;
+}
+
+int osc_getViewPart(float *ratio) {
+    *ratio = ((float)viewSize * (float)timeToIndex(timeScale) / samplesPerDivision) / (float)ADC_BUFFER_SIZE;
+    return RP_OK;
+}
+
+static int measVpp(rpApp_osc_source source, const meas_frame_t *meas, float *Vpp) {
+    float resMax, resMin;
+
+    ECHECK_APP(unscaleAmplitudeChannel(source, meas->max, &resMax));
+    ECHECK_APP(unscaleAmplitudeChannel(source, meas->min, &resMin));
     *Vpp = resMax - resMin;
     ECHECK_APP(attenuateAmplitudeChannel(source, *Vpp, Vpp));
     *Vpp = fabs(*Vpp);
     return RP_OK;
 }
 
-int osc_measureMeanVoltage(rpApp_osc_source source, float *meanVoltage) {
-    double sum = 0;
-    
-    pthread_mutex_lock(&mutex);
-    for (int i = viewStartPos; i < viewEndPos; ++i) {
-        sum += view[source*viewSize + i];
-    }
-    pthread_mutex_unlock(&mutex);
-
-    ECHECK_APP(unscaleAmplitudeChannel(source, sum / (viewEndPos - viewStartPos), meanVoltage));
+static int measMeanVoltage(rpApp_osc_source source, const meas_frame_t *meas, float *meanVoltage) {
+    ECHECK_APP(unscaleAmplitudeChannel(source, meas->mean, meanVoltage));
     ECHECK_APP(attenuateAmplitudeChannel(source, *meanVoltage, meanVoltage));
     return RP_OK;
 }
 
-int osc_measureMaxVoltage(rpApp_osc_source source, float *Vmax) {
-    float max = view[source*viewSize];
+int osc_measureVpp(rpApp_osc_source source, float *Vpp) {
+    meas_frame_t meas;
+    publishedMeas(source, &meas);
+    return measVpp(source, &meas, Vpp);
+}
 
-    pthread_mutex_lock(&mutex);
+int osc_measureMeanVoltage(rpApp_osc_source source, float *meanVoltage) {
+    meas_frame_t meas;
+    publishedMeas(source, &meas);
+    return measMeanVoltage(source, &meas, meanVoltage);
+}
+
+int osc_measureMaxVoltage(rpApp_osc_source source, float *Vmax) {
+    meas_frame_t meas;
+    publishedMeas(source, &meas);
     bool inverted = (source == 0 && ch1_inverted) || (source == 1 && ch2_inverted) || (source == 2 && math_inverted);
-    for (int i = viewStartPos; i < viewEndPos; ++i) {
-        if (inverted ? view[source*viewSize + i] < max : view[source*viewSize + i] > max) {
-            max = view[source*viewSize + i];
-        }
-    }
-    *Vmax = max;
-    pthread_mutex_unlock(&mutex);
+    float max = inverted ? meas.min : meas.max;
 
     ECHECK_APP(unscaleAmplitudeChannel(source, max, Vmax));
     ECHECK_APP(attenuateAmplitudeChannel(source, *Vmax, Vmax));
@@ -598,17 +943,10 @@ int osc_measureMaxVoltage(rpApp_osc_source source, float *Vmax) {
 }
 
 int osc_measureMinVoltage(rpApp_osc_source source, float *Vmin) {
-    float min = view[source*viewSize];
-    
-    pthread_mutex_lock(&mutex);
+    meas_frame_t meas;
+    publishedMeas(source, &meas);
     bool inverted = (source == 0 && ch1_inverted) || (source == 1 && ch2_inverted) || (source == 2 && math_inverted);
-    for (int i = viewStartPos; i < viewEndPos; ++i) {
-        if (inverted ? view[source*viewSize + i] > min : view[source*viewSize + i] < min) {
-            min = view[source*viewSize + i];
-        }
-    }
-    *Vmin = min;
-    pthread_mutex_unlock(&mutex);
+    float min = inverted ? meas.max : meas.min;
 
     ECHECK_APP(unscaleAmplitudeChannel(source, min, Vmin));
     ECHECK_APP(attenuateAmplitudeChannel(source, *Vmin, Vmin));
@@ -623,169 +961,179 @@ int osc_measureFrequency(rpApp_osc_source source, float *frequency) {
 }
 
 int osc_measurePeriod(rpApp_osc_source source, float *period) {
-    int size = viewEndPos - viewStartPos;
-    float data[size];
-    float* ch_view = view + source*viewSize + viewStartPos;
+    uint32_t capacity = viewSize;
+    float data[capacity];
+    uint32_t seq, size, generation;
+    float idx;
+    int ret;
 
-    pthread_mutex_lock(&mutex);
-    float mean = 0;
-    for (int i = 0; i < size; ++i) {
-        data[i] = ch_view[i];
-        mean += data[i];
-    }
-    pthread_mutex_unlock(&mutex);
+    pthread_mutex_lock(&periodMutex);
+    do {
+        seq = viewReadBegin();
+        const view_frame_t *frame = &frames[frontFrame];
+        generation = frame->generation;
+        size = (frame->end > frame->start) ? MIN(frame->end - frame->start, capacity) : 0;
+        if (generation != periodGeneration[source]) {
+            const float *trace = frame->data + source*frame->size + frame->start;
+            for (int i = 0; i < size; ++i) {
+                data[i] = trace[i];
+            }
+        }
+    } while (viewReadRetry(seq));
 
-    mean = mean / size;
-    for (int i = 0; i < size; ++i){
-        data[i] -= mean;
+    if (generation != periodGeneration[source]) {
+        periodResult[source] = meas_Period(data, size, &framePeriod[source]);
+        periodGeneration[source] = generation;
     }
+    ret = periodResult[source];
+    idx = framePeriod[source];
+    pthread_mutex_unlock(&periodMutex);
 
-    // calculate signal correlation
-    float xcorr[size];
-    for (int i = 0; i < size; ++i) {
-        xcorr[i] = 0;
-        for (int j = 0; j < size-i; ++j) {
-            xcorr[i] += data[j] * data[j+i];
-        }
-        xcorr[i] /= size-i;
-    }
-
-    // The main problem is the presence lot of noise in the signal
-    // We can filter correlation function and differentiate it to find local maximum, but it could fail on high frequencies I suppose
-    // So lets try to find local maximum logically, idea is:
-    // signal: ZxxbbbbbaaAaaBbbbbxxYxbbbbBaaAaaa
-    // 'a' - values below acceptable threshold
-    // 'b', 'x', 'y' - values above acceptable threshold
-    // 'Y' - local maximum value
-    // 'Z' - reference value
-    // 'x' - almost y
-    // need find left 'A', then we can find left 'B'
-    // then can need find right 'A', then can find right 'B'
-    // then we can find 'Y' between left and right 'B'
-    // then we can find left and right 'x'
-    // guess extreme point locates in the middle of left and right 'x'
-    // we can not use 'Y' only because it could be (x + noise)
-
-    int left_idx = 0;
-    int right_idx = 0;
-    int left_edge_idx = 0;
-    int right_edge_idx = size-2;
-
-    // search for left point where correlation function is less than it's expected
-    for (int i = 1; i < size-1; ++i) {
-        if((xcorr[i] / xcorr[0]) < PERIOD_EXISTS_MIN_THRESHOLD) {
-            left_edge_idx = i;
-            break;
-        }
+    if (ret != RP_OK) {
+        return ret;
     }
 
-    if(left_edge_idx == 0) {
-        return RP_APP_ECP;
-    }
+    float timeScale, viewScale;
+    ECHECK_APP(osc_getTimeScale(&timeScale));
+    viewScale = timeToIndex(timeScale) / samplesPerDivision;
 
-    // search for left point where correlation function is greater than it's expected
-    for (int i = left_edge_idx; i < size-1; ++i) {
-        if((xcorr[i] / xcorr[0]) >= PERIOD_EXISTS_MAX_THRESHOLD) {
-            left_idx = i;
-            break;
-        }
-    }
+    // indexToTime() takes whole samples, scale the sub-sample period by the sample time
+    *period = idx * viewScale * indexToTime(1);
 
-    if(left_idx == 0) {
-        return RP_APP_ECP;
-    }
+    return RP_OK;
+}
 
-    // search for right point where correlation function is less than it's expected
-    for (int i = left_idx; i < size-1; ++i) {
-        if((xcorr[i] / xcorr[0]) < PERIOD_EXISTS_MIN_THRESHOLD) {
-            right_edge_idx = i;
-            break;
-        }
-    }
-    
-    // search for right point where correlation function is greater than it's expected
-    for (int i = right_edge_idx; i >= left_idx; --i) {
-        if((xcorr[i] / xcorr[0]) >= PERIOD_EXISTS_MAX_THRESHOLD) {
-            right_idx = i;
-            break;
-        }
-    }
+int osc_measureDutyCycle(rpApp_osc_source source, float *dutyCycle) {
+    meas_frame_t meas;
+    publishedMeas(source, &meas);
+    *dutyCycle = meas.duty;
+    return RP_OK;
+}
 
-    // search for local maximum
-    float loc_max = xcorr[left_idx];
-    int max_idx = left_idx;
-    for (int i = left_idx; i <= right_idx; ++i) {
-        if(loc_max < xcorr[i]) {
-            loc_max = xcorr[i];
-            max_idx = i;
-        }
+int osc_measureRootMeanSquare(rpApp_osc_source source, float *rms) {
+    float mean, var, zero, one;
+    meas_frame_t meas;
+
+    publishedMeas(source, &meas);
+    mean = meas.mean;
+    var = meas.var;
+
+    // view to volts is affine, so mean square = gain^2 * variance + mean^2
+    ECHECK_APP(unscaleAmplitudeChannel(source, mean, &mean));
+    ECHECK_APP(unscaleAmplitudeChannel(source, 0, &zero));
+    ECHECK_APP(unscaleAmplitudeChannel(source, 1, &one));
+    *rms = (float) sqrt((one - zero) * (one - zero) * var + mean * mean);
+    ECHECK_APP(attenuateAmplitudeChannel(source, *rms, rms));
+    return RP_OK;
+}
+
+/* Quiet variant of the measure functions: a frame without a period is common and
+ * must not be logged on every frame, so frequency is derived here from the period */
+static int measureValue(rpApp_osc_source source, rpApp_osc_meas_t meas, float *value) {
+    int ret;
+    switch (meas) {
+        case RPAPP_OSC_MEAS_VPP:
+            return osc_measureVpp(source, value);
+        case RPAPP_OSC_MEAS_VMEAN:
+            return osc_measureMeanVoltage(source, value);
+        case RPAPP_OSC_MEAS_VMAX:
+            return osc_measureMaxVoltage(source, value);
+        case RPAPP_OSC_MEAS_VMIN:
+            return osc_measureMinVoltage(source, value);
+        case RPAPP_OSC_MEAS_FREQ:
+            ret = osc_measurePeriod(source, value);
+            *value = (float) (1 / (*value / 1000.0));
+            return ret;
+        case RPAPP_OSC_MEAS_PERIOD:
+            return osc_measurePeriod(source, value);
+        case RPAPP_OSC_MEAS_DUTY:
+            return osc_measureDutyCycle(source, value);
+        case RPAPP_OSC_MEAS_RMS:
+            return osc_measureRootMeanSquare(source, value);
+        default:
+            return RP_EOOR;
     }
+}
 
-    // search for left point which is almost equal to maximum
-    int left_amax_idx = max_idx;
-    int right_amax_idx = max_idx;
-    for (int i = left_idx; i <= right_idx; ++i) {
-        if(xcorr[i] >= loc_max * PERIOD_EXISTS_PEAK_THRESHOLD) {
-            left_amax_idx = i;
-            break;
+/* Adds the enabled measurements of the frame just published to the running statistics. The
+ * values are taken before locking, frequency and period share the cached period. */
+static void updateMeasureStatistics() {
+    rpApp_osc_source last = (operation != RPAPP_OSC_MATH_NONE) ? RPAPP_OSC_SOUR_MATH : RPAPP_OSC_SOUR_CH2;
+    float values[3][MEAS_STATS_COUNT];
+    bool valid[3][MEAS_STATS_COUNT];
+    bool enabled[3][MEAS_STATS_COUNT];
+
+    pthread_mutex_lock(&statsMutex);
+    memcpy(enabled, measStatsEnabled, sizeof(enabled));
+    pthread_mutex_unlock(&statsMutex);
+
+    for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= last; ++source) {
+        for (int meas = 0; meas < MEAS_STATS_COUNT; ++meas) {
+            valid[source][meas] = enabled[source][meas]
+                    && measureValue(source, (rpApp_osc_meas_t) meas, &values[source][meas]) == RP_OK
+                    && isfinite(values[source][meas]);
         }
     }
 
-    // search for right point which is almost equal to maximum
-    for (int i = right_edge_idx; i >= left_idx; --i) {
-        if(xcorr[i] >= loc_max * PERIOD_EXISTS_PEAK_THRESHOLD) {
-            right_amax_idx = i;
-            break;
+    pthread_mutex_lock(&statsMutex);
+    for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= last; ++source) {
+        for (int meas = 0; meas < MEAS_STATS_COUNT; ++meas) {
+            if (valid[source][meas]) {
+                meas_StatsAdd(&measStats[source][meas], values[source][meas]);
+            }
         }
     }
+    pthread_mutex_unlock(&statsMutex);
+}
 
-    // guess extreme point locates between 'left_amax_idx' and 'right_amax_idx'
-    float timeScale, viewScale;
-    ECHECK_APP(osc_getTimeScale(&timeScale));
-    viewScale = timeToIndex(timeScale) / samplesPerDivision;
-
-    float idx = ((left_amax_idx + right_amax_idx) / 2.f) * viewScale;
-    *period = indexToTime(idx);
-
+int osc_resetMeasureStatistics() {
+    pthread_mutex_lock(&statsMutex);
+    memset(measStats, 0, sizeof(measStats));
+    pthread_mutex_unlock(&statsMutex);
     return RP_OK;
 }
 
-int osc_measureDutyCycle(rpApp_osc_source source, float *dutyCycle) {
-    int highTime = 0;
-    float meanValue;
-    ECHECK_APP(osc_measureMeanVoltage(source, &meanValue));
-    ECHECK_APP(scaleAmplitudeChannel(source, meanValue, &meanValue))
-
-    pthread_mutex_lock(&mutex);
-    for (int i = viewStartPos; i < viewEndPos; ++i) {
-        if (view[source*viewSize + i] > meanValue) {
-            ++highTime;
-        }
+int osc_setMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, bool enabled) {
+    if (source > RPAPP_OSC_SOUR_MATH || meas >= MEAS_STATS_COUNT) {
+        return RP_EOOR;
     }
-    pthread_mutex_unlock(&mutex);
 
-    *dutyCycle = (float)highTime / (float)(viewEndPos - viewStartPos);
+    pthread_mutex_lock(&statsMutex);
+    measStatsEnabled[source][meas] = enabled;
+    pthread_mutex_unlock(&statsMutex);
     return RP_OK;
 }
 
-int osc_measureRootMeanSquare(rpApp_osc_source source, float *rms) {
-    double rmsValue = 0;
-
-    pthread_mutex_lock(&mutex);
-    for (int i = viewStartPos; i < viewEndPos; ++i) {
-        float tmp;
-        unscaleAmplitudeChannel(source, view[source*viewSize + i], &tmp);
-        rmsValue += tmp*tmp;
+int osc_getMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, rpApp_osc_meas_stats_t *stats) {
+    if (source > RPAPP_OSC_SOUR_MATH || meas >= MEAS_STATS_COUNT) {
+        return RP_EOOR;
     }
-    pthread_mutex_unlock(&mutex);
 
-    *rms = (double) sqrt(rmsValue / (double)(viewEndPos - viewStartPos));
-    ECHECK_APP(attenuateAmplitudeChannel(source, *rms, rms));
+    // a consumer asking for the statistics keeps them collected
+    pthread_mutex_lock(&statsMutex);
+    measStatsEnabled[source][meas] = true;
+    meas_stats_t s = measStats[source][meas];
+    pthread_mutex_unlock(&statsMutex);
+
+    stats->count = s.count;
+    stats->mean = s.mean;
+    stats->stddev = (s.count > 1) ? sqrt(s.m2 / (s.count - 1)) : 0;
+    stats->min = s.min;
+    stats->max = s.max;
     return RP_OK;
 }
 
 int osc_getCursorVoltage(rpApp_osc_source source, uint32_t cursor, float *value) {
-    return unscaleAmplitudeChannel(source, view[source*viewSize + cursor], value);
+    uint32_t seq;
+    float v = 0;
+    do {
+        seq = viewReadBegin();
+        const view_frame_t *frame = &frames[frontFrame];
+        if (cursor < frame->size) {
+            v = frame->data[source*frame->size + cursor];
+        }
+    } while (viewReadRetry(seq));
+    return unscaleAmplitudeChannel(source, v, value);
 }
 
 int osc_getCursorTime(uint32_t cursor, float *value) {
@@ -858,26 +1206,52 @@ int osc_getMathSources(rp_channel_t *source1, rp_channel_t *source2) {
 }
 
 int osc_getData(rpApp_osc_source source, float *data, uint32_t size) {
-    pthread_mutex_lock(&mutex);
-    for (int i = 0; i < size; ++i) {
-        data[i] = view[source*viewSize + i];
+    uint32_t seq;
+    int ret;
+    do {
+        seq = viewReadBegin();
+        const view_frame_t *frame = &frames[frontFrame];
+        ret = (size <= frame->size) ? RP_OK : RP_EOOR;
+        for (int i = 0; ret == RP_OK && i < size; ++i) {
+            data[i] = frame->data[source*frame->size + i];
+        }
+    } while (viewReadRetry(seq));
+    return ret;
+}
+
+int osc_getEnvelope(rpApp_osc_source source, float *min, float *max, uint32_t size) {
+    if (source == RPAPP_OSC_SOUR_MATH) {
+        return RP_EOOR;
     }
-    pthread_mutex_unlock(&mutex);
-    return RP_OK;
+
+    uint32_t seq;
+    int ret;
+    do {
+        seq = viewReadBegin();
+        const view_frame_t *frame = &frames[frontFrame];
+        const float *lo = (frame->envelope ? frame->min : frame->data) + source*frame->size;
+        const float *hi = (frame->envelope ? frame->max : frame->data) + source*frame->size;
+        ret = (size <= frame->size) ? RP_OK : RP_EOOR;
+        for (int i = 0; ret == RP_OK && i < size; ++i) {
+            min[i] = lo[i];
+            max[i] = hi[i];
+        }
+    } while (viewReadRetry(seq));
+    return ret;
 }
 
 int osc_setViewSize(uint32_t size) {
+    pthread_mutex_lock(&mutex);
+    ECHECK_APP_MUTEX(mutex, allocFrames(size));
     viewSize = size;
     samplesPerDivision = (float) viewSize / (float) DIVISIONS_COUNT_X;
-    
-    pthread_mutex_lock(&mutex);
-    view = realloc(view, 3 * viewSize * sizeof(float));
-    if (view == NULL) {
-        pthread_mutex_unlock(&mutex);
-        return RP_EAA;
-    }
+    envelopeValid = false;
+    viewStartPos = 0;
+    viewEndPos = viewSize;
+    ++viewGeneration;
+    publishView();
+    update_view();
     pthread_mutex_unlock(&mutex);
-    EXECUTE_ATOMICALLY(mutex, update_view());
     return RP_OK;
 }
 
@@ -891,8 +1265,12 @@ int osc_getViewLimits(uint32_t* start, uint32_t* end) {
         *start = 0;
         *end = 0;
     } else {
-        *start = viewStartPos;
-        *end = viewEndPos;
+        uint32_t seq;
+        do {
+            seq = viewReadBegin();
+            *start = frames[frontFrame].start;
+            *end = frames[frontFrame].end;
+        } while (viewReadRetry(seq));
     }
     return RP_OK;
 }
@@ -909,6 +1287,7 @@ int threadSafe_acqStart() {
     ECHECK_APP_MUTEX(mutex, rp_AcqStart())
     ECHECK_APP_MUTEX(mutex, rp_AcqSetArmKeep(trigSweep != RPAPP_OSC_TRIG_SINGLE && continuousMode));
     acqRunning = true;
+    pthread_cond_broadcast(&workerEvent);
     pthread_mutex_unlock(&mutex);
     return RP_OK;
 }
@@ -947,6 +1326,22 @@ int scaleAmplitudeChannel(rpApp_osc_source source, float volts, float *res) {
     return RP_OK;
 }
 
+/* Affine form of scaleAmplitudeChannel (res = volts * gain + offset), so view
+ * fill loops fetch the channel settings once per frame instead of per sample */
+int scaleAmplitudeCoefChannel(rpApp_osc_source source, float *gain, float *offset) {
+    double ampOffset, ampScale;
+    float probeAtt = 1;
+    bool inverted;
+    ECHECK_APP(osc_getAmplitudeOffset(source, &ampOffset));
+    ECHECK_APP(osc_getAmplitudeScale(source, &ampScale));
+    if (source != RPAPP_OSC_SOUR_MATH)
+        ECHECK_APP(osc_getProbeAtt((rp_channel_t)source, &probeAtt));
+    ECHECK_APP(osc_isInverted(source, &inverted));
+    *gain = (float) ((inverted ? -1 : 1) * probeAtt / ampScale);
+    *offset = (float) (ampOffset / ampScale);
+    return RP_OK;
+}
+
 int unscaleAmplitudeChannel(rpApp_osc_source source, float value, float *res) {
     double ampOffset, ampScale;
     float probeAtt=1;
@@ -990,63 +1385,6 @@ float viewIndexToTime(int index) {
     return indexToTime(index - viewSize / 2) + timeOffset;
 }
 
-void calculateIntegral(rp_channel_t channel, float scale, float offset, float invertFactor) {
-    float dt = timeScale / samplesPerDivision;
-    float v;
-    
-    bool invert = (channel == RP_CH_1) ? ch1_inverted : ch2_inverted;
-    float ch_sign = invert ? -1.f : 1.f;
-
-    ECHECK_APP_THREAD(unscaleAmplitudeChannel((rpApp_osc_source) channel, view[channel*viewSize + viewStartPos], &v));
-	ECHECK_APP_THREAD(attenuateAmplitudeChannel((rpApp_osc_source) channel, v, &v));
-    view[RPAPP_OSC_SOUR_MATH*viewSize] = ch_sign * v * dt;
-    for (int i = viewStartPos + 1; i < viewEndPos; ++i) {
-        ECHECK_APP_THREAD(unscaleAmplitudeChannel((rpApp_osc_source) channel, view[channel*viewSize + i], &v));
-		ECHECK_APP_THREAD(attenuateAmplitudeChannel((rpApp_osc_source) channel, v, &v));
-        view[RPAPP_OSC_SOUR_MATH*viewSize + i] = view[RPAPP_OSC_SOUR_MATH*viewSize + i-1] + (ch_sign * v * dt);
-        view[RPAPP_OSC_SOUR_MATH*viewSize + i-1] = scaleAmplitude(view[RPAPP_OSC_SOUR_MATH*viewSize + i-1], scale, 1, offset, invertFactor);
-    }
-    view[RPAPP_OSC_SOUR_MATH*viewSize + viewEndPos - 1] = scaleAmplitude(view[RPAPP_OSC_SOUR_MATH*viewSize + viewEndPos - 1], scale, 1, offset, invertFactor);
-}
-
-void calculateDevivative(rp_channel_t channel, float scale, float offset, float invertFactor) {
-    float dt2 = 2*timeScale / 1000 / samplesPerDivision;
-    float v1, v2;
-    
-    bool invert = (channel == RP_CH_1) ? ch1_inverted : ch2_inverted;
-    float ch_sign = invert ? -1.f : 1.f;
-    
-    ECHECK_APP_THREAD(unscaleAmplitudeChannel((rpApp_osc_source) channel, view[channel*viewSize + viewStartPos], &v2));
-	ECHECK_APP_THREAD(attenuateAmplitudeChannel((rpApp_osc_source) channel, v2, &v2));
-    for (int i = viewStartPos; i < viewEndPos - 1; ++i) {
-        v1 = v2;
-        ECHECK_APP_THREAD(unscaleAmplitudeChannel((rpApp_osc_source) channel, view[channel*viewSize + i + 1], &v2));
-		ECHECK_APP_THREAD(attenuateAmplitudeChannel((rpApp_osc_source) channel, v2, &v2));
-        view[RPAPP_OSC_SOUR_MATH*viewSize + i] = scaleAmplitude(ch_sign * (v2 - v1) / dt2, scale, 1, offset, invertFactor);
-    }
-    view[RPAPP_OSC_SOUR_MATH*viewSize + viewEndPos - 1] = view[RPAPP_OSC_SOUR_MATH*viewSize + viewEndPos - 2];
-}
-
-float calculateMath(float v1, float v2, rpApp_osc_math_oper_t op) {
-    switch (op) {
-        case RPAPP_OSC_MATH_ADD:
-            return v1 + v2;
-        case RPAPP_OSC_MATH_SUB:
-            return v1 - v2;
-        case RPAPP_OSC_MATH_MUL:
-            return v1 * v2;
-        case RPAPP_OSC_MATH_DIV:
-            if (v2 != 0)
-                return v1 / v2;
-            else
-                return v1 > 0 ? FLT_MAX * 0.9f : -FLT_MAX * 0.9f;
-        case RPAPP_OSC_MATH_ABS:
-            return (float) fabs(v1);
-        default:
-            return 0;
-    }
-}
-
 double roundUpTo125(double data) {
     double power = ceil(log(data) / log(10)) - 1;       // calculate normalization factor
     double dataNorm = data / pow(10, power);            // normalize data, so that 1 < data < 10
@@ -1072,19 +1410,41 @@ double roundUpTo25(double data) {
 }
 
 void clearView() {
+    pthread_mutex_lock(&mutex);
     int size = 3*viewSize;
     for (int i = 0; i < size; ++i) {
         view[i] = 0;
     }
     clear = true;
+    pthread_cond_broadcast(&workerEvent);
+    envelopeValid = false;
     viewStartPos = 0;
     viewEndPos = viewSize;
+    ++viewGeneration;
+    publishView();
+    pthread_mutex_unlock(&mutex);
 }
 
 void clearMath() {
+    pthread_mutex_lock(&mutex);
     for (int i = 0; i < viewSize; ++i) {
         view[RPAPP_OSC_SOUR_MATH*viewSize + i] = 0;
     }
+    ++viewGeneration;
+    publishView();
+    pthread_mutex_unlock(&mutex);
+}
+
+// Sleeps for roughly the time the ADC needs to write the given number of samples
+static void sleepForSamples(float samples) {
+    float rate;
+    if (samples <= 0.f || rp_AcqGetSamplingRateHz(&rate) != RP_OK || rate <= 0.f) {
+        return;
+    }
+    double ms = MIN((double) samples * 1000.0 / rate, WAIT_TRIGGER_MAX_TIMEOUT);
+    if (ms >= 0.05) {
+        usleep((useconds_t) (ms * 1000.0));
+    }
 }
 
 int waitToFillPreTriggerBuffer(bool testcancel) {
@@ -1093,7 +1453,7 @@ int waitToFillPreTriggerBuffer(bool testcancel) {
     }
 
     double localTimer = testcancel ? threadTimer : _clock() + WAIT_TO_FILL_BUF_TIMEOUT;
-    float deltaSample, timeScale;
+    float deltaSample, timeScale, missing;
     uint32_t preTriggerCount;
     int triggerDelay;
 
@@ -1105,13 +1465,18 @@ int waitToFillPreTriggerBuffer(bool testcancel) {
 
         if(testcancel)
             pthread_testcancel();
-    } while (preTriggerCount < viewSize/2*deltaSample - triggerDelay && localTimer > _clock());
+
+        missing = viewSize/2*deltaSample - triggerDelay - (float) preTriggerCount;
+        if (missing > 0.f) {
+            sleepForSamples(missing);
+        }
+    } while (missing > 0.f && localTimer > _clock());
     return RP_OK;
 }
 
 int waitToFillAfterTriggerBuffer(bool testcancel) {
     double localTimer = testcancel ? threadTimer : _clock() + WAIT_TO_FILL_BUF_TIMEOUT;
-    float deltaSample, timeScale;
+    float deltaSample, timeScale, missing;
     uint32_t _writePointer, _triggerPosition;
     int triggerDelay;
 
@@ -1126,7 +1491,11 @@ int waitToFillAfterTriggerBuffer(bool testcancel) {
         if(testcancel)
             pthread_testcancel();
 
-    } while ((((_writePointer - _triggerPosition) % ADC_BUFFER_SIZE) <= ((viewSize/2.f) * deltaSample) + triggerDelay) && localTimer > _clock());
+        missing = ((viewSize/2.f) * deltaSample) + triggerDelay - (float) ((_writePointer - _triggerPosition) % ADC_BUFFER_SIZE);
+        if (missing >= 0.f) {
+            sleepForSamples(missing + 1.f);
+        }
+    } while (missing >= 0.f && localTimer > _clock());
     return RP_OK;
 }
 
@@ -1138,8 +1507,10 @@ static inline void scaleMath() {
     if (mathChanged && !autoScale) {
         mathChanged = false;
         float vpp, vMean;
-        ECHECK_APP_THREAD(osc_measureVpp(RPAPP_OSC_SOUR_MATH, &vpp));
-        ECHECK_APP_THREAD(osc_measureMeanVoltage(RPAPP_OSC_SOUR_MATH, &vMean));
+        // the math trace being composed is not published yet
+        const meas_frame_t *meas = measureFrame(RPAPP_OSC_SOUR_MATH);
+        ECHECK_APP_THREAD(measVpp(RPAPP_OSC_SOUR_MATH, meas, &vpp));
+        ECHECK_APP_THREAD(measMeanVoltage(RPAPP_OSC_SOUR_MATH, meas, &vMean));
         // Calculate scale
         float scale = vpp * AUTO_SCALE_AMP_SCA_FACTOR / DIVISIONS_COUNT_Y;
 		if (scale <= FLOAT_EPS) {
@@ -1151,180 +1522,255 @@ static inline void scaleMath() {
 	}
 }
 
+/* A math operand is affine in the view value of its channel, fold the unscale,
+ * attenuation and inversion chain into view*a + b once per frame */
+static int mathOperandCoef(rp_channel_t channel, float *a, float *b) {
+    bool invert = (channel == RP_CH_1) ? ch1_inverted : ch2_inverted;
+    float sign = invert ? -1.f : 1.f;
+    float v0, v1;
+    ECHECK_APP(unscaleAmplitudeChannel((rpApp_osc_source) channel, 0.f, &v0));
+    ECHECK_APP(attenuateAmplitudeChannel((rpApp_osc_source) channel, v0, &v0));
+    ECHECK_APP(unscaleAmplitudeChannel((rpApp_osc_source) channel, 1.f, &v1));
+    ECHECK_APP(attenuateAmplitudeChannel((rpApp_osc_source) channel, v1, &v1));
+    *a = sign * (v1 - v0);
+    *b = sign * v0;
+    return RP_OK;
+}
+
 void mathThreadFunction() {
     if (operation != RPAPP_OSC_MATH_NONE) {
+        ++viewGeneration;
         bool invert;
         ECHECK_APP_THREAD(osc_isInverted(RPAPP_OSC_SOUR_MATH, &invert))
         float invertFactor = invert ? -1 : 1;
+
+        mop_coef_t k;
+        ECHECK_APP_THREAD(mathOperandCoef(mathSource1, &k.a1, &k.b1));
+        ECHECK_APP_THREAD(mathOperandCoef(mathSource2, &k.a2, &k.b2));
+        k.d = scaleAmplitude(0, math_ampScale, 1, math_ampOffset, invertFactor);
+        k.c = scaleAmplitude(1, math_ampScale, 1, math_ampOffset, invertFactor) - k.d;
+
+        uint32_t size = (viewEndPos > viewStartPos) ? viewEndPos - viewStartPos : 0;
+        const float *x = &view[mathSource1*viewSize + viewStartPos];
+        const float *y = &view[mathSource2*viewSize + viewStartPos];
+        float *out = &view[RPAPP_OSC_SOUR_MATH*viewSize + viewStartPos];
+
         if (operation == RPAPP_OSC_MATH_DER) {
-            calculateDevivative(mathSource1, math_ampScale, math_ampOffset, invertFactor);
+            mop_Derivative(x, out, size, &k, 2*timeScale / 1000 / samplesPerDivision);
         } else if (operation == RPAPP_OSC_MATH_INT) {
-            calculateIntegral(mathSource1, math_ampScale, math_ampOffset, invertFactor);
+            mop_Integral(x, out, size, &k, timeScale / samplesPerDivision);
+        } else if (operation == RPAPP_OSC_MATH_FFT) {
+            ECHECK_APP_THREAD(mop_FftMagnitude(x, out, size, &k));
         } else {
-            float v1, v2;
-            bool invert1 = (mathSource1 == RP_CH_1) ? ch1_inverted : ch2_inverted;
-            bool invert2 = (mathSource2 == RP_CH_1) ? ch1_inverted : ch2_inverted;
-            float sign1 = invert1 ? -1.f : 1.f;
-            float sign2 = invert2 ? -1.f : 1.f;
-            
-            for (int i = viewStartPos; i < viewEndPos; ++i) {
-                ECHECK_APP_THREAD(unscaleAmplitudeChannel((rpApp_osc_source) mathSource1, view[mathSource1*viewSize + i], &v1));
-                ECHECK_APP_THREAD(unscaleAmplitudeChannel((rpApp_osc_source) mathSource2, view[mathSource2*viewSize + i], &v2));
-
-                ECHECK_APP_THREAD(attenuateAmplitudeChannel((rpApp_osc_source) mathSource1, v1, &v1));
-                ECHECK_APP_THREAD(attenuateAmplitudeChannel((rpApp_osc_source) mathSource2, v2, &v2));
-
-                view[RPAPP_OSC_SOUR_MATH*viewSize + i] = scaleAmplitude(calculateMath(sign1 * v1, sign2 * v2, operation), math_ampScale, 1, math_ampOffset, invertFactor);
+            mop_binary_fn kernel = mop_SelectBinary(operation);
+            if (kernel != NULL) {
+                kernel(x, y, out, size, &k);
             }
         }
         scaleMath();
     }
 }
 
-void checkAutoscale(bool fromThread) {
+/* Autoscale from one capture at AUTO_SCALE_FAST_SCALE: at full sample rate nothing
+ * aliases, and periods up to half the capture are resolved. Only when no channel has
+ * a period and some crosses its mid level less than twice, one more capture is made at
+ * AUTO_SCALE_SLOW_SCALE. After osc_autoScale() only the worker thread changes this state. */
+typedef enum {
+    AUTOSCALE_FAST,
+    AUTOSCALE_SLOW
+} autoscale_capture_t;
+
+static const float autoScaleScales[] = { AUTO_SCALE_FAST_SCALE, AUTO_SCALE_SLOW_SCALE };
+static autoscale_capture_t autoScaleCapture = AUTOSCALE_FAST;
+static volatile bool autoScaleApply = false;
+static bool autoScaleRefine[2];
+static float autoScaleSaved;
+static float autoScaleLow[2], autoScaleHigh[2], autoScalePeriod[2];
+
+static void autoscaleStart() {
     pthread_mutex_lock(&mutex);
-    if((autoScale == false) && (fromThread == true))
-    {
-        pthread_mutex_unlock(&mutex);
-        return;
+    if (!autoScale) {
+        osc_getTimeScale(&autoScaleSaved);
+        autoScaleCapture = AUTOSCALE_FAST;
+        autoScaleApply = true;
+        autoScale = true;
     }
-    
-    static const float scales[AUTO_SCALE_NUM_OF_SCALE] = {0.00005f, 0.0001f, 0.0002f, 0.0005f, 0.001f, 0.002f, 0.005f, 0.01f, 0.02f, 0.05f, 0.1f, 0.2f, 0.5f, 1.f, 2.f, 5.f, 10.f, 20.f, 50.f, 100.f};
-    static int timeScaleIdx = 0;
-    static float periods[2][AUTO_SCALE_NUM_OF_SCALE];
-    static float vpps[2][AUTO_SCALE_NUM_OF_SCALE];
-    static float vMeans[2][AUTO_SCALE_NUM_OF_SCALE];
-    static float savedTimeScale;
-    static int measCount;
-    
-    float period, vpp, vMean;
-    int ret;
-    
-    int periodsIdx[2];
-    int repCounts[2];
+    pthread_mutex_unlock(&mutex);
+    signalWorker();
+}
 
-    int vMeansIdx[2];
-    int vMeansRepCounts[2];
-    
-    float period_to_set = 1.f;
-    
-    if(!fromThread) {
-        if(autoScale) {
-            pthread_mutex_unlock(&mutex);
-            return;
-        }
+/* Sets the time scale of the pending capture; the change clears the view, so the
+ * worker restarts the acquisition and the next frame is taken with it */
+static void autoscaleApplyCapture() {
+    pthread_mutex_lock(&mutex);
+    autoScaleApply = false;
+    ECHECK_APP_THREAD(osc_setTimeScale(autoScaleScales[autoScaleCapture]));
+    ECHECK_APP_THREAD(osc_setTimeOffset(AUTO_SCALE_TIME_OFFSET));
+    pthread_mutex_unlock(&mutex);
+}
 
-        autoScale = true;
-        osc_getTimeScale(&savedTimeScale);
-        timeScaleIdx = 0;
-        period_to_set = scales[timeScaleIdx];
-        measCount = 0;
-    } else {
-        if(++measCount < 2) {
-            pthread_mutex_unlock(&mutex);
-            return;
+static void autoscaleFinish() {
+    float period = 0;
+    for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= RPAPP_OSC_SOUR_CH2; ++source) {
+        if (autoScalePeriod[source] > 0) {
+            period = (period > 0) ? MIN(period, autoScalePeriod[source]) : autoScalePeriod[source];
         }
-        
-        measCount = 0;
-            
-        for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= RPAPP_OSC_SOUR_CH2; ++source) {
-            ECHECK_APP_THREAD(osc_measureVpp(source, &vpp));
-            ECHECK_APP_THREAD(osc_measureMeanVoltage(source, &vMean));
+    }
+    float period_to_set = (period > 0) ? period * AUTO_SCALE_PERIOD_COUNT / DIVISIONS_COUNT_X : autoScaleSaved;
+    period_to_set = MAX(0.0001f, period_to_set);
+    period_to_set = MIN(500.f, period_to_set);
+
+    for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= RPAPP_OSC_SOUR_CH2; ++source) {
+        float probeAtt;
+        bool inverted;
+        ECHECK_APP_THREAD(osc_getProbeAtt((rp_channel_t) source, &probeAtt));
+        ECHECK_APP_THREAD(osc_isInverted(source, &inverted));
+        float vpp = (autoScaleHigh[source] - autoScaleLow[source]) * probeAtt;
+        float vMid = (autoScaleHigh[source] + autoScaleLow[source]) / 2.f * probeAtt * (inverted ? -1 : 1);
+        ECHECK_APP_THREAD(scaleChannel(source, vpp, vMid));
+    }
 
-            if (fabs(vpp) > SIGNAL_EXISTENCE) {
-                ret = osc_measurePeriod(source, &period);
-                periods[source][timeScaleIdx] = (ret == RP_OK) ? period : 0.f;
-            } else {
-                periods[source][timeScaleIdx] = 0.f;
-            }
+    autoScale = false;
+    ECHECK_APP_THREAD(osc_setTimeScale(period_to_set));
+    ECHECK_APP_THREAD(osc_setTimeOffset(AUTO_SCALE_TIME_OFFSET));
+}
 
-            vpps[source][timeScaleIdx] = vpp;
-            vMeans[source][timeScaleIdx] = vMean;
-        }
+/* Takes levels and period of each channel from a capture of size samples made at
+ * captureScale, then either finishes or asks for the refinement capture */
+static void threadAutoscale(thread_data_t data, uint32_t size, float captureScale) {
+    pthread_mutex_lock(&mutex);
+    if (!autoScale || autoScaleApply) {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+    if (captureScale != autoScaleScales[autoScaleCapture]) {
+        // time scale changed meanwhile, capture again
+        autoScaleApply = true;
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
 
-        if(++timeScaleIdx >= AUTO_SCALE_NUM_OF_SCALE) {
-            autoScale = false;
+    const float sampleTime = indexToTime(1);
+    bool slow[2] = { false, false }, periodic = false;
+    for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= RPAPP_OSC_SOUR_CH2; ++source) {
+        if (autoScaleCapture == AUTOSCALE_SLOW && !autoScaleRefine[source]) {
+            continue;
+        }
 
-            for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= RPAPP_OSC_SOUR_CH2; ++source) {
-                repCounts[source] = 0;
-                vMeansRepCounts[source] = 0;
-                
-                for(int i = (AUTO_SCALE_NUM_OF_SCALE - 1); i >= 1; --i) {
-                    int count = 0;
+        float probeAtt;
+        meas_shape_t shape;
+        ECHECK_APP_THREAD(osc_getProbeAtt((rp_channel_t) source, &probeAtt));
+        meas_Shape(data[source], size, AUTO_SCALE_HIST_TAIL, &shape);
+        autoScaleLow[source] = shape.low;
+        autoScaleHigh[source] = shape.high;
+        autoScalePeriod[source] = 0;
+        if ((shape.high - shape.low) * probeAtt <= SIGNAL_EXISTENCE) {
+            continue;
+        }
+        if (shape.crossings < 2) {
+            slow[source] = true;
+            continue;
+        }
 
-                    for(int j = (i - 1); j >= 0; --j) {
-                        if(fabs((vMeans[source][i] - vMeans[source][j]) / vMeans[source][i]) < AUTO_SCALE_VMEAN_ERROR)
-                            count++;
-                    }
+        // noise may break up the mid level crossings, try the slower estimators
+        float period = shape.period;
+        if (period == 0 && meas_Period(data[source], size, &period) != RP_OK) {
+            period = 0;
+        }
+        autoScalePeriod[source] = period * sampleTime;
+        periodic |= period > 0;
+    }
 
-                    if(count > vMeansRepCounts[source]) {
-                        vMeansRepCounts[source] = count;
-                        vMeansIdx[source] = i;
-                    }
-                    
-                    count = 0;
-                    if(fabs(periods[source][i])  < 0.00001)
-                        continue;
+    if (autoScaleCapture == AUTOSCALE_FAST && !periodic && (slow[0] || slow[1])) {
+        autoScaleCapture = AUTOSCALE_SLOW;
+        autoScaleRefine[0] = slow[0];
+        autoScaleRefine[1] = slow[1];
+        autoScaleApply = true;
+    } else {
+        autoscaleFinish();
+    }
+    pthread_mutex_unlock(&mutex);
+}
 
-                    for(int j = (i - 1); j >= 0; --j) {
-                        if(fabs(periods[source][j])  < 0.00001)
-                            continue;
+/* Min/max pyramid of the cached capture, see cmn_PyramidBuild(). Built on the first
+ * peak-detect redraw of a capture, only the worker thread touches it. */
+static float pyramidMin[2][ADC_BUFFER_SIZE];
+static float pyramidMax[2][ADC_BUFFER_SIZE];
+static uint32_t pyramidCapture = 0, captureId = 0;
+
+/* Renders a capture of both channels into the back view: column i shows the capture
+ * at sample position x0 + i*delta, columns outside the capture are cleared. In peak-detect
+ * mode column i also gets the extremes of [x(i), x(i+1)). Call locked. */
+static void renderFrame(thread_data_t data, uint32_t size, float x0, float delta, bool usePyramid) {
+    int first = 0, last = 0;
+    if (size > 0) {
+        first = (x0 < 0.f) ? (int) MIN(ceilf(-x0 / delta), (float) viewSize) : 0;
+        while (first < viewSize && x0 + (float)first * delta < 0.f) {
+            ++first;
+        }
+        last = first;
+        while (last < viewSize && (int) (x0 + (float)last * delta) < (int) size) {
+            ++last;
+        }
+    }
+    bool envelope = peakDetect && delta >= 1.0f;
 
-                        if(fabs((periods[source][i] - periods[source][j]) / periods[source][i]) < AUTO_SCALE_PERIOD_ERROR)
-                            count++;
-                    }
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        const float *src = data[channel];
+        float *dst = &view[channel * viewSize];
+        float *dstMin = &viewMin[channel * viewSize], *dstMax = &viewMax[channel * viewSize];
+        float gain, offset;
+        ECHECK_APP_THREAD(scaleAmplitudeCoefChannel((rpApp_osc_source) channel, &gain, &offset));
+
+        for (int i = 0; i < first; ++i) {
+            dst[i] = dstMin[i] = dstMax[i] = 0.f;
+        }
+        for (int i = last; i < viewSize; ++i) {
+            dst[i] = dstMin[i] = dstMax[i] = 0.f;
+        }
 
-                    if(count > repCounts[source]) {
-                        repCounts[source] = count;
-                        periodsIdx[source] = i;
-                    }
-                }
-            }
-            
-            if((repCounts[0] >= PERIOD_REP_COUNT_MIN) && (repCounts[1] >= PERIOD_REP_COUNT_MIN)) {
-                period_to_set = MIN(periods[0][periodsIdx[0]], periods[1][periodsIdx[1]]);
-                period_to_set = period_to_set * AUTO_SCALE_PERIOD_COUNT / DIVISIONS_COUNT_X;
-            } else if(repCounts[0] > 0) {
-                period_to_set = periods[0][periodsIdx[0]] * AUTO_SCALE_PERIOD_COUNT / DIVISIONS_COUNT_X;
-            } else if(repCounts[1] > 0) {
-                period_to_set = periods[1][periodsIdx[1]] * AUTO_SCALE_PERIOD_COUNT / DIVISIONS_COUNT_X;                
-            } else {
-                period_to_set = savedTimeScale;
+        if (delta < 1.0f && interpolation == RPAPP_OSC_INTERP_SINC) {
+            interp_Sinc(src, size, x0, delta, first, last, gain, offset, dst);
+        } else if (delta < 1.0f) {
+            for (int i = first; i < last; ++i) {
+                float x = x0 + (float)i * delta;
+                int xa = (int) x;
+                int xb = MIN(xa + 1, (int) size - 1);
+                dst[i] = linear(xa, src[xa], xa + 1, src[xb], x) * gain + offset;
             }
-            
-            period_to_set = MAX(0.0001f, period_to_set);
-            period_to_set = MIN(500.f, period_to_set);
-            
-            for (rpApp_osc_source source = RPAPP_OSC_SOUR_CH1; source <= RPAPP_OSC_SOUR_CH2; ++source) {
-                vpp = vpps[source][0];
-                for(int i = 1; i < AUTO_SCALE_NUM_OF_SCALE; ++i) {
-                    vpp = MAX(vpp, vpps[source][i]);
-                }
-
-                if(vMeansRepCounts[source] >= VMEAN_REP_COUNT_MIN) {
-                    vMean = vMeans[source][vMeansIdx[source]];
+        } else if (envelope) {
+            for (int i = first; i < last; ++i) {
+                int lo = (int) (x0 + (float)i * delta);
+                int hi = MIN((int) (x0 + (float)(i + 1) * delta), (int) size);
+                float mn, mx;
+                if (usePyramid) {
+                    cmn_PyramidMinMax(src, pyramidMin[channel], pyramidMax[channel], size, lo, MAX(hi, lo + 1), &mn, &mx);
                 } else {
-                    vMean = vMeans[source][0];
-
-                    for(int i = 1; i < AUTO_SCALE_NUM_OF_SCALE; ++i) {
-                        if(fabs(vMean) > fabs(vMeans[source][i])) {
-                            vMean = vMeans[source][i];
-                        }
-                    }
+                    cmn_MinMax(&src[lo], MAX(hi - lo, 1), &mn, &mx);
                 }
-                
-                ECHECK_APP_THREAD(scaleChannel(source, vpp, vMean));
+                mn = mn * gain + offset;
+                mx = mx * gain + offset;
+                dst[i] = src[lo] * gain + offset;
+                dstMin[i] = MIN(mn, mx);
+                dstMax[i] = MAX(mn, mx);
             }
         } else {
-            period_to_set = scales[timeScaleIdx];
+            for (int i = first; i < last; ++i) {
+                dst[i] = src[(int) (x0 + (float)i * delta)] * gain + offset;
+            }
         }
     }
-    ECHECK_APP_THREAD(osc_setTimeScale(period_to_set));
-    ECHECK_APP_THREAD(osc_setTimeOffset(AUTO_SCALE_TIME_OFFSET));
-    pthread_mutex_unlock(&mutex);
+
+    envelopeValid = envelope;
+    viewStartPos = first;
+    viewEndPos = last;
+    ++viewGeneration;
 }
 
-static inline void threadUpdateView(thread_data_t data, uint32_t _getBufSize, float _deltaSample, float _timeScale, float _lastTimeScale, float _lastTimeOffset) {
+/* Redraws the cached capture for the current time scale and offset, without touching
+ * the acquisition. The capture was taken with _deltaSample samples per column and its
+ * column 0 at sample _frameFirst. */
+static inline void threadUpdateView(thread_data_t data, uint32_t _getBufSize, float _frameFirst, float _deltaSample, float _timeScale, float _lastTimeScale, float _lastTimeOffset) {
     pthread_mutex_lock(&mutex);
     updateView = false;
 
@@ -1333,63 +1779,173 @@ static inline void threadUpdateView(thread_data_t data, uint32_t _getBufSize, fl
         pthread_mutex_unlock(&mutex);
         return;
     }
-    
+
     float curDeltaSample = _deltaSample * (_timeScale / _lastTimeScale);
-    int requiredBuffSize = viewSize * curDeltaSample;
-    int bufferEars = ((int)_getBufSize - requiredBuffSize) / 2;
-    int viewEars = -MIN(bufferEars / curDeltaSample, 0);
-    bufferEars = MAX(0, bufferEars);
-    int viewOffset = ((_lastTimeOffset - timeOffset) * (float)samplesPerDivision) / _timeScale;
-    int buffOffset = viewOffset * curDeltaSample;
-
-    if(viewEars) {
-        buffOffset = 0;
-    } else {
-        if(bufferEars < abs(buffOffset)) {
-            viewOffset = (abs(buffOffset) - bufferEars) * sign(buffOffset) / curDeltaSample;
-            buffOffset = bufferEars * sign(buffOffset);
-        } else {
-            viewOffset = 0;
+    float panSamples = (timeOffset - _lastTimeOffset) * (float)samplesPerDivision / _lastTimeScale * _deltaSample;
+    float centre = _frameFirst + ((float)viewSize / 2.f) * _deltaSample + panSamples;
+    bool usePyramid = peakDetect && curDeltaSample >= PYRAMID_MIN_DELTA;
+
+    if (usePyramid && pyramidCapture != captureId) {
+        for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+            cmn_PyramidBuild(data[channel], _getBufSize, pyramidMin[channel], pyramidMax[channel]);
         }
+        pyramidCapture = captureId;
     }
-    int maxViewIdx = MIN(viewSize, (viewSize - 2*viewEars));
-    int buffFullOffset = bufferEars - buffOffset;
+    renderFrame(data, _getBufSize, centre - ((float)viewSize / 2.f) * curDeltaSample, curDeltaSample, usePyramid);
 
-    // Write data to view buffer
-    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
-        int viewFullOffset = (channel * viewSize) + viewEars + viewOffset;
-        for(int i = 0; i < viewEars + viewOffset; ++i) {
-            view[(int)channel * viewSize + i] = 0.f;
-        }
+    mathThreadFunction();
+    publishView();
+    pthread_mutex_unlock(&mutex);
+}
 
-        for(int i = 0; i < viewEars - viewOffset; ++i) {
-            view[(int)channel * viewSize + viewSize - i - 1] = 0.f;
-        }
-                
-        if(curDeltaSample < 1.0f) {
-            int i;
-            for (i = 0; i < maxViewIdx && (int) (((float)i * curDeltaSample) + buffFullOffset) < _getBufSize; ++i) {
-                int x0 = (int)((float)i * curDeltaSample) + buffFullOffset;
-                int x1 = MIN((x0 + 1) , (_getBufSize - 1));
-                float y = linear(x0, data[channel][x0], x0 + 1, data[channel][x1], ((float)i * curDeltaSample) + buffFullOffset);
-                ECHECK_APP_THREAD(scaleAmplitudeChannel((rpApp_osc_source) channel, y, view + viewFullOffset + i));
+/* Roll mode: at slow time scales in auto sweep the view scrolls instead of waiting for a
+ * triggered buffer to fill. The acquisition runs untriggered with arm keep and every
+ * ROLL_MODE_PERIOD the samples written since the last tick are reduced to min/max columns
+ * of a ring holding one screen, newest column at the right edge. The ring keeps volts,
+ * so amplitude changes only redraw it. Only the worker thread touches it. */
+static float rollVal[2][ADC_BUFFER_SIZE];
+static float rollMin[2][ADC_BUFFER_SIZE];
+static float rollMax[2][ADC_BUFFER_SIZE];
+static float colVal[2], colMin[2], colMax[2];
+static bool colStarted;
+static uint32_t rollHead, rollCount, rollSize, rollWp;
+static uint64_t rollColumns, rollSamples;
+static float rollDelta, rollScale;
+static double rollTick;
+static bool rolling = false;
+
+static inline bool rollActive(float _timeScale) {
+    return rollMode && trigSweep == RPAPP_OSC_TRIG_AUTO && !autoScale
+            && _timeScale >= ROLL_MODE_SCALE_THRESHOLD && viewSize <= ADC_BUFFER_SIZE;
+}
+
+static void rollStart(float _timeScale) {
+    ECHECK_APP_THREAD(rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED));
+    ECHECK_APP_THREAD(threadSafe_acqStart());
+    ECHECK_APP_THREAD(rp_AcqGetWritePointer(&rollWp));
+    rollDelta = MAX((float)timeToIndex(_timeScale) / samplesPerDivision, 1.f);
+    rollScale = _timeScale;
+    rollSize = viewSize;
+    rollHead = rollCount = 0;
+    rollColumns = rollSamples = 0;
+    colStarted = false;
+    rollTick = _clock();
+    rolling = true;
+}
+
+// Column c covers samples [c*rollDelta, (c+1)*rollDelta) counted from the roll start
+static void rollAppend(thread_data_t data, uint32_t n) {
+    uint32_t i = 0;
+    while (i < n) {
+        uint64_t end = (uint64_t) ((double)(rollColumns + 1) * rollDelta);
+        uint32_t take = (uint32_t) MIN(end - rollSamples, (uint64_t) (n - i));
+        for (int ch = 0; ch < 2; ++ch) {
+            float mn, mx;
+            cmn_MinMax(&data[ch][i], take, &mn, &mx);
+            if (!colStarted) {
+                colVal[ch] = data[ch][i];
+                colMin[ch] = mn;
+                colMax[ch] = mx;
+            } else {
+                colMin[ch] = MIN(colMin[ch], mn);
+                colMax[ch] = MAX(colMax[ch], mx);
             }
-            maxViewIdx = i;
-        } else {
-            int i;
-            for (i = 0; i < maxViewIdx && (int) (((float)i * curDeltaSample) + buffFullOffset) < _getBufSize; ++i) {
-                ECHECK_APP_THREAD(scaleAmplitudeChannel((rpApp_osc_source) channel, data[channel][(int) ((float)i * curDeltaSample) + buffFullOffset], view + viewFullOffset + i));
+        }
+        colStarted = true;
+        rollSamples += take;
+        i += take;
+
+        if (rollSamples == end) {
+            for (int ch = 0; ch < 2; ++ch) {
+                rollVal[ch][rollHead] = colVal[ch];
+                rollMin[ch][rollHead] = colMin[ch];
+                rollMax[ch][rollHead] = colMax[ch];
             }
-            maxViewIdx = i;
+            rollHead = (rollHead + 1) % rollSize;
+            rollCount = MIN(rollCount + 1, rollSize);
+            ++rollColumns;
+            colStarted = false;
+        }
+    }
+}
+
+// Draws the ring right aligned into the back view, with the column extremes as envelope. Call locked.
+static void renderRoll() {
+    uint32_t first = viewSize - rollCount;
+    for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
+        float *dst = &view[channel * viewSize];
+        float *dstMin = &viewMin[channel * viewSize], *dstMax = &viewMax[channel * viewSize];
+        float gain, offset;
+        ECHECK_APP_THREAD(scaleAmplitudeCoefChannel((rpApp_osc_source) channel, &gain, &offset));
+
+        for (int i = 0; i < first; ++i) {
+            dst[i] = dstMin[i] = dstMax[i] = 0.f;
+        }
+        for (uint32_t j = 0; j < rollCount; ++j) {
+            uint32_t slot = (rollHead + rollSize - rollCount + j) % rollSize;
+            float mn = rollMin[channel][slot] * gain + offset;
+            float mx = rollMax[channel][slot] * gain + offset;
+            dst[first + j] = rollVal[channel][slot] * gain + offset;
+            dstMin[first + j] = MIN(mn, mx);
+            dstMax[first + j] = MAX(mn, mx);
         }
     }
-    viewStartPos = viewEars + viewOffset;
-    viewEndPos = viewStartPos + maxViewIdx;
 
+    envelopeValid = rollCount > 0;
+    viewStartPos = first;
+    viewEndPos = viewSize;
+    ++viewGeneration;
+}
+
+static void rollRedraw() {
+    pthread_mutex_lock(&mutex);
+    updateView = false;
+    renderRoll();
     mathThreadFunction();
+    publishView();
     pthread_mutex_unlock(&mutex);
 }
 
+/* One roll tick: sleeps until ROLL_MODE_PERIOD after the previous read, view changes
+ * wake it earlier, then appends what the ADC wrote meanwhile and redraws */
+static void threadRoll(thread_data_t data, float _timeScale) {
+    if (!rolling || rollScale != _timeScale || rollSize != viewSize) {
+        rollStart(_timeScale);
+    } else {
+        double next = rollTick + ROLL_MODE_PERIOD;
+        pthread_mutex_lock(&mutex);
+        pthread_cleanup_push(unlockMutex, &mutex);
+        if (!clear && !updateView && next > _clock()) {
+            struct timespec deadline = {
+                .tv_sec = (time_t) (next / 1000.0),
+                .tv_nsec = (long) (fmod(next, 1000.0) * 1000000.0)
+            };
+            pthread_cond_timedwait(&workerEvent, &mutex, &deadline);
+        }
+        clear = false;
+        pthread_cleanup_pop(1);
+    }
+
+    uint32_t wp, n;
+    float rate;
+    double now = _clock();
+    ECHECK_APP_THREAD(rp_AcqGetWritePointer(&wp));
+    n = (wp - rollWp) % ADC_BUFFER_SIZE;
+    // After a stall or a stop the buffer may have wrapped, continue from the present
+    if (rp_AcqGetSamplingRateHz(&rate) == RP_OK && (now - rollTick) * rate / 1000.0 >= ADC_BUFFER_SIZE) {
+        n = 0;
+        rollWp = wp;
+    }
+    rollTick = now;
+
+    if (n > 0) {
+        ECHECK_APP_THREAD(rp_AcqGetDataV2((rollWp + 1) % ADC_BUFFER_SIZE, &n, data[0], data[1]));
+        rollAppend(data, n);
+        rollWp = (rollWp + n) % ADC_BUFFER_SIZE;
+    }
+    rollRedraw();
+}
+
 int RestartAcq(float _timeScale) {
 	ECHECK_APP_THREAD(rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED));
 	ECHECK_APP_THREAD(threadSafe_acqStart());
@@ -1411,7 +1967,7 @@ void *mainThreadFun() {
     rp_acq_trig_state_t _state;
     uint32_t _triggerPosition, _getBufSize = 0, _startIndex, _preTriggerCount, _writePointer;
     int _triggerDelay, _preZero, _postZero;
-    float _deltaSample, _timeScale, _lastTimeScale, _lastTimeOffset;
+    float _deltaSample, _timeScale, _lastTimeScale, _lastTimeOffset, _frameFirst = 0.f;
     thread_data_t data;
     bool thisLoopAcqStart, manuallyTriggered = false;
 
@@ -1419,19 +1975,47 @@ void *mainThreadFun() {
     threadTimer = _clock() + MAX(0.1f, (2.f * _timeScale * (float)DIVISIONS_COUNT_X));
     
     while (true) {
-        do{
-            if(updateView) {
-                ECHECK_APP_THREAD(osc_getTimeScale(&_timeScale));
-                threadUpdateView(data, _getBufSize, _deltaSample, _timeScale, _lastTimeScale, _lastTimeOffset);
+        // Sleep while stopped, waking only to redraw the last frame
+        while (true) {
+            bool idle;
+            pthread_mutex_lock(&mutex);
+            pthread_cleanup_push(unlockMutex, &mutex);
+            while ((!oscRunning || !acqRunning) && !updateView) {
+                pthread_cond_wait(&workerEvent, &mutex);
             }
-            
-            pthread_testcancel();
-        }while(!oscRunning || !acqRunning);
+            idle = !oscRunning || !acqRunning;
+            pthread_cleanup_pop(1);
+
+            if (!idle) {
+                break;
+            }
+            ECHECK_APP_THREAD(osc_getTimeScale(&_timeScale));
+            if (rolling) {
+                rollRedraw();
+            } else {
+                threadUpdateView(data, _getBufSize, _frameFirst, _deltaSample, _timeScale, _lastTimeScale, _lastTimeOffset);
+            }
+        }
 
         thisLoopAcqStart = false;
 
+        if (autoScaleApply) {
+            autoscaleApplyCapture();
+        }
         ECHECK_APP_THREAD(osc_getTimeScale(&_timeScale));
 
+        // Roll mode has its own pace, the chunks it reads replace the cached capture
+        if (rollActive(_timeScale)) {
+            if (!rolling) {
+                _getBufSize = 0;
+            }
+            threadRoll(data, _timeScale);
+            continue;
+        } else if (rolling) {
+            rolling = false;
+            RestartAcq(_timeScale);
+        }
+
         if (clear && acqRunning) {
 			RestartAcq(_timeScale);
 			manuallyTriggered = false;
@@ -1447,11 +2031,22 @@ void *mainThreadFun() {
             manuallyTriggered = false;
         }
 
+        // Sleep until trigger or sweep timeout instead of spinning
+        if (acqRunning && !updateView && !clear) {
+            double _waitTime = MIN(threadTimer - _clock(), WAIT_TRIGGER_MAX_TIMEOUT);
+            if (_waitTime > 0) {
+                int _ret = rp_AcqWaitTrigger((int64_t) (_waitTime * 1e6));
+                if (_ret != RP_ETMO) {
+                    ECHECK_APP_THREAD(_ret);
+                }
+            }
+        }
+
         ECHECK_APP_THREAD(rp_AcqGetTriggerSrc(&_triggerSource));
         ECHECK_APP_THREAD(rp_AcqGetTriggerState(&_state));
 
         if(updateView && !((_state == RP_TRIG_STATE_TRIGGERED) || (_triggerSource == RP_TRIG_SRC_DISABLED))) {
-            threadUpdateView(data, _getBufSize, _deltaSample, _timeScale, _lastTimeScale, _lastTimeOffset);
+            threadUpdateView(data, _getBufSize, _frameFirst, _deltaSample, _timeScale, _lastTimeScale, _lastTimeOffset);
             
         } else if ((_state == RP_TRIG_STATE_TRIGGERED) || (_triggerSource == RP_TRIG_SRC_DISABLED)) {
             EXECUTE_ATOMICALLY(mutex, updateView = false);
@@ -1460,7 +2055,8 @@ void *mainThreadFun() {
             ECHECK_APP_THREAD(rp_AcqGetTriggerDelay(&_triggerDelay));
             ECHECK_APP_THREAD(rp_AcqGetPreTriggerCounter(&_preTriggerCount));
 
-            if((_state == RP_TRIG_STATE_TRIGGERED) && (_triggerSource != RP_TRIG_SRC_DISABLED)) {
+            // The trigger source reads disabled once the trigger came, the state tells it came
+            if (_state == RP_TRIG_STATE_TRIGGERED) {
                 waitToFillAfterTriggerBuffer(true);
             }
 
@@ -1479,8 +2075,27 @@ void *mainThreadFun() {
                 ECHECK_APP_THREAD(rp_AcqGetWritePointer(&_writePointer));
                 _startIndex = (_writePointer - _getBufSize) % ADC_BUFFER_SIZE;
             }
+            // A capture that stays on screen (single sweep, or acquisition stopped) keeps everything
+            // the buffer holds around it for zoom and pan
+            uint32_t _leftAvail = 0, _rightAvail = 0;
+            if (trigSweep == RPAPP_OSC_TRIG_SINGLE || !oscRunning || !acqRunning) {
+                ECHECK_APP_THREAD(rp_AcqGetWritePointer(&_writePointer));
+                uint32_t _valid = MIN(ADC_BUFFER_SIZE - 1, _preTriggerCount + (_writePointer - _triggerPosition) % ADC_BUFFER_SIZE);
+                uint32_t _oldest = (_writePointer - _valid) % ADC_BUFFER_SIZE;
+                uint32_t _windowStart = (_startIndex - _oldest) % ADC_BUFFER_SIZE;
+                if (_windowStart < _valid) {
+                    _leftAvail = MIN(_windowStart, ADC_BUFFER_SIZE - _getBufSize);
+                    if (_windowStart + _getBufSize < _valid) {
+                        _rightAvail = _valid - (_windowStart + _getBufSize);
+                    }
+                }
+            }
+            _frameFirst = (float) _leftAvail;
+            _getBufSize += _leftAvail + _rightAvail;
+
             // Get data
-            ECHECK_APP_THREAD(rp_AcqGetDataV2(_startIndex, &_getBufSize, data[0], data[1]));
+            ECHECK_APP_THREAD(rp_AcqGetDataV2((_startIndex - _leftAvail) % ADC_BUFFER_SIZE, &_getBufSize, data[0], data[1]));
+            ++captureId;
 
             if (trigSweep == RPAPP_OSC_TRIG_SINGLE) {
                 ECHECK_APP_THREAD(threadSafe_acqStop());
@@ -1511,33 +2126,20 @@ void *mainThreadFun() {
 
             pthread_mutex_lock(&mutex);
             // Write data to view buffer
-            for (rp_channel_t channel = RP_CH_1; channel <= RP_CH_2; ++channel) {
-                // first preZero data are wrong - from previout trigger. Last preZero data hasn't been overwritten
-//                for (int i = 0; i < _preZero; ++i) {
-//                    view[channel * viewSize + i] = 0;
-//                }
-                if(_deltaSample < 1.0f) {
-                    for (int i = 0; i < viewSize-_postZero && (int) ((float)i * _deltaSample) < _getBufSize; ++i) {
-                        int x0 = (int)((float)i * _deltaSample);
-                        int x1 = ((x0 + 1) < (_getBufSize - 1)) ? (x0 + 1) : (_getBufSize - 1);
-                        float y = linear(x0, data[channel][x0], x0 + 1, data[channel][x1], ((float)i * _deltaSample));
-                        ECHECK_APP_THREAD(scaleAmplitudeChannel((rpApp_osc_source) channel, y, view + ((channel * viewSize) + i + _preZero)));
-                    }
-                } else {
-                    for (int i = 0; i < viewSize-_postZero && (int) ((float)i * _deltaSample) < _getBufSize; ++i) {
-                        ECHECK_APP_THREAD(scaleAmplitudeChannel((rpApp_osc_source) channel, data[channel][(int) ((float)i * _deltaSample)], view + ((channel * viewSize) + i + _preZero)));
-                    }
-                }
-            }
-
-            viewStartPos = 0;
-            viewEndPos = viewSize;
+            renderFrame(data, _getBufSize, _frameFirst, _deltaSample, false);
 
             mathThreadFunction();
+            if (!autoScale) {
+                updatePersistence();
+            }
+            publishView();
             pthread_mutex_unlock(&mutex);
 
             manuallyTriggered = false;
-            checkAutoscale(true);
+            if (!autoScale) {
+                updateMeasureStatistics();
+            }
+            threadAutoscale(data, _getBufSize, _lastTimeScale);
         }
 
         if (thisLoopAcqStart) {
@@ -26,18 +26,22 @@
 #define AUTO_SCALE_PERIOD_COUNT       2
 #define AUTO_SCALE_AMP_SCA_FACTOR     1.05
 #define AUTO_SCALE_TIME_OFFSET        0
-#define AUTO_SCALE_PERIOD_ERROR       0.08
-#define AUTO_SCALE_VMEAN_ERROR        0.08
-#define AUTO_SCALE_NUM_OF_SCALE       20
+#define AUTO_SCALE_FAST_SCALE         0.01f // ms/div, decimation 1, periods up to ~50 us
+#define AUTO_SCALE_SLOW_SCALE         10.f  // ms/div, decimation 1024, periods up to ~50 ms
+#define AUTO_SCALE_HIST_TAIL          0.001f // of the samples, ignored at each end of the histogram
 #define MAX_UINT                      4294967296
 #define MIN_TIME_TO_DRAW_BEFORE_TIG   100
 #define WAIT_TO_FILL_BUF_TIMEOUT      500.f //(2*CLOCKS_PER_SEC)
+#define WAIT_TRIGGER_MAX_TIMEOUT      20.f  // ms, bounds reaction time to view and sweep changes
 #define CONTIOUS_MODE_SCALE_THRESHOLD 1     // ms
+#define ROLL_MODE_SCALE_THRESHOLD     100.f // ms/div, slower time scales roll in auto sweep
+#define ROLL_MODE_PERIOD              50.0  // ms between roll view updates
+#define PERSIST_TIME_DEFAULT          1000.f // ms, decay time constant of the persistence image
+#define PERSIST_DECAY_PERIOD          100.0 // ms between decay steps of the persistence image
+#define PYRAMID_MIN_DELTA             16.f  // samples per column, below that a direct scan is cheaper
 #define PERIOD_EXISTS_MIN_THRESHOLD       0.75  // ratio
 #define PERIOD_EXISTS_MAX_THRESHOLD       0.92  // ratio
 #define PERIOD_EXISTS_PEAK_THRESHOLD      0.99  // ratio
-#define PERIOD_REP_COUNT_MIN          3
-#define VMEAN_REP_COUNT_MIN           3
 
 int osc_Init();
 int osc_Release();
@@ -72,6 +76,18 @@ int osc_setTriggerSweep(rpApp_osc_trig_sweep_t mode);
 int osc_getTriggerSweep(rpApp_osc_trig_sweep_t *mode);
 int osc_setInverted(rpApp_osc_source source, bool inverted);
 int osc_isInverted(rpApp_osc_source source, bool *inverted);
+int osc_setPeakDetect(bool enable);
+int osc_getPeakDetect(bool *enable);
+int osc_setInterpolation(rpApp_osc_interp_t interp);
+int osc_getInterpolation(rpApp_osc_interp_t *interp);
+int osc_setRollMode(bool enable);
+int osc_getRollMode(bool *enable);
+int osc_setPersistence(rpApp_osc_persist_t mode);
+int osc_getPersistence(rpApp_osc_persist_t *mode);
+int osc_setPersistenceTime(float time);
+int osc_getPersistenceTime(float *time);
+int osc_resetPersistence();
+int osc_getPersistenceImage(rpApp_osc_source source, uint8_t *image, uint32_t size);
 int osc_getViewPart(float *ratio);
 int osc_measureVpp(rpApp_osc_source source, float *Vpp);
 int osc_measureMeanVoltage(rpApp_osc_source source, float *meanVoltage);
@@ -81,12 +97,16 @@ int osc_measureFrequency(rpApp_osc_source source, float *frequency);
 int osc_measurePeriod(rpApp_osc_source source, float *period);
 int osc_measureDutyCycle(rpApp_osc_source source, float *dutyCycle);
 int osc_measureRootMeanSquare(rpApp_osc_source source, float *rms);
+int osc_resetMeasureStatistics();
+int osc_setMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, bool enabled);
+int osc_getMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, rpApp_osc_meas_stats_t *stats);
 int osc_getCursorVoltage(rpApp_osc_source source, uint32_t cursor, float *value);
 int osc_getCursorTime(uint32_t cursor, float *value);
 int osc_getCursorDeltaTime(uint32_t cursor1, uint32_t cursor2, float *value);
 int oscGetCursorDeltaAmplitude(rpApp_osc_source source, uint32_t cursor1, uint32_t cursor2, float *value);
 int osc_getCursorDeltaFrequency(uint32_t cursor1, uint32_t cursor2, float *value);
 int osc_getData(rpApp_osc_source source_t, float *data, uint32_t size);
+int osc_getEnvelope(rpApp_osc_source source, float *min, float *max, uint32_t size);
 int osc_setMathOperation(rpApp_osc_math_oper_t op);
 int osc_getMathOperation(rpApp_osc_math_oper_t *op);
 int osc_setMathSources(rp_channel_t source1, rp_channel_t source2);
@@ -99,6 +119,7 @@ int threadSafe_acqStart();
 int threadSafe_acqStop();
 double scaleAmplitude(double volts, double ampScale, double probeAtt, double ampOffset, double invertFactor);
 int scaleAmplitudeChannel(rpApp_osc_source source, float volts, float *res);
+int scaleAmplitudeCoefChannel(rpApp_osc_source source, float *gain, float *offset);
 double unscaleAmplitude(double value, double ampScale, double probeAtt, double ampOffset, double invertFactor);
 int unscaleAmplitudeChannel(rpApp_osc_source source, float value, float *res);
 int attenuateAmplitudeChannel(rpApp_osc_source source, float value, float *res);
@@ -107,9 +128,6 @@ float viewIndexToTime(int index);
 double roundUpTo125(double data);
 double roundUpTo25(double data);
 
-void calculateIntegral(rp_channel_t channel, float scale, float offset, float invertFactor);
-void calculateDevivative(rp_channel_t channel, float scale, float offset, float invertFactor);
-float calculateMath(float v1, float v2, rpApp_osc_math_oper_t op);
 double unOffsetAmplitude(double value, double ampScale, double ampOffset);
 int unscaleAmplitudeChannel(rpApp_osc_source source, float value, float *res);
 int unOffsetAmplitudeChannel(rpApp_osc_source source, float value, float *res);
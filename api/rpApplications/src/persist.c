@@ -0,0 +1,99 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library display persistence implementation
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#include <string.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "persist.h"
+
+/* Adds one hit to every bin the trace crosses in columns [start, end). Without an envelope
+ * column i spans from data[i] to data[i+1], so steep edges are drawn as lines. Values are
+ * in screen units, the screen covers [bottom, bottom + height). */
+void persist_Accumulate(uint16_t *image, const float *data, const float *min, const float *max,
+                        uint32_t start, uint32_t end, float bottom, float height) {
+    const float scale = (float) PERSIST_BINS / height;
+
+    for (uint32_t i = start; i < end; ++i) {
+        float lo, hi;
+        if (min != NULL) {
+            lo = min[i];
+            hi = max[i];
+        } else {
+            float next = (i + 1 < end) ? data[i + 1] : data[i];
+            lo = data[i] < next ? data[i] : next;
+            hi = data[i] < next ? next : data[i];
+        }
+
+        // bins stay in float until clipped, a trace far off screen must not overflow an int
+        float b0 = (lo - bottom) * scale;
+        float b1 = (hi - bottom) * scale;
+        if (!(b1 >= 0.f && b0 < (float) PERSIST_BINS)) {
+            continue;
+        }
+        int from = (b0 < 0.f) ? 0 : (int) b0;
+        int to = (b1 >= (float) PERSIST_BINS) ? PERSIST_BINS - 1 : (int) b1;
+
+        uint16_t *column = &image[i * PERSIST_BINS];
+        for (int b = from; b <= to; ++b) {
+            column[b] = (column[b] > PERSIST_MAX - PERSIST_HIT) ? PERSIST_MAX : column[b] + PERSIST_HIT;
+        }
+    }
+}
+
+/* Scales all counts by factor/65536 (factor below 65536), rounding down so that faded
+ * hits reach zero */
+void persist_Decay(uint16_t *image, uint32_t size, uint32_t factor) {
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint16x4_t f = vdup_n_u16((uint16_t) factor);
+    for (; i + 8 <= size; i += 8) {
+        uint16x8_t v = vld1q_u16(&image[i]);
+        uint32x4_t lo = vmull_u16(vget_low_u16(v), f);
+        uint32x4_t hi = vmull_u16(vget_high_u16(v), f);
+        vst1q_u16(&image[i], vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        image[i] = (uint16_t) (((uint32_t) image[i] * factor) >> 16);
+    }
+}
+
+/* 8 bit intensity image of PERSIST_BINS rows by columns, row 0 at the top of the screen.
+ * The most hit bin is 255 and any bin with hits left is at least 1. */
+void persist_Render(const uint16_t *image, uint32_t columns, uint8_t *out) {
+    const uint32_t size = columns * PERSIST_BINS;
+    uint16_t peak = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+        peak = (image[i] > peak) ? image[i] : peak;
+    }
+    if (peak == 0) {
+        memset(out, 0, size);
+        return;
+    }
+
+    // rounded up so the peak itself reaches 255
+    const uint32_t k = ((255u << 16) + peak - 1) / peak;
+    for (uint32_t c = 0; c < columns; ++c) {
+        const uint16_t *column = &image[c * PERSIST_BINS];
+        for (uint32_t b = 0; b < PERSIST_BINS; ++b) {
+            uint32_t v = (column[b] * k) >> 16;
+            v = (v > 255) ? 255 : v;
+            out[(PERSIST_BINS - 1 - b) * columns + c] = (uint8_t) ((column[b] != 0 && v == 0) ? 1 : v);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+/**
+* $Id: $
+*
+* @brief Red Pitaya application library display persistence interface
+*
+* @Author Red Pitaya
+*
+* (c) Red Pitaya  http://www.redpitaya.com
+*
+* This part of code is written in C programming language.
+* Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+* for more details on the language used herein.
+*/
+
+#ifndef __PERSIST_H
+#define __PERSIST_H
+
+#include <stdint.h>
+#include "rpApp.h"
+
+#define PERSIST_BINS                  RPAPP_OSC_PERSIST_ROWS  // amplitude rows over the screen height
+#define PERSIST_HIT                   16     // count added per hit, the low bits keep the decay fraction
+#define PERSIST_MAX                   UINT16_MAX
+
+/* Hit counts are stored per view column, PERSIST_BINS counts of one column are contiguous
+ * with bin 0 at the bottom of the screen */
+void persist_Accumulate(uint16_t *image, const float *data, const float *min, const float *max,
+                        uint32_t start, uint32_t end, float bottom, float height);
+void persist_Decay(uint16_t *image, uint32_t size, uint32_t factor);
+void persist_Render(const uint16_t *image, uint32_t columns, uint8_t *out);
+
+#endif /* __PERSIST_H */
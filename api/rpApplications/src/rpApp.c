@@ -185,6 +185,54 @@ int rpApp_OscIsInverted(rpApp_osc_source source, bool *inverted) {
     return osc_isInverted(source, inverted);
 }
 
+int rpApp_OscSetPeakDetect(bool enable) {
+    return osc_setPeakDetect(enable);
+}
+
+int rpApp_OscGetPeakDetect(bool *enable) {
+    return osc_getPeakDetect(enable);
+}
+
+int rpApp_OscSetInterpolation(rpApp_osc_interp_t interp) {
+    return osc_setInterpolation(interp);
+}
+
+int rpApp_OscGetInterpolation(rpApp_osc_interp_t *interp) {
+    return osc_getInterpolation(interp);
+}
+
+int rpApp_OscSetRollMode(bool enable) {
+    return osc_setRollMode(enable);
+}
+
+int rpApp_OscGetRollMode(bool *enable) {
+    return osc_getRollMode(enable);
+}
+
+int rpApp_OscSetPersistence(rpApp_osc_persist_t mode) {
+    return osc_setPersistence(mode);
+}
+
+int rpApp_OscGetPersistence(rpApp_osc_persist_t *mode) {
+    return osc_getPersistence(mode);
+}
+
+int rpApp_OscSetPersistenceTime(float time) {
+    return osc_setPersistenceTime(time);
+}
+
+int rpApp_OscGetPersistenceTime(float *time) {
+    return osc_getPersistenceTime(time);
+}
+
+int rpApp_OscResetPersistence() {
+    return osc_resetPersistence();
+}
+
+int rpApp_OscGetPersistenceImage(rpApp_osc_source source, uint8_t *image, uint32_t size) {
+    return osc_getPersistenceImage(source, image, size);
+}
+
 int rpApp_OscGetViewPart(float *ratio) {
     return osc_getViewPart(ratio);
 }
@@ -201,6 +249,10 @@ int rpApp_OscGetViewData(rpApp_osc_source source, float *data, uint32_t size) {
     return osc_getData(source, data, size);
 }
 
+int rpApp_OscGetViewEnvelope(rpApp_osc_source source, float *min, float *max, uint32_t size) {
+    return osc_getEnvelope(source, min, max, size);
+}
+
 int rpApp_OscSetViewSize(uint32_t size) {
     return osc_setViewSize(size);
 }
@@ -250,6 +302,18 @@ int rpApp_OscMeasureRootMeanSquare(rpApp_osc_source source, float *rms) {
     return osc_measureRootMeanSquare(source, rms);
 }
 
+int rpApp_OscResetMeasureStatistics() {
+    return osc_resetMeasureStatistics();
+}
+
+int rpApp_OscSetMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, bool enabled) {
+    return osc_setMeasureStatistics(source, meas, enabled);
+}
+
+int rpApp_OscGetMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, rpApp_osc_meas_stats_t *stats) {
+    return osc_getMeasureStatistics(source, meas, stats);
+}
+
 int rpApp_OscGetCursorVoltage(rpApp_osc_source source, uint32_t cursor, float *value) {
     return osc_getCursorVoltage(source, cursor, value);
 }
@@ -310,6 +374,10 @@ int rpApp_SpecGetViewData(float** signals, size_t size) {
 	return spec_getViewData(signals, size);
 }
 
+int rpApp_SpecGetHoldData(float** signals, size_t size) {
+	return spec_getHoldData(signals, size);
+}
+
 int rpApp_SpecGetJpgIdx(int* jpg) {
 	return spec_getJpgIdx(jpg);
 }
@@ -322,6 +390,10 @@ int rpApp_SpecGetPeakFreq(int channel, float* freq) {
 	return spec_getPeakFreq(channel, freq);
 }
 
+int rpApp_SpecGetSpectraRate(float* rate) {
+	return spec_getSpectraRate(rate);
+}
+
 int rpApp_SpecSetFreqRange(float _freq_min, float freq) {
 	return spec_setFreqRange(_freq_min, freq);
 }
@@ -334,6 +406,34 @@ int rpApp_SpecGetUnit() {
 	return spec_getUnit();
 }
 
+int rpApp_SpecSetWelchSegments(int segments) {
+	return spec_setWelchSegments(segments);
+}
+
+int rpApp_SpecGetWelchSegments(int* segments) {
+	return spec_getWelchSegments(segments);
+}
+
+int rpApp_SpecSetAvgMode(rpApp_spec_avg_t mode) {
+	return spec_setAvgMode(mode);
+}
+
+int rpApp_SpecGetAvgMode(rpApp_spec_avg_t* mode) {
+	return spec_getAvgMode(mode);
+}
+
+int rpApp_SpecSetAvgCount(int count) {
+	return spec_setAvgCount(count);
+}
+
+int rpApp_SpecGetAvgCount(int* count) {
+	return spec_getAvgCount(count);
+}
+
+int rpApp_SpecResetAveraging() {
+	return spec_resetAveraging();
+}
+
 int rpApp_SpecGetViewSize(size_t* size)
 {
 	*size = SPECTR_OUT_SIG_LEN;
@@ -94,8 +94,68 @@ typedef enum {
     RPAPP_OSC_MATH_ABS,         //!< Math operation absolute
     RPAPP_OSC_MATH_DER,         //!< Math operation derivative
     RPAPP_OSC_MATH_INT,         //!< Math operation integrate
+    RPAPP_OSC_MATH_FFT,         //!< Math operation FFT amplitude spectrum of the first source
 } rpApp_osc_math_oper_t;
 
+/**
+* Type representing oscilloscope measurements.
+*/
+typedef enum {
+    RPAPP_OSC_MEAS_VPP,         //!< Peak-to-peak voltage
+    RPAPP_OSC_MEAS_VMEAN,       //!< Mean voltage
+    RPAPP_OSC_MEAS_VMAX,        //!< Max voltage
+    RPAPP_OSC_MEAS_VMIN,        //!< Min voltage
+    RPAPP_OSC_MEAS_FREQ,        //!< Frequency
+    RPAPP_OSC_MEAS_PERIOD,      //!< Period
+    RPAPP_OSC_MEAS_DUTY,        //!< Duty cycle
+    RPAPP_OSC_MEAS_RMS          //!< Root mean square
+} rpApp_osc_meas_t;
+
+/**
+* Type representing interpolation of sub-sample time scales.
+*/
+typedef enum {
+    RPAPP_OSC_INTERP_LINEAR,    //!< Straight line between neighbouring samples
+    RPAPP_OSC_INTERP_SINC       //!< Windowed sin(x)/x reconstruction
+} rpApp_osc_interp_t;
+
+/**
+* Type representing display persistence.
+*/
+typedef enum {
+    RPAPP_OSC_PERSIST_OFF,      //!< No persistence image
+    RPAPP_OSC_PERSIST_DECAY,    //!< Hits fade with the persistence time
+    RPAPP_OSC_PERSIST_INFINITE  //!< Hits accumulate until reset
+} rpApp_osc_persist_t;
+
+/** Amplitude rows of the persistence image */
+#define RPAPP_OSC_PERSIST_ROWS  256
+
+/**
+* Type representing spectrum averaging over successive spectra.
+*/
+typedef enum {
+    RPAPP_SPEC_AVG_LINEAR,      //!< Equal weights, starts over after the averaging count
+    RPAPP_SPEC_AVG_EXP          //!< Weight 1/count once the averaging count is reached
+} rpApp_spec_avg_t;
+
+/** Spectrum view signals: frequency, CH1, CH2 */
+#define RPAPP_SPEC_SIG_NUM      3
+
+/** Spectrum hold signals: CH1 and CH2 max-hold, CH1 and CH2 min-hold */
+#define RPAPP_SPEC_HOLD_NUM     4
+
+/**
+* Running statistics of one measurement over the frames acquired since the last reset.
+*/
+typedef struct {
+    uint32_t count;             //!< Number of frames the measurement succeeded on
+    double mean;                //!< Mean value
+    double stddev;              //!< Sample standard deviation, 0 with less than two frames
+    double min;                 //!< Smallest value
+    double max;                 //!< Largest value
+} rpApp_osc_meas_stats_t;
+
 /** @name General
 */
 ///@{
@@ -171,7 +231,9 @@ int rpApp_OscReset();
 int rpApp_OscSingle();
 
 /**
-* Automatically sets "best" parameters for viewing the signal
+* Automatically sets "best" parameters for viewing the signal. Amplitude scale, offset and time scale
+* are taken from one capture at full sample rate; signals slower than about 20 kHz need a second capture
+* at 10 ms/div. The oscilloscope must be running; the view limits read 0 until the scales are set.
 * @return If the function is successful, the return value is RP_OK.
 * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
 */
@@ -373,6 +435,120 @@ int rpApp_OscSetInverted(rpApp_osc_source source, bool inverted);
 */
 int rpApp_OscIsInverted(rpApp_osc_source source, bool *inverted);
 
+/**
+* Enables or disables peak-detect view mode.
+* When enabled and the time scale spans more than one sample per view point, every view
+* point also carries the minimum and maximum of all samples it covers, so narrow glitches
+* stay visible. See rpApp_OscGetViewEnvelope().
+* @param enable Determines if peak-detect mode is to be used or not.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetPeakDetect(bool enable);
+
+/**
+* Checks if peak-detect view mode is enabled.
+* @param enable Returned value.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetPeakDetect(bool *enable);
+
+/**
+* Sets how view points between two samples are drawn when the time scale spans less than
+* one sample per view point. Sin(x)/x reconstructs the band-limited signal from 16
+* neighbouring samples, linear joins the two nearest samples with a straight line.
+* Linear is the default, sin(x)/x has to be selected.
+* @param interp Interpolation mode.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetInterpolation(rpApp_osc_interp_t interp);
+
+/**
+* Gets the interpolation mode of sub-sample time scales.
+* @param interp Returned value.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetInterpolation(rpApp_osc_interp_t *interp);
+
+/**
+* Enables or disables roll mode, disabled by default.
+* In auto sweep at time scales of 100 ms/div and slower the view then scrolls instead of
+* waiting for a triggered buffer: samples are appended at the right edge as they are
+* acquired and the view is updated 20 times per second. Every view point carries the
+* minimum and maximum of the samples it covers, see rpApp_OscGetViewEnvelope().
+* @param enable Determines if roll mode is to be used or not.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetRollMode(bool enable);
+
+/**
+* Checks if roll mode is enabled.
+* @param enable Returned value.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetRollMode(bool *enable);
+
+/**
+* Sets display persistence mode, off by default.
+* While on, every acquired frame of each source is added to a hit-count image of view size
+* columns by RPAPP_OSC_PERSIST_ROWS amplitude rows covering the screen height, so repeated
+* traces build up an intensity graded picture. With decay the counts fade exponentially
+* with the persistence time, infinite persistence keeps them until reset. The image
+* restarts whenever view settings change.
+* @param mode Persistence mode.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetPersistence(rpApp_osc_persist_t mode);
+
+/**
+* Gets display persistence mode.
+* @param mode Returned value.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetPersistence(rpApp_osc_persist_t *mode);
+
+/**
+* Sets decay time constant of the persistence image.
+* @param time Time in milliseconds after which the hits have faded to 1/e, must be positive.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetPersistenceTime(float time);
+
+/**
+* Gets decay time constant of the persistence image.
+* @param time Returned value in milliseconds.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetPersistenceTime(float *time);
+
+/**
+* Clears the persistence image.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscResetPersistence();
+
+/**
+* Gets the persistence image of a source as 8 bit intensities, RPAPP_OSC_PERSIST_ROWS rows
+* of view size bytes each. Row 0 is the top of the screen. The most hit point is 255 and
+* any point hit since the image (re)started and not yet faded is at least 1.
+* @param source Source of the image.
+* @param image Image buffer.
+* @param size Size of the image buffer, at least RPAPP_OSC_PERSIST_ROWS times the view size.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetPersistenceImage(rpApp_osc_source source, uint8_t *image, uint32_t size);
+
 /**
 * Gets view size ratio position proportional to ADC buffer size.
 * @param ratio Pointer to ratio. Returned value is between 0 and 1
@@ -453,6 +629,38 @@ int rpApp_OscMeasureDutyCycle(rpApp_osc_source source, float *dutyCycle);
 */
 int rpApp_OscMeasureRootMeanSquare(rpApp_osc_source source, float *rms);
 
+/**
+* Clears the running statistics of all measurements. Enabled measurements keep being collected from the next
+* frame on, see rpApp_OscSetMeasureStatistics().
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscResetMeasureStatistics();
+
+/**
+* Enables or disables the running statistics of a measurement. While enabled, every newly acquired frame adds
+* the measurement of the source (math only while a math operation is selected). Redraws of a stopped view are
+* not counted. Only enabled measurements are computed for each frame.
+* @param source Source ch1, ch2 or math.
+* @param meas Measurement.
+* @param enabled True to collect the statistics.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscSetMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, bool enabled);
+
+/**
+* Gets running statistics of a measurement, see rpApp_OscSetMeasureStatistics(). Reading them enables the
+* measurement, so the first read starts the collection. Frames on which the measurement fails (e.g. no period)
+* are not counted.
+* @param source Source ch1, ch2 or math.
+* @param meas Measurement, values are in the units of the corresponding rpApp_OscMeasure* function.
+* @param stats Pointer to statistics.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetMeasureStatistics(rpApp_osc_source source, rpApp_osc_meas_t meas, rpApp_osc_meas_stats_t *stats);
+
 /**
 * Gets voltage at cursor position.
 * @param source Source ch1, ch2 or math on which we want to get voltage.
@@ -547,6 +755,19 @@ int rpApp_OscGetMathSources(rp_channel_t *source1, rp_channel_t *source2);
 */
 int rpApp_OscGetViewData(rpApp_osc_source source, float *data, uint32_t size);
 
+/**
+* Gets min/max envelope of the source view data.
+* In peak-detect mode min[i] and max[i] are the extremes of the samples covered by view
+* point i, in view units. Otherwise both are equal to the view data.
+* @param source Source ch1 or ch2, math has no envelope.
+* @param min Envelope minimum buffer.
+* @param max Envelope maximum buffer.
+* @param size Number of values to be returned, not larger than view size.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rpApp_OscGetViewEnvelope(rpApp_osc_source source, float *min, float *max, uint32_t size);
+
 /**
 * Sets view buffer size.
 * @param size Buffer size.
@@ -584,7 +805,9 @@ int rpApp_SpecRunning();
 
 int rpApp_SpecReset();
 
-int rpApp_SpecGetViewData(float **signals, size_t size);
+int rpApp_SpecGetViewData(float **signals, size_t size); // RPAPP_SPEC_SIG_NUM signals of size
+
+int rpApp_SpecGetHoldData(float **signals, size_t size); // RPAPP_SPEC_HOLD_NUM signals of size
 
 int rpApp_SpecGetViewSize(size_t* size);
 
@@ -594,6 +817,8 @@ int rpApp_SpecGetPeakPower(int channel, float* power);
 
 int rpApp_SpecGetPeakFreq(int channel, float* freq);
 
+int rpApp_SpecGetSpectraRate(float* rate); // processed spectra per second, 0 when stopped
+
 int rpApp_SpecSetFreqRange(float _freq_min, float freq);
 
 int rpApp_SpecSetUnit(int unit);
@@ -610,6 +835,20 @@ int rpApp_SpecSetFreqMax(float freq);
 
 int rpApp_SpecGetFpgaFreq(float* freq);
 
+int rpApp_SpecSetWelchSegments(int segments); // 1, 3 or 7 segments of a capture, 50% overlap
+
+int rpApp_SpecGetWelchSegments(int* segments);
+
+int rpApp_SpecSetAvgMode(rpApp_spec_avg_t mode);
+
+int rpApp_SpecGetAvgMode(rpApp_spec_avg_t* mode);
+
+int rpApp_SpecSetAvgCount(int count); // spectra averaged, 1 turns averaging off
+
+int rpApp_SpecGetAvgCount(int* count);
+
+int rpApp_SpecResetAveraging(); // restarts the average and the max/min-hold traces
+
 #ifdef __cplusplus
 }
 #endif
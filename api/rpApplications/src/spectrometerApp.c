@@ -39,30 +39,56 @@ const char c_jpg_file_path[]="/tmp/wat";
 const char c_jpg_file_suf[]=".jpg";
 const int  c_jpg_max_file  = 63;
 const int  c_save_jpg_cnt  = 10; /* Repetition how often the JPG is stored */
+const int64_t c_trig_wait_ns = 10000000; /* Longest trigger wait between state checks */
+const int64_t c_rate_period_ns = 1000000000; /* Spectra rate measurement period */
 char      *jpg_fname_cha = NULL;
 char      *jpg_fname_chb = NULL;
 
+/* The worker is split in two stages: the acquisition thread captures frames and
+ * re-arms the FPGA as soon as a frame is copied out, the DSP thread processes the
+ * copies meanwhile */
 pthread_t *rp_spectr_thread_handler = NULL;
+pthread_t *rp_spectr_dsp_thread_handler = NULL;
 void *rp_spectr_worker_thread(void *args);
-
-/* Signals directly pointing at the FPGA mem space */
-int                  *rp_fpga_cha_signal, *rp_fpga_chb_signal;
-
-/* Internal structures */
-/* Size = SPECTR_FPGA_SIG_LEN  */
-double *rp_cha_in = NULL;
-double *rp_chb_in = NULL;
+void *rp_spectr_dsp_thread(void *args);
+
+/* Two-slot frame buffer between the stages. The acquisition fills a slot the DSP
+ * stage does not hold; when both hold unprocessed frames the older one is dropped. */
+#define SPECTR_FRAME_SLOTS 2
+
+typedef enum rp_spectr_slot_e {
+    rp_spectr_slot_free = 0,
+    rp_spectr_slot_filling, /* being copied from the FPGA */
+    rp_spectr_slot_ready,   /* waiting for the DSP stage */
+    rp_spectr_slot_busy     /* being processed */
+} rp_spectr_slot_t;
+
+typedef struct rp_spectr_frame_s {
+    int              *cha;       /* raw counts, SPECTR_FPGA_SIG_LEN, oldest first */
+    int              *chb;
+    float             freq_range;
+    unsigned int      fpga_gen;  /* FPGA settings the frame was captured with */
+    unsigned long     seq;
+    rp_spectr_slot_t  state;
+} rp_spectr_frame_t;
+
+pthread_mutex_t    rp_spectr_frame_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t     rp_spectr_frame_cond = PTHREAD_COND_INITIALIZER;
+rp_spectr_frame_t  rp_spectr_frames[SPECTR_FRAME_SLOTS];
+unsigned long      rp_spectr_frame_seq = 0;
+int                rp_spectr_frame_quit = 0;
 
 /* DSP structures */
-/* size = c_dsp_sig_len */
+/* FFT amplitudes for the waterfall, size = c_dsp_sig_len */
 double *rp_cha_fft = NULL;
 double *rp_chb_fft = NULL;
 
-/* Output 3 x SPECTR_OUT_SIG signals - used internally for calculation */
+/* Output SPECTR_OUT_SIG_NUM x SPECTR_OUT_SIG signals - used internally for calculation */
 float               **rp_tmp_signals = NULL;
 
 /* Parameters & signals communicating with 'external world' */
 pthread_mutex_t       rp_spectr_ctrl_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t        rp_spectr_ctrl_cond = PTHREAD_COND_INITIALIZER;
 rp_spectr_worker_state_t rp_spectr_ctrl;
 rp_app_params_t       rp_spectr_params[PARAMS_NUM];
 int                   rp_spectr_params_dirty;
@@ -72,6 +98,7 @@ pthread_mutex_t        rp_spectr_sig_mutex = PTHREAD_MUTEX_INITIALIZER;
 float                **rp_spectr_signals = NULL;
 rp_spectr_worker_res_t rp_spectr_result;
 int                    rp_spectr_signals_dirty = 0;
+int                    rp_spectr_hold_dirty = 0;
 
 static float freq_min, freq_max, current_freq_range, current_unit;
 
@@ -98,15 +125,24 @@ int rp_spectr_worker_init(const wf_func_table_t* wf_f)
         return -1;
     }
 
-    rp_cha_in = (double *)malloc(sizeof(double) * SPECTR_FPGA_SIG_LEN);
-    rp_chb_in = (double *)malloc(sizeof(double) * SPECTR_FPGA_SIG_LEN);
     rp_cha_fft = (double *)malloc(sizeof(double) * c_dsp_sig_len);
     rp_chb_fft = (double *)malloc(sizeof(double) * c_dsp_sig_len);
-    if(!rp_cha_in || !rp_chb_in || !rp_cha_fft || !rp_chb_fft) {
+    if(!rp_cha_fft || !rp_chb_fft) {
         rp_spectr_worker_clean();
         return -1;
     }
 
+    rp_spectr_frame_quit = 0;
+    for(int i = 0; i < SPECTR_FRAME_SLOTS; i++) {
+        rp_spectr_frames[i].cha = (int *)malloc(sizeof(int) * SPECTR_FPGA_SIG_LEN);
+        rp_spectr_frames[i].chb = (int *)malloc(sizeof(int) * SPECTR_FPGA_SIG_LEN);
+        rp_spectr_frames[i].state = rp_spectr_slot_free;
+        if(!rp_spectr_frames[i].cha || !rp_spectr_frames[i].chb) {
+            rp_spectr_worker_clean();
+            return -1;
+        }
+    }
+
     jpg_fname_cha = 
         (char *)malloc((strlen(c_jpg_file_path)+strlen(c_jpg_file_suf)+5+1));
     jpg_fname_chb = 
@@ -138,12 +174,26 @@ int rp_spectr_worker_init(const wf_func_table_t* wf_f)
 	    }
 	}
 
-    spectr_fpga_get_sig_ptr(&rp_fpga_cha_signal, &rp_fpga_chb_signal);
-
     rp_spectr_thread_handler = (pthread_t *)malloc(sizeof(pthread_t));
-    if(rp_spectr_thread_handler == NULL) {
-        rp_cleanup_signals(&rp_spectr_signals);
-        rp_cleanup_signals(&rp_tmp_signals);
+    rp_spectr_dsp_thread_handler = (pthread_t *)malloc(sizeof(pthread_t));
+    if(rp_spectr_thread_handler == NULL || rp_spectr_dsp_thread_handler == NULL) {
+        free(rp_spectr_thread_handler);
+        free(rp_spectr_dsp_thread_handler);
+        rp_spectr_thread_handler = rp_spectr_dsp_thread_handler = NULL;
+        rp_spectr_worker_clean();
+        return -1;
+    }
+
+    ret_val = 
+        pthread_create(rp_spectr_dsp_thread_handler, NULL, 
+                       rp_spectr_dsp_thread, NULL);
+    if(ret_val != 0) {
+        free(rp_spectr_dsp_thread_handler);
+        free(rp_spectr_thread_handler);
+        rp_spectr_thread_handler = rp_spectr_dsp_thread_handler = NULL;
+        rp_spectr_worker_exit();
+        fprintf(stderr, "pthread_create() failed: %s\n", 	
+                strerror(ret_val));
         return -1;
     }
 
@@ -151,12 +201,11 @@ int rp_spectr_worker_init(const wf_func_table_t* wf_f)
         pthread_create(rp_spectr_thread_handler, NULL, 
                        rp_spectr_worker_thread, NULL);
     if(ret_val != 0) {
-        spectr_fpga_exit();
-
-        rp_cleanup_signals(&rp_spectr_signals);
-        rp_cleanup_signals(&rp_tmp_signals);
+        free(rp_spectr_thread_handler);
+        rp_spectr_thread_handler = NULL;
+        rp_spectr_worker_exit();
         fprintf(stderr, "pthread_create() failed: %s\n", 	
-                strerror(errno));
+                strerror(ret_val));
         return -1;
     }
 
@@ -181,14 +230,6 @@ int rp_spectr_worker_clean(void)
         free(jpg_fname_chb);
         jpg_fname_chb = NULL;
     }
-    if(rp_cha_in) {
-        free(rp_cha_in);
-        rp_cha_in = NULL;
-    }
-    if(rp_chb_in) {
-        free(rp_chb_in);
-        rp_chb_in = NULL;
-    }
     if(rp_cha_fft) {
         free(rp_cha_fft);
         rp_cha_fft = NULL;
@@ -197,6 +238,11 @@ int rp_spectr_worker_clean(void)
         free(rp_chb_fft);
         rp_chb_fft = NULL;
     }
+    for(int i = 0; i < SPECTR_FRAME_SLOTS; i++) {
+        free(rp_spectr_frames[i].cha);
+        free(rp_spectr_frames[i].chb);
+        rp_spectr_frames[i].cha = rp_spectr_frames[i].chb = NULL;
+    }
 
     return 0;
 }
@@ -211,6 +257,17 @@ int rp_spectr_worker_exit(void)
         free(rp_spectr_thread_handler);
         rp_spectr_thread_handler = NULL;
     }
+    /* the DSP stage finishes the frame it holds and quits */
+    pthread_mutex_lock(&rp_spectr_frame_mutex);
+    rp_spectr_frame_quit = 1;
+    pthread_cond_broadcast(&rp_spectr_frame_cond);
+    pthread_mutex_unlock(&rp_spectr_frame_mutex);
+    if(rp_spectr_dsp_thread_handler) {
+        int ret = pthread_join(*rp_spectr_dsp_thread_handler, NULL);
+        ret_val = ret_val ? ret_val : ret;
+        free(rp_spectr_dsp_thread_handler);
+        rp_spectr_dsp_thread_handler = NULL;
+    }
     if(ret_val != 0) {
         fprintf(stderr, "pthread_join() failed: %s\n", 
                 strerror(errno));
@@ -226,6 +283,7 @@ int rp_spectr_worker_change_state(rp_spectr_worker_state_t new_state)
         return -1;
     pthread_mutex_lock(&rp_spectr_ctrl_mutex);
     rp_spectr_ctrl = new_state;
+    pthread_cond_broadcast(&rp_spectr_ctrl_cond);
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
     return 0;
 }
@@ -236,6 +294,7 @@ int rp_spectr_worker_update_params(rp_app_params_t *params, int fpga_update)
     memcpy(&rp_spectr_params, params, sizeof(rp_app_params_t)*PARAMS_NUM);
     rp_spectr_params_dirty       = 1;
     rp_spectr_params_fpga_update = fpga_update;
+    pthread_cond_broadcast(&rp_spectr_ctrl_cond);
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
     return 0;
 }
@@ -249,6 +308,7 @@ int rp_spectr_worker_update_params_by_idx(int value, size_t idx, int fpga_update
     rp_spectr_params[idx].value = value;
     rp_spectr_params_dirty       = 1;
     rp_spectr_params_fpga_update = fpga_update;
+    pthread_cond_broadcast(&rp_spectr_ctrl_cond);
 
     pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
     return 0;
@@ -258,6 +318,7 @@ int rp_spectr_clean_signals(void)
 {
     pthread_mutex_lock(&rp_spectr_sig_mutex);
     rp_spectr_signals_dirty = 0;
+    rp_spectr_hold_dirty = 0;
     pthread_mutex_unlock(&rp_spectr_sig_mutex);
     return 0;
 }
@@ -311,24 +372,35 @@ int rp_spectr_clean_tmpdir(const char *dir)
     return ret;
 }
 
-int rp_spectr_get_signals_channel(float** signals, size_t size)
+/* Copies num output signals from first on, if they changed since the last copy */
+static int rp_spectr_copy_signals(float** signals, int first, int num, size_t size, int *dirty)
 {
     pthread_mutex_lock(&rp_spectr_sig_mutex);
-    if(rp_spectr_signals_dirty == 0) {
+    if(*dirty == 0) {
         pthread_mutex_unlock(&rp_spectr_sig_mutex);
         return -1;
     }
 
-	size_t i;
-	for (i = 0; i < 3; ++i)
-		memcpy(signals[i], rp_spectr_signals[i], sizeof(float)*size);
+	int i;
+	for (i = 0; i < num; ++i)
+		memcpy(signals[i], rp_spectr_signals[first + i], sizeof(float)*size);
 
-    rp_spectr_signals_dirty = 0;
+    *dirty = 0;
 
     pthread_mutex_unlock(&rp_spectr_sig_mutex);
     return 0;
 }
 
+int rp_spectr_get_signals_channel(float** signals, size_t size)
+{
+    return rp_spectr_copy_signals(signals, 0, RPAPP_SPEC_SIG_NUM, size, &rp_spectr_signals_dirty);
+}
+
+int rp_spectr_get_hold_signals(float** signals, size_t size)
+{
+    return rp_spectr_copy_signals(signals, SPECTR_OUT_HOLD_SIG, RPAPP_SPEC_HOLD_NUM, size, &rp_spectr_hold_dirty);
+}
+
 int rp_spectr_get_params(rp_spectr_worker_res_t *result)
 {
     pthread_mutex_lock(&rp_spectr_sig_mutex);
@@ -338,6 +410,7 @@ int rp_spectr_get_params(rp_spectr_worker_res_t *result)
     result->peak_pw_freq_cha = rp_spectr_result.peak_pw_freq_cha;
     result->peak_pw_chb      = rp_spectr_result.peak_pw_chb;
     result->peak_pw_freq_chb = rp_spectr_result.peak_pw_freq_chb;
+    result->spectra_rate     = rp_spectr_result.spectra_rate;
 
     pthread_mutex_unlock(&rp_spectr_sig_mutex);
     return 0;
@@ -346,45 +419,118 @@ int rp_spectr_get_params(rp_spectr_worker_res_t *result)
 int rp_spectr_set_signals(float **source, rp_spectr_worker_res_t result)
 {
     pthread_mutex_lock(&rp_spectr_sig_mutex);
-    memcpy(rp_spectr_signals[0], source[0], sizeof(float)*SPECTR_OUT_SIG_LEN);
-    memcpy(rp_spectr_signals[1], source[1], sizeof(float)*SPECTR_OUT_SIG_LEN);
-    memcpy(rp_spectr_signals[2], source[2], sizeof(float)*SPECTR_OUT_SIG_LEN);
+    for(int i = 0; i < SPECTR_OUT_SIG_NUM; i++)
+        memcpy(rp_spectr_signals[i], source[i], sizeof(float)*SPECTR_OUT_SIG_LEN);
 
     rp_spectr_signals_dirty = 1;
+    rp_spectr_hold_dirty = 1;
 
     rp_spectr_result.jpg_idx          = result.jpg_idx;
     rp_spectr_result.peak_pw_cha      = result.peak_pw_cha;
     rp_spectr_result.peak_pw_freq_cha = result.peak_pw_freq_cha;
     rp_spectr_result.peak_pw_chb      = result.peak_pw_chb;
     rp_spectr_result.peak_pw_freq_chb = result.peak_pw_freq_chb;
+    rp_spectr_result.spectra_rate     = result.spectra_rate;
 
     pthread_mutex_unlock(&rp_spectr_sig_mutex);
 
     return 0;
 }
 
+static int64_t rp_spectr_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Slot for the next capture: a free one, otherwise the older of the unprocessed ones */
+static rp_spectr_frame_t *rp_spectr_frame_fill(void)
+{
+    rp_spectr_frame_t *f = NULL;
+    int i;
+
+    pthread_mutex_lock(&rp_spectr_frame_mutex);
+    for(i = 0; i < SPECTR_FRAME_SLOTS && !f; i++) {
+        if(rp_spectr_frames[i].state == rp_spectr_slot_free)
+            f = &rp_spectr_frames[i];
+    }
+    for(i = 0; i < SPECTR_FRAME_SLOTS && !f; i++) {
+        if((rp_spectr_frames[i].state == rp_spectr_slot_ready) &&
+           (!f || rp_spectr_frames[i].seq < f->seq))
+            f = &rp_spectr_frames[i];
+    }
+    /* the DSP stage holds at most one slot, one is always left */
+    f->state = rp_spectr_slot_filling;
+    pthread_mutex_unlock(&rp_spectr_frame_mutex);
+    return f;
+}
+
+static void rp_spectr_frame_filled(rp_spectr_frame_t *f)
+{
+    pthread_mutex_lock(&rp_spectr_frame_mutex);
+    f->seq = ++rp_spectr_frame_seq;
+    f->state = rp_spectr_slot_ready;
+    pthread_cond_signal(&rp_spectr_frame_cond);
+    pthread_mutex_unlock(&rp_spectr_frame_mutex);
+}
+
+/* Frames captured with previous FPGA settings are not shown */
+static void rp_spectr_frame_drop(void)
+{
+    pthread_mutex_lock(&rp_spectr_frame_mutex);
+    for(int i = 0; i < SPECTR_FRAME_SLOTS; i++) {
+        if(rp_spectr_frames[i].state == rp_spectr_slot_ready)
+            rp_spectr_frames[i].state = rp_spectr_slot_free;
+    }
+    pthread_mutex_unlock(&rp_spectr_frame_mutex);
+}
+
+/* Oldest unprocessed frame, blocks until there is one. NULL when the worker quits. */
+static rp_spectr_frame_t *rp_spectr_frame_take(void)
+{
+    rp_spectr_frame_t *f = NULL;
+
+    pthread_mutex_lock(&rp_spectr_frame_mutex);
+    while(!rp_spectr_frame_quit) {
+        for(int i = 0; i < SPECTR_FRAME_SLOTS; i++) {
+            if((rp_spectr_frames[i].state == rp_spectr_slot_ready) &&
+               (!f || rp_spectr_frames[i].seq < f->seq))
+                f = &rp_spectr_frames[i];
+        }
+        if(f) {
+            f->state = rp_spectr_slot_busy;
+            break;
+        }
+        pthread_cond_wait(&rp_spectr_frame_cond, &rp_spectr_frame_mutex);
+    }
+    pthread_mutex_unlock(&rp_spectr_frame_mutex);
+    return f;
+}
+
+static void rp_spectr_frame_release(rp_spectr_frame_t *f)
+{
+    pthread_mutex_lock(&rp_spectr_frame_mutex);
+    f->state = rp_spectr_slot_free;
+    pthread_mutex_unlock(&rp_spectr_frame_mutex);
+}
+
+/* Acquisition stage */
 void *rp_spectr_worker_thread(void *args)
 {
-    rp_spectr_worker_state_t old_state, state;
+    rp_spectr_worker_state_t state;
     rp_app_params_t          curr_params[PARAMS_NUM];
     int                      fpga_update = 1;
     int                      params_dirty = 1;
-    int                      loop_cnt = 0; /* each N save jpeg */
-    int                      jpg_fn_cnt = 0;
-    /* depends on freq_range - do not save too much or too less */
-    int                      jpg_write_div = 10;
-    rp_spectr_worker_res_t   tmp_result;
-
-    pthread_mutex_lock(&rp_spectr_ctrl_mutex);
-    old_state = state = rp_spectr_ctrl;
-    pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
+    unsigned int             fpga_gen = 0;
 
     while(1) {
-        /* update states - we save also old state to see if we need to reset
-         * FPGA 
-         */
-        old_state = state;
         pthread_mutex_lock(&rp_spectr_ctrl_mutex);
+        /* nothing to acquire until the state or the parameters change */
+        while(((rp_spectr_ctrl == rp_spectr_idle_state) || 
+               (rp_spectr_ctrl == rp_spectr_abort_state)) && !rp_spectr_params_dirty) {
+            pthread_cond_wait(&rp_spectr_ctrl_cond, &rp_spectr_ctrl_mutex);
+        }
         state = rp_spectr_ctrl;
         if(rp_spectr_params_dirty) {			
             memcpy(&curr_params, &rp_spectr_params, sizeof(rp_app_params_t)*PARAMS_NUM);
@@ -405,93 +551,109 @@ void *rp_spectr_worker_thread(void *args)
 				rp_spectr_worker_change_state(rp_spectr_auto_state);
             }
             fpga_update = 0;
-			if (wf_func_table)
-            	wf_func_table->rp_spectr_wf_clean_map();
-            switch((int)curr_params[FREQ_RANGE_PARAM].value) {
-            case 0:
-            case 1:
-                jpg_write_div = 10;
-                break;
-            case 2:
-            case 3:
-                jpg_write_div = 5;
-                break;
-            case 4:
-            case 5:
-                jpg_write_div = 0;
-                break;
-            }
+            fpga_gen++;
+            rp_spectr_frame_drop();
         }
 
-        if(state == rp_spectr_idle_state) {
-            usleep(10000);
+        if(state != rp_spectr_auto_state) {
             continue;
         }
 
         /* Start the writting machine */
         spectr_fpga_arm_trigger();
-        
-        usleep(10);
-
         spectr_fpga_set_trigger(1);
 
-        /* start working */
-        pthread_mutex_lock(&rp_spectr_ctrl_mutex);
-        old_state = state = rp_spectr_ctrl;
-        pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
-        if((state == rp_spectr_idle_state) || (state == rp_spectr_abort_state)) {
-            continue;
-        } else if(state == rp_spectr_quit_state) {
-            break;
-        }
-
-        /* polling until data is ready */
+        /* waiting until data is ready */
         while(1) {
             pthread_mutex_lock(&rp_spectr_ctrl_mutex);
             state = rp_spectr_ctrl;
             params_dirty = rp_spectr_params_dirty;
             pthread_mutex_unlock(&rp_spectr_ctrl_mutex);
             /* change in state, abort polling */
-            if((state != old_state) || params_dirty) {
+            if((state != rp_spectr_auto_state) || params_dirty) {
                 break;
             }
                 
-            if(spectr_fpga_triggered()) {
+            if(rp_AcqWaitTrigger(c_trig_wait_ns) == RP_OK) {
                 break;
             }
         }
 
-        if((state != old_state) || params_dirty) {
-            params_dirty = 0;
+        if((state != rp_spectr_auto_state) || params_dirty) {
             continue;
         }
 
-        /* retrieve data and process it*/
-        spectr_fpga_get_signal(&rp_cha_in, &rp_chb_in);
+        /* copy the frame out, the FPGA is re-armed right after */
+        rp_spectr_frame_t *f = rp_spectr_frame_fill();
+        spectr_fpga_copy_signal(f->cha, f->chb);
+        f->freq_range = curr_params[FREQ_RANGE_PARAM].value;
+        f->fpga_gen = fpga_gen;
+        rp_spectr_frame_filled(f);
+    }
+
+    return 0;
+}
+
+/* DSP stage */
+void *rp_spectr_dsp_thread(void *args)
+{
+    int                      loop_cnt = 0; /* each N save jpeg */
+    int                      jpg_fn_cnt = 0;
+    /* depends on freq_range - do not save too much or too less */
+    int                      jpg_write_div = 10;
+    unsigned int             fpga_gen = 0;
+    int                      rate_cnt = 0;
+    int64_t                  rate_start = rp_spectr_time_ns();
+    rp_spectr_worker_res_t   tmp_result;
+    rp_spectr_frame_t       *f;
+
+    tmp_result.spectra_rate = 0;
+
+    while((f = rp_spectr_frame_take()) != NULL) {
+        if(f->fpga_gen != fpga_gen) {
+            fpga_gen = f->fpga_gen;
+			if (wf_func_table)
+            	wf_func_table->rp_spectr_wf_clean_map();
+            switch((int)f->freq_range) {
+            case 0:
+            case 1:
+                jpg_write_div = 10;
+                break;
+            case 2:
+            case 3:
+                jpg_write_div = 5;
+                break;
+            case 4:
+            case 5:
+                jpg_write_div = 0;
+                break;
+            }
+            /* the rate of the previous settings no longer applies */
+            tmp_result.spectra_rate = 0;
+            rate_cnt = 0;
+            rate_start = rp_spectr_time_ns();
+            /* spectra of another range do not average */
+            rp_spectr_avg_reset();
+        }
 
         rp_spectr_prepare_freq_vector(&rp_tmp_signals[0], 
                                       spectr_get_fpga_smpl_freq(),
-                                      curr_params[FREQ_RANGE_PARAM].value);
-
-        rp_spectr_hann_filter(&rp_cha_in[0], &rp_chb_in[0],
-                              &rp_cha_in, &rp_chb_in);
-        
-        rp_spectr_fft(&rp_cha_in[0], &rp_chb_in[0], 
-                      (double **)&rp_cha_fft, (double **)&rp_chb_fft);
-        
-        rp_spectr_decimate(&rp_cha_fft[0], &rp_chb_fft[0], 
-                           (float **)&rp_tmp_signals[1], 
-                           (float **)&rp_tmp_signals[2],
-                           c_dsp_sig_len, SPECTR_OUT_SIG_LEN);
-        
-        rp_spectr_cnv_to_dBm(&rp_tmp_signals[1][0], &rp_tmp_signals[2][0], 
-                             (float **)&rp_tmp_signals[1], 
-                             (float **)&rp_tmp_signals[2], 
-                             &tmp_result.peak_pw_cha, 
-                             &tmp_result.peak_pw_freq_cha,
-                             &tmp_result.peak_pw_chb, 
-                             &tmp_result.peak_pw_freq_chb,
-                             curr_params[FREQ_RANGE_PARAM].value);
+                                      f->freq_range);
+
+        /* the waterfall is the only user of the FFT amplitudes */
+        rp_spectr_process(f->cha, f->chb, 0,
+                          rp_tmp_signals[1], rp_tmp_signals[2],
+                          wf_func_table ? rp_cha_fft : NULL,
+                          wf_func_table ? rp_chb_fft : NULL,
+                          &tmp_result.peak_pw_cha, 
+                          &tmp_result.peak_pw_freq_cha,
+                          &tmp_result.peak_pw_chb, 
+                          &tmp_result.peak_pw_freq_chb,
+                          f->freq_range);
+        rp_spectr_frame_release(f);
+        rp_spectr_get_hold(rp_tmp_signals[SPECTR_OUT_HOLD_SIG], rp_tmp_signals[SPECTR_OUT_HOLD_SIG + 1],
+                           rp_tmp_signals[SPECTR_OUT_HOLD_SIG + 2], rp_tmp_signals[SPECTR_OUT_HOLD_SIG + 3]);
+
         /* Calculate the map used for Waterfall diagram  */
 		float fm, fmin, ff;
 		spec_getFreqMax(&fm);
@@ -520,13 +682,19 @@ void *rp_spectr_worker_thread(void *args)
             loop_cnt = 0;
         }
 
+        /* Spectra per second over the last measurement period */
+        int64_t now = rp_spectr_time_ns();
+        rate_cnt++;
+        if(now - rate_start >= c_rate_period_ns) {
+            tmp_result.spectra_rate = rate_cnt * 1e9 / (float)(now - rate_start);
+            rate_cnt = 0;
+            rate_start = now;
+        }
 
         /* Copy the result to the output part - and also the index of
          * last JPEG file index */
         tmp_result.jpg_idx = jpg_fn_cnt;
         rp_spectr_set_signals(rp_tmp_signals, tmp_result);
-
-        usleep(10000);
     }
 
     return 0;
@@ -730,6 +898,8 @@ int spec_stop()
 int spec_reset()
 {
 	rp_set_params(rp_default_params, PARAMS_NUM);
+	rp_spectr_set_welch(1);
+	rp_spectr_set_avg(rp_spectr_avg_linear, 1);
 	rp_spectr_worker_change_state(rp_spectr_auto_state);
 
 	return 0;
@@ -740,6 +910,11 @@ int spec_getViewData(float **signals, size_t size)
     return rp_spectr_get_signals_channel(signals, size);
 }
 
+int spec_getHoldData(float **signals, size_t size)
+{
+    return rp_spectr_get_hold_signals(signals, size);
+}
+
 int spec_getJpgIdx(int* jpg)
 {
 	rp_spectr_worker_res_t res;
@@ -776,6 +951,18 @@ int spec_getPeakFreq(int channel, float* freq)
 	return ret;
 }
 
+int spec_getSpectraRate(float* rate)
+{
+	rp_spectr_worker_res_t res;
+	int ret = rp_spectr_get_params(&res);
+	if (!ret)
+	{
+		*rate = spec_running() ? res.spectra_rate : 0;
+	}
+
+	return ret;
+}
+
 int spec_setFreqRange(float _freq_min, float freq)
 {
 	const float ranges[] = { 953.67, 7629.39, 61035.15625, 976562.5, 7812500, 62500000 };
@@ -836,3 +1023,61 @@ int spec_getFreqMin(float* freq)
 
 	return 0;
 }
+
+int spec_setWelchSegments(int segments)
+{
+	return rp_spectr_set_welch(segments) < 0 ? RP_EOOR : RP_OK;
+}
+
+int spec_getWelchSegments(int* segments)
+{
+	*segments = rp_spectr_get_welch();
+
+	return RP_OK;
+}
+
+int spec_setAvgMode(rpApp_spec_avg_t mode)
+{
+	rp_spectr_avg_mode_t m;
+
+	switch (mode) {
+	case RPAPP_SPEC_AVG_LINEAR:
+		m = rp_spectr_avg_linear;
+		break;
+	case RPAPP_SPEC_AVG_EXP:
+		m = rp_spectr_avg_exp;
+		break;
+	default:
+		return RP_EOOR;
+	}
+
+	return rp_spectr_set_avg_mode(m) < 0 ? RP_EOOR : RP_OK;
+}
+
+int spec_getAvgMode(rpApp_spec_avg_t* mode)
+{
+	rp_spectr_avg_mode_t m;
+	int count;
+	rp_spectr_get_avg(&m, &count);
+	*mode = m == rp_spectr_avg_exp ? RPAPP_SPEC_AVG_EXP : RPAPP_SPEC_AVG_LINEAR;
+
+	return RP_OK;
+}
+
+int spec_setAvgCount(int count)
+{
+	return rp_spectr_set_avg_count(count) < 0 ? RP_EOOR : RP_OK;
+}
+
+int spec_getAvgCount(int* count)
+{
+	rp_spectr_avg_mode_t m;
+	rp_spectr_get_avg(&m, count);
+
+	return RP_OK;
+}
+
+int spec_resetAveraging()
+{
+	return rp_spectr_avg_reset() < 0 ? RP_EOOR : RP_OK;
+}
@@ -44,6 +44,7 @@ typedef struct rp_spectr_worker_res_s {
     float peak_pw_freq_cha;
     float peak_pw_chb;
     float peak_pw_freq_chb;
+    float spectra_rate; /* processed spectra per second */
 } rp_spectr_worker_res_t;
 
 /* Parameters indexes - these defines should be in the same order as
@@ -62,9 +63,11 @@ typedef struct rp_spectr_worker_res_s {
 #define JPG_FILE_IDX_PARAM     10
 #define EN_AVG_AT_DEC   		11
 
-/* Output signals */
+/* Output signals: frequency, spectra of channel A and B (the view signals), then
+ * max-hold of A and B, min-hold of A and B (the hold signals) */
 #define SPECTR_OUT_SIG_LEN (2*1024)
-#define SPECTR_OUT_SIG_NUM   3
+#define SPECTR_OUT_SIG_NUM   (RPAPP_SPEC_SIG_NUM + RPAPP_SPEC_HOLD_NUM)
+#define SPECTR_OUT_HOLD_SIG  RPAPP_SPEC_SIG_NUM
 
 extern rp_app_params_t rp_main_params[PARAMS_NUM+1];
 
@@ -74,6 +77,7 @@ int rp_set_params(rp_app_params_t *p, int len);
 int rp_get_params(rp_app_params_t **p);
 int rp_get_signals(float ***s, int *sig_num, int *sig_len);
 int rp_spectr_get_signals_channel(float **signals, size_t size);
+int rp_spectr_get_hold_signals(float **signals, size_t size);
 int rp_spectr_get_params(rp_spectr_worker_res_t *result);
 
 /* Internal helper functions */
@@ -116,12 +120,16 @@ int spec_reset();
 
 int spec_getViewData(float **signals, size_t size);
 
+int spec_getHoldData(float **signals, size_t size);
+
 int spec_getJpgIdx(int* jpg);
 
 int spec_getPeakPower(int channel, float* power);
 
 int spec_getPeakFreq(int channel, float* freq);
 
+int spec_getSpectraRate(float* rate);
+
 int spec_setFreqRange(float _freq_min, float freq);
 
 int spec_setUnit(int unit);
@@ -134,5 +142,19 @@ int spec_getFreqMax(float* freq);
 
 int spec_getFreqMin(float* freq);
 
+int spec_setWelchSegments(int segments);
+
+int spec_getWelchSegments(int* segments);
+
+int spec_setAvgMode(rpApp_spec_avg_t mode);
+
+int spec_getAvgMode(rpApp_spec_avg_t* mode);
+
+int spec_setAvgCount(int count);
+
+int spec_getAvgCount(int* count);
+
+int spec_resetAveraging();
+
 
 #endif /* __SPECTROMETERAPP_H*/
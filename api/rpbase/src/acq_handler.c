@@ -13,13 +13,18 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <math.h>
+#include <time.h>
+#include <pthread.h>
 
 #include "common.h"
 #include "calib.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
+#include "decimator.h"
 
 
 // Decimation constants
@@ -30,30 +35,41 @@ static const uint32_t DEC_1024  = 1024;
 static const uint32_t DEC_8192  = 8192;
 static const uint32_t DEC_65536 = 65536;
 
-/* @brief ADC buffer size is 16 k samples. */
-static const uint32_t ADC_BUFFER_SIZE = 16 * 1024;
-
 /* @brief Trig. reg. value offset when set to 0 */
 static const int32_t TRIG_DELAY_ZERO_OFFSET = 8192;
 
-/* @brief Sampling period (non-decimated) - 8 [ns]. */
-static const uint64_t ADC_SAMPLE_PERIOD = 8;
-
-/* @brief Number of ADC acquisition bits. */
-static const int ADC_BITS = 14;
-
-/* @brief ADC acquisition bits mask. */
-static const int ADC_BITS_MAK = 0x3FFF;
-
 /* @brief Currently set Gain state */
 static rp_pinState_t gain_ch_a = RP_LOW;
 static rp_pinState_t gain_ch_b = RP_LOW;
 
+/* @brief Incremented on gain change, starts at 1 so that zeroed conversion context is stale */
+static volatile uint32_t gain_generation[2] = { 1, 1 };
+
+/* @brief Conversion contexts used by the V returning functions, refreshed and copied under conv_ctx_mutex */
+static rp_acq_conv_ctx_t conv_ctx[2];
+static pthread_mutex_t conv_ctx_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* @brief Software decimation ratio applied by streaming and buffer reads on top of the FPGA decimation */
+static uint32_t soft_decimation = 1;
+
+/* @brief Decimators of the buffer reads, rebuilt under read_decim_mutex when the software ratio changes */
+static pthread_mutex_t read_decim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rp_decimator_t* read_decim[2] = { NULL, NULL };
+static uint32_t read_decim_ratio = 1;
+static uint32_t read_decim_settle = 0;  // outputs dropped while the filter fills
+static uint32_t read_decim_lead = 0;    // buffer samples read before the first output position
+
+/* @brief Preferred smallest software decimation ratio, below it the FIR runs at the full input rate */
+static const uint32_t SOFT_DEC_PREFERRED_MIN = 8;
+
 /* @brief Determines whether TriggerDelay was set in time or sample units */
 static bool triggerDelayInNs = false;
 
 rp_acq_trig_src_t last_trig_src = RP_TRIG_SRC_DISABLED;
 
+/* @brief Acquisition sequence number, incremented whenever buffer contents get restarted */
+static volatile uint32_t acq_sequence = 0;
+
 /* @brief Default filter equalization coefficients */
 static const uint32_t GAIN_LO_CHA_FILT_AA = 0x7D93;
 static const uint32_t GAIN_LO_CHA_FILT_BB = 0x437C7;
@@ -188,6 +204,7 @@ int acq_SetGain(rp_channel_t channel, rp_pinState_t state)
 
     // Now update the gain
     *gain = state;
+    __sync_add_and_fetch(&gain_generation[channel], 1);
 
     // And recalculate new values...
     int status = acq_SetChannelThreshold(channel, ch_thr);
@@ -198,6 +215,7 @@ int acq_SetGain(rp_channel_t channel, rp_pinState_t state)
     // In case of an error, put old values back and report the error
     if (status != RP_OK) {
         *gain = old_gain;
+        __sync_add_and_fetch(&gain_generation[channel], 1);
         acq_SetChannelThreshold(channel, ch_thr);
         acq_SetChannelThresholdHyst(channel, ch_hyst);
     }
@@ -246,6 +264,42 @@ int acq_GetGainV(rp_channel_t channel, float* voltage)
     return RP_OK;
 }
 
+int acq_GetConvCtx(rp_channel_t channel, rp_acq_conv_ctx_t* ctx)
+{
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+
+    uint32_t generation = calib_GetGeneration() + gain_generation[channel];
+    if (ctx->generation == generation) {
+        return RP_OK;
+    }
+
+    float gainV;
+    rp_pinState_t gain;
+    ECHECK(acq_GetGainV(channel, &gainV));
+    ECHECK(acq_GetGain(channel, &gain));
+
+    rp_calib_params_t calib = calib_GetParams();
+    ctx->dc_offs = (channel == RP_CH_1 ? calib.fe_ch1_dc_offs : calib.fe_ch2_dc_offs);
+    cmn_CnvCntToVCoef(ADC_BITS, gainV, calib_GetFrontEndScale(channel, gain), 0.0, &ctx->scale, &ctx->offset);
+    __atomic_store_n(&ctx->generation, generation, __ATOMIC_RELEASE);
+    return RP_OK;
+}
+
+/* Refreshes the cached conversion context of the channel and returns a copy of it */
+static int getConvCtx(rp_channel_t channel, rp_acq_conv_ctx_t* ctx)
+{
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    pthread_mutex_lock(&conv_ctx_mutex);
+    int ret = acq_GetConvCtx(channel, &conv_ctx[channel]);
+    *ctx = conv_ctx[channel];
+    pthread_mutex_unlock(&conv_ctx_mutex);
+    return ret;
+}
+
 int acq_SetDecimation(rp_acq_decimation_t decimation)
 {
     int64_t time_ns = 0;
@@ -277,6 +331,9 @@ int acq_SetDecimation(rp_acq_decimation_t decimation)
         return RP_EOOR;
     }
 
+    soft_decimation = 1;
+    __sync_add_and_fetch(&acq_sequence, 1);
+
     // Now update trigger delay based on new decimation
     if (triggerDelayInNs) {
         ECHECK(acq_SetTriggerDelayNs(time_ns, true));
@@ -348,6 +405,51 @@ int acq_GetDecimationFactor(uint32_t* decimation)
     }
 }
 
+int acq_SetDecimationRatio(uint32_t ratio)
+{
+    /* FPGA decimation 1 is excluded, software can not keep up with 125 MS/s */
+    static const rp_acq_decimation_t fpga_dec[] = { RP_DEC_65536, RP_DEC_8192, RP_DEC_1024, RP_DEC_64, RP_DEC_8 };
+    static const uint32_t fpga_factor[] = { 65536, 8192, 1024, 64, 8 };
+    int selected = -1;
+
+    if (ratio == DEC_1) {
+        return acq_SetDecimation(RP_DEC_1);
+    }
+
+    /* Descending FPGA factors give ascending software ratios */
+    for (int i = 0; i < sizeof(fpga_factor) / sizeof(fpga_factor[0]); ++i) {
+        if (ratio % fpga_factor[i] != 0) {
+            continue;
+        }
+        uint32_t soft = ratio / fpga_factor[i];
+        if (soft > DECIM_MAX_RATIO) {
+            break;
+        }
+        if (soft > 1 && decim_CheckRatio(soft) != RP_OK) {
+            continue;
+        }
+        selected = i;
+        if (soft == 1 || soft >= SOFT_DEC_PREFERRED_MIN) {
+            break;
+        }
+    }
+    if (selected < 0) {
+        return RP_EOOR;
+    }
+
+    ECHECK(acq_SetDecimation(fpga_dec[selected]));
+    soft_decimation = ratio / fpga_factor[selected];
+    return RP_OK;
+}
+
+int acq_GetDecimationRatio(uint32_t* ratio)
+{
+    uint32_t factor;
+    ECHECK(acq_GetDecimationFactor(&factor));
+    *ratio = factor * soft_decimation;
+    return RP_OK;
+}
+
 
 int acq_SetSamplingRate(rp_acq_sampling_rate_t sampling_rate)
 {
@@ -371,6 +473,11 @@ int acq_SetSamplingRate(rp_acq_sampling_rate_t sampling_rate)
 
 int acq_GetSamplingRate(rp_acq_sampling_rate_t* sampling_rate)
 {
+    /* no predefined rate matches a software decimated one */
+    if (soft_decimation != 1) {
+        return RP_EOOR;
+    }
+
     rp_acq_decimation_t decimation;
     ECHECK(acq_GetDecimation(&decimation));
 
@@ -425,7 +532,8 @@ int acq_GetSamplingRateHz(float* sampling_rate)
             *sampling_rate = max_rate / 65536;
             break;
     }
-    
+    *sampling_rate /= soft_decimation;
+
     return RP_OK;
 }
 
@@ -569,8 +677,6 @@ int acq_SetChannelThreshold(rp_channel_t channel, float voltage)
 
 int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
 {
-    float gainV;
-    rp_pinState_t gain;
     uint32_t cnts;
 
     if (channel == RP_CH_1) {
@@ -580,14 +686,9 @@ int acq_GetChannelThreshold(rp_channel_t channel, float* voltage)
         ECHECK(osc_GetThresholdChB(&cnts));
     }
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = (channel == RP_CH_1 ? calib.fe_ch1_dc_offs : calib.fe_ch2_dc_offs);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
-
-    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    rp_acq_conv_ctx_t ctx;
+    ECHECK(getConvCtx(channel, &ctx));
+    cmn_CnvCntToVBuf(ADC_BITS, &cnts, 1, ctx.dc_offs, ctx.scale, ctx.offset, voltage);
 
     return RP_OK;
 }
@@ -640,8 +741,6 @@ int acq_SetChannelThresholdHyst(rp_channel_t channel, float voltage)
 
 int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
 {
-    float gainV;
-    rp_pinState_t gain;
     uint32_t cnts;
 
     if (channel == RP_CH_1) {
@@ -651,22 +750,18 @@ int acq_GetChannelThresholdHyst(rp_channel_t channel, float* voltage)
         ECHECK(osc_GetHysteresisChB(&cnts));
     }
 
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = (channel == RP_CH_1 ? calib.fe_ch1_dc_offs : calib.fe_ch2_dc_offs);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
-
-    *voltage = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+    rp_acq_conv_ctx_t ctx;
+    ECHECK(getConvCtx(channel, &ctx));
+    cmn_CnvCntToVBuf(ADC_BITS, &cnts, 1, ctx.dc_offs, ctx.scale, ctx.offset, voltage);
 
     return RP_OK;
 }
 
 int acq_Start()
 {
+    __sync_add_and_fetch(&acq_sequence, 1);
     ECHECK(osc_WriteDataIntoMemory(true));
-    return RP_OK;
+    return cmn_Sync();
 }
 
 int acq_Stop()
@@ -676,6 +771,7 @@ int acq_Stop()
 
 int acq_Reset()
 {
+    __sync_add_and_fetch(&acq_sequence, 1);
     ECHECK(acq_SetDefault());
     return osc_ResetWriteStateMachine();
 }
@@ -708,37 +804,217 @@ uint32_t acq_GetNormalizedDataPos(uint32_t pos)
     return (pos % ADC_BUFFER_SIZE);
 }
 
-int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
+static uint64_t getMonotonicTimeNs()
 {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
-    *size = MIN(*size, ADC_BUFFER_SIZE);
+int acq_GetRawSpans(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_raw_spans_t* spans)
+{
+    if (size > ADC_BUFFER_SIZE) {
+        return RP_EOOR;
+    }
 
-    uint32_t cnts;
+    rp_acq_trig_state_t state;
+    spans->sequence = acq_sequence;
+    spans->timestamp_ns = getMonotonicTimeNs();
+    ECHECK(acq_GetWritePointer(&spans->write_pointer));
+    ECHECK(acq_GetWritePointerAtTrig(&spans->trig_pointer));
+    ECHECK(acq_GetTriggerState(&state));
+    ECHECK(acq_GetDecimationFactor(&spans->decimation));
+    spans->triggered = (state == RP_TRIG_STATE_TRIGGERED);
 
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = (channel == RP_CH_1 ? calib.fe_ch1_dc_offs : calib.fe_ch2_dc_offs);
+    spans->pos = acq_GetNormalizedDataPos(pos);
+    spans->size[0] = MIN(size, ADC_BUFFER_SIZE - spans->pos);
+    spans->size[1] = size - spans->size[0];
+    spans->data[0] = spans->size[0] ? &raw_buffer[spans->pos] : NULL;
+    spans->data[1] = spans->size[1] ? raw_buffer : NULL;
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
+    return RP_OK;
+}
+
+int acq_CheckRawSpans(const rp_acq_raw_spans_t* spans, bool* valid)
+{
+    uint32_t write_pointer;
+    rp_acq_trig_state_t state;
 
-        buffer[i] = cmn_CalibCnts(ADC_BITS, cnts, dc_offs);
+    if (spans->sequence != acq_sequence) {
+        *valid = false;
+        return RP_OK;
     }
 
+    ECHECK(acq_GetWritePointer(&write_pointer));
+    ECHECK(acq_GetTriggerState(&state));
+
+    /* Samples written since the spans were taken start right after the old write pointer.
+     * Write pointer alone cannot tell full buffer wraps, so elapsed time bounds the progress. */
+    uint32_t written = acq_GetNormalizedDataPos(write_pointer - spans->write_pointer);
+    uint64_t elapsed_ns = getMonotonicTimeNs() - spans->timestamp_ns;
+    uint64_t max_written = elapsed_ns / (ADC_SAMPLE_PERIOD * spans->decimation) + 1;
+
+    if (max_written >= ADC_BUFFER_SIZE) {
+        /* Write pointer that did not move after trigger means writing has stopped */
+        *valid = (written == 0 && state == RP_TRIG_STATE_TRIGGERED);
+        return RP_OK;
+    }
+
+    uint32_t size = spans->size[0] + spans->size[1];
+    uint32_t start = acq_GetNormalizedDataPos(spans->pos - spans->write_pointer - 1);
+    *valid = (written == 0) || (start >= written && start + size <= ADC_BUFFER_SIZE);
+
     return RP_OK;
 }
 
-int acq_GetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, int16_t* buffer, uint32_t *buffer_size)
+/**
+ * Locks the read decimators and sets them up for the current software decimation ratio,
+ * returned in 'soft'. The caller unlocks read_decim_mutex, also when this fails.
+ */
+static int lockReadDecim(uint32_t* soft)
 {
-    uint32_t size = getSizeFromStartEndPos(start_pos, end_pos);
+    pthread_mutex_lock(&read_decim_mutex);
+    *soft = soft_decimation;
+    if (*soft == 1 || *soft == read_decim_ratio) {
+        return RP_OK;
+    }
+
+    for (int ch = 0; ch < 2; ++ch) {
+        if (read_decim[ch] != NULL) {
+            decim_Destroy(read_decim[ch]);
+            read_decim[ch] = NULL;
+        }
+    }
+    read_decim_ratio = 1;
+    ECHECK(decim_Create(*soft, &read_decim[RP_CH_1]));
+    ECHECK(decim_Create(*soft, &read_decim[RP_CH_2]));
+
+    /* output k is centered on buffer position pos + k * soft once the filter settled */
+    float delay;
+    ECHECK(decim_GetSettle(read_decim[RP_CH_1], &read_decim_settle));
+    ECHECK(decim_GetDelay(read_decim[RP_CH_1], &delay));
+    read_decim_lead = (read_decim_settle + 1) * *soft - (uint32_t) lrintf(delay * *soft) - 1;
+    read_decim_ratio = *soft;
+    return RP_OK;
+}
 
-    if (size > *buffer_size) {
-        return RP_BTS;
+/* Largest number of samples a read returns at the software ratio 'soft' */
+static uint32_t readMaxSize(uint32_t soft)
+{
+    if (soft == 1) {
+        return ADC_BUFFER_SIZE;
     }
+    uint32_t outputs = ADC_BUFFER_SIZE / soft;
+    return outputs > read_decim_settle ? outputs - read_decim_settle : 0;
+}
 
-    *buffer_size = size;
-    return acq_GetDataRaw(channel, start_pos, buffer_size, buffer);
+/* Buffer samples a read of 'size' samples covers from its position on */
+static uint32_t readSpan(uint32_t soft, uint32_t size)
+{
+    if (soft == 1) {
+        return size;
+    }
+    return (read_decim_settle + size) * soft - read_decim_lead;
+}
+
+/* Samples a read covers between buffer positions start_pos and end_pos, one every 'soft' */
+static uint32_t readSizeFromStartEndPos(uint32_t soft, uint32_t start_pos, uint32_t end_pos)
+{
+    return (getSizeFromStartEndPos(start_pos, end_pos) - 1) / soft + 1;
+}
+
+/**
+ * Reads 'size' samples at 'pos' from the raw ADC buffer into calibrated counts (raw) or volts.
+ * With a software ratio the buffer is passed through the read decimator of the channel, which
+ * the caller holds locked: decimated sample k is centered on buffer position pos + k * soft,
+ * samples before pos and after the last position settle the filter.
+ */
+static int readSamples(rp_channel_t channel, uint32_t pos, uint32_t size, uint32_t soft, int16_t* raw, float* volts)
+{
+    rp_acq_conv_ctx_t ctx;
+    ECHECK(getConvCtx(channel, &ctx));
+
+    rp_acq_raw_spans_t spans;
+    if (soft == 1) {
+        ECHECK(acq_GetRawSpans(channel, pos, size, &spans));
+        for (int s = 0; s < 2; ++s) {
+            if (volts != NULL) {
+                /* ADC buffer is plain memory, dropping volatile lets the conversion loop vectorize */
+                cmn_CnvCntToVBuf(ADC_BITS, (const uint32_t*) spans.data[s], spans.size[s], ctx.dc_offs, ctx.scale, ctx.offset, volts);
+                volts += spans.size[s];
+            } else {
+                for (uint32_t i = 0; i < spans.size[s]; ++i) {
+                    *raw++ = cmn_CalibCnts(ADC_BITS, spans.data[s][i] & ADC_BITS_MAK, ctx.dc_offs);
+                }
+            }
+        }
+        return RP_OK;
+    }
+
+    const uint32_t outputs = read_decim_settle + size;
+    const uint32_t total = outputs * soft;
+    ECHECK(acq_GetRawSpans(channel, pos - read_decim_lead, total, &spans));
+
+    int16_t* in = malloc(total * sizeof(int16_t));
+    float* out = malloc(outputs * sizeof(float));
+    if (in == NULL || out == NULL) {
+        free(in);
+        free(out);
+        return RP_EOOR;
+    }
+    int16_t* dst = in;
+    for (int s = 0; s < 2; ++s) {
+        for (uint32_t i = 0; i < spans.size[s]; ++i) {
+            *dst++ = cmn_CalibCnts(ADC_BITS, spans.data[s][i] & ADC_BITS_MAK, ctx.dc_offs);
+        }
+    }
+
+    uint32_t produced = 0;
+    decim_Reset(read_decim[channel]);
+    decim_Process(read_decim[channel], in, total, out, &produced);
+    for (uint32_t i = 0; i < size; ++i) {
+        float cnts = out[read_decim_settle + i];
+        if (volts != NULL) {
+            volts[i] = cnts * ctx.scale + ctx.offset;
+        } else {
+            raw[i] = (int16_t) lrintf(MIN(MAX(cnts, INT16_MIN), INT16_MAX));
+        }
+    }
+
+    free(in);
+    free(out);
+    return RP_OK;
+}
+
+int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
+{
+    uint32_t soft;
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        ret = readSamples(channel, pos, *size, soft, buffer, NULL);
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
+}
+
+int acq_GetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, int16_t* buffer, uint32_t *buffer_size)
+{
+    uint32_t soft;
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        uint32_t size = readSizeFromStartEndPos(soft, start_pos, end_pos);
+        if (size > *buffer_size) {
+            ret = RP_BTS;
+        } else {
+            *buffer_size = MIN(size, readMaxSize(soft));
+            ret = readSamples(channel, start_pos, *buffer_size, soft, buffer, NULL);
+        }
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
 }
 
 /**
@@ -746,144 +1022,496 @@ int acq_GetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos
  */
 int acq_GetOldestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 {
-    uint32_t pos;
+    uint32_t pos, soft;
 
     ECHECK(acq_GetWritePointer(&pos));
     pos++;
 
-    return acq_GetDataRaw(channel, pos, size, buffer);
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        ret = readSamples(channel, pos + (soft == 1 ? 0 : read_decim_lead), *size, soft, buffer, NULL);
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
 }
 
 int acq_GetLatestDataRaw(rp_channel_t channel, uint32_t* size, int16_t* buffer)
 {
-    *size = MIN(*size, ADC_BUFFER_SIZE);
-
-    uint32_t pos;
+    uint32_t pos, soft;
     ECHECK(acq_GetWritePointer(&pos));
 
-    pos++;
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        pos = acq_GetNormalizedDataPos(pos + 1 - readSpan(soft, *size));
+        ret = readSamples(channel, pos, *size, soft, buffer, NULL);
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
+}
 
-    if ((*size) > pos) {
-        pos += ADC_BUFFER_SIZE;
+int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buffer)
+{
+    uint32_t soft;
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        ret = readSamples(channel, pos, *size, soft, NULL, buffer);
     }
-    pos -= (*size);
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
+}
 
-    return acq_GetDataRaw(channel, pos, size, buffer);
+int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
+{
+    uint32_t soft;
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        ret = readSamples(RP_CH_1, pos, *size, soft, NULL, buffer1);
+    }
+    if (ret == RP_OK) {
+        ret = readSamples(RP_CH_2, pos, *size, soft, NULL, buffer2);
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
 }
 
-int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buffer)
+int acq_GetDataPosV(rp_channel_t channel,  uint32_t start_pos, uint32_t end_pos, float* buffer, uint32_t *buffer_size)
 {
-    *size = MIN(*size, ADC_BUFFER_SIZE);
+    uint32_t soft;
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        uint32_t size = readSizeFromStartEndPos(soft, start_pos, end_pos);
+        if (size > *buffer_size) {
+            ret = RP_BTS;
+        } else {
+            *buffer_size = MIN(size, readMaxSize(soft));
+            ret = readSamples(channel, start_pos, *buffer_size, soft, NULL, buffer);
+        }
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
+}
 
-    float gainV;
-    rp_pinState_t gain;
-    ECHECK(acq_GetGainV(channel, &gainV));
-    ECHECK(acq_GetGain(channel, &gain));
+/**
+ * Use only when write pointer has stopped...
+ */
+int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
+{
+    uint32_t pos, soft;
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = (channel == RP_CH_1 ? calib.fe_ch1_dc_offs : calib.fe_ch2_dc_offs);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    ECHECK(acq_GetWritePointer(&pos));
+    pos++;
 
-    const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        ret = readSamples(channel, pos + (soft == 1 ? 0 : read_decim_lead), *size, soft, NULL, buffer);
+    }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
+}
 
-    uint32_t cnts;
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = raw_buffer[(pos + i) % ADC_BUFFER_SIZE];
-        buffer[i] = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
+int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
+{
+    uint32_t pos, soft;
+    ECHECK(acq_GetWritePointer(&pos));
+
+    int ret = lockReadDecim(&soft);
+    if (ret == RP_OK) {
+        *size = MIN(*size, readMaxSize(soft));
+        pos = acq_GetNormalizedDataPos(pos - readSpan(soft, *size));
+        ret = readSamples(channel, pos, *size, soft, NULL, buffer);
     }
+    pthread_mutex_unlock(&read_decim_mutex);
+    return ret;
+}
+
 
+int acq_GetBufferSize(uint32_t *size) {
+    *size = ADC_BUFFER_SIZE;
     return RP_OK;
 }
 
-int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
+/* Polling interval bounds for acq_WaitTrigger() */
+static const uint64_t WAIT_TRIG_MIN_NS = 10000;
+static const uint64_t WAIT_TRIG_MAX_LOW_NS = 1000000;
+static const uint64_t WAIT_TRIG_MAX_NS = 20000000;
+
+static void sleepNs(uint64_t ns)
 {
-    *size = MIN(*size, ADC_BUFFER_SIZE);
+    struct timespec ts = { .tv_sec = ns / 1000000000ULL, .tv_nsec = ns % 1000000000ULL };
+    nanosleep(&ts, NULL);
+}
 
-    float gainV1, gainV2;
-    rp_pinState_t gain1, gain2;
-    ECHECK(acq_GetGainV(RP_CH_1, &gainV1));
-    ECHECK(acq_GetGain(RP_CH_1, &gain1));
-    ECHECK(acq_GetGainV(RP_CH_2, &gainV2));
-    ECHECK(acq_GetGain(RP_CH_2, &gain2));
+static int isTriggered(bool* triggered)
+{
+    uint32_t source;
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs1 = calib.fe_ch1_dc_offs;
-    uint32_t calibScale1 = calib_GetFrontEndScale(RP_CH_1, gain1);
+    /* FPGA clears the trigger source when trigger arrives */
+    ECHECK(osc_GetTriggerSource(&source));
+    *triggered = source == RP_TRIG_SRC_DISABLED;
+    return RP_OK;
+}
 
-    int32_t dc_offs2 = calib.fe_ch2_dc_offs;
-    uint32_t calibScale2 = calib_GetFrontEndScale(RP_CH_2, gain2);
+/*
+ * The scope block raises no interrupt on trigger, so the wait is a sleeping poll. Trigger is
+ * not expected before pre-trigger part of the buffer is filled, so the first sleep covers the
+ * remaining fill time. Afterwards the interval starts at 1/16 of the buffer time (at least 10 us)
+ * and doubles up to half of it, bounded to [1 ms, 20 ms]. Data is safe regardless of the wake-up latency
+ * since writing stops trigger delay samples after the trigger.
+ */
+int acq_WaitTrigger(int64_t timeout_ns)
+{
+    uint32_t decimation, pre_count, trig_dly;
+    bool triggered;
+    uint64_t start_ns = getMonotonicTimeNs();
 
-    const volatile uint32_t* raw_buffer1 = getRawBuffer(RP_CH_1);
-    const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
-    
-    uint32_t cnts1[*size];
-    uint32_t cnts2[*size];
-    uint32_t* ptr1 = cnts1;
-    uint32_t* ptr2 = cnts2;
-    
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *ptr1++ = raw_buffer1[pos];
-        *ptr2++ = raw_buffer2[pos];
-        pos = (pos + 1) % ADC_BUFFER_SIZE;
+    ECHECK(isTriggered(&triggered));
+    if (triggered) {
+        return RP_OK;
     }
-    
-    ptr1 = cnts1;
-    ptr2 = cnts2;
-    
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *buffer1++ = cmn_CnvCntToV(ADC_BITS, *ptr1++, gainV1, calibScale1, dc_offs1, 0.0);
-        *buffer2++ = cmn_CnvCntToV(ADC_BITS, *ptr2++, gainV2, calibScale2, dc_offs2, 0.0);
+
+    ECHECK(acq_GetDecimationFactor(&decimation));
+    ECHECK(acq_GetPreTriggerCounter(&pre_count));
+    ECHECK(osc_GetTriggerDelay(&trig_dly));
+
+    const uint64_t period = ADC_SAMPLE_PERIOD * decimation;
+    const uint64_t buffer_ns = ADC_BUFFER_SIZE * period;
+    const uint64_t max_ns = MIN(MAX(buffer_ns / 2, WAIT_TRIG_MAX_LOW_NS), WAIT_TRIG_MAX_NS);
+    uint64_t interval = MIN(MAX(buffer_ns / 16, WAIT_TRIG_MIN_NS), max_ns);
+
+    uint32_t pre_size = trig_dly < ADC_BUFFER_SIZE ? ADC_BUFFER_SIZE - trig_dly : 0;
+    uint64_t next = pre_count < pre_size ? MIN((pre_size - pre_count) * period, max_ns) : interval;
+
+    while (true) {
+        if (timeout_ns >= 0) {
+            uint64_t elapsed = getMonotonicTimeNs() - start_ns;
+            if (elapsed >= (uint64_t)timeout_ns) {
+                return RP_ETMO;
+            }
+            next = MIN(next, (uint64_t)timeout_ns - elapsed);
+        }
+        sleepNs(next);
+
+        ECHECK(isTriggered(&triggered));
+        if (triggered) {
+            return RP_OK;
+        }
+        next = interval;
+        interval = MIN(interval * 2, max_ns);
     }
+}
+
+static bool isTimedOut(uint64_t start_ns, int32_t timeout_ms)
+{
+    return timeout_ms >= 0 && getMonotonicTimeNs() > start_ns + (uint64_t)timeout_ms * 1000000ULL;
+}
+
+/* Longest sleep of the segment polling loops, bounds the dead time a late wake-up adds */
+static const uint64_t SEGMENT_POLL_MAX_NS = 1000000;
+
+/* Sleeps until about 'samples' more samples are written, within [WAIT_TRIG_MIN_NS, SEGMENT_POLL_MAX_NS] */
+static void sleepSamples(uint64_t samples, uint64_t period)
+{
+    sleepNs(MIN(MAX(samples * period, WAIT_TRIG_MIN_NS), SEGMENT_POLL_MAX_NS));
+}
+
+/* Consumes segment 'index' of 'size' samples starting at buffer position 'pos'. Called again with
+ * the same index when the segment may have been overwritten while it was read and is captured again. */
+typedef int (*segment_sink_t)(uint32_t index, uint32_t pos, uint32_t size, void* arg);
 
+typedef struct {
+    int16_t* arena[2];
+} segment_arenas_t;
+
+static int readSegment(uint32_t index, uint32_t pos, uint32_t size, void* arg)
+{
+    segment_arenas_t* arenas = (segment_arenas_t*) arg;
+    for (int ch = 0; ch < 2; ++ch) {
+        if (arenas->arena[ch] != NULL) {
+            /* segments stay at the FPGA rate, the software decimation is not applied */
+            ECHECK(readSamples((rp_channel_t) ch, pos, size, 1, &arenas->arena[ch][(size_t)index * size], NULL));
+        }
+    }
     return RP_OK;
 }
 
-int acq_GetDataPosV(rp_channel_t channel,  uint32_t start_pos, uint32_t end_pos, float* buffer, uint32_t *buffer_size)
+static int captureSegments(uint32_t* count, uint32_t size, uint32_t pre_trigger, segment_sink_t sink, void* arg,
+                           rp_acq_segment_t* segments, int32_t timeout_ms, rp_acq_trig_src_t source)
 {
-    uint32_t size = getSizeFromStartEndPos(start_pos, end_pos);
-    if (size > *buffer_size) {
-        return RP_BTS;
+    uint32_t decimation, wp, trig_src;
+    ECHECK(acq_GetDecimationFactor(&decimation));
+
+    const uint64_t period = ADC_SAMPLE_PERIOD * decimation;
+    const uint32_t post = size - pre_trigger;
+    const uint32_t requested = *count;
+    uint64_t stop_ns = getMonotonicTimeNs();
+    bool early_arm = false;
+
+    *count = 0;
+    /* A source left enabled would trigger before the pre-trigger part is filled */
+    ECHECK(osc_SetTriggerSource(RP_TRIG_SRC_DISABLED));
+    ECHECK(acq_Start());
+
+    while (*count < requested) {
+        rp_acq_segment_t seg;
+        uint32_t i = *count;
+        uint64_t wait_ns = getMonotonicTimeNs();
+
+        /* Trigger is only enabled when pre-trigger part of the segment is in the buffer */
+        uint32_t pre_count;
+        ECHECK(acq_GetPreTriggerCounter(&pre_count));
+        while (pre_count < pre_trigger) {
+            /* only guards against a stalled write pointer, the fill time itself does not count */
+            if (isTimedOut(wait_ns + pre_trigger * period, timeout_ms)) return RP_ETMO;
+            sleepSamples(pre_trigger - pre_count, period);
+            ECHECK(acq_GetPreTriggerCounter(&pre_count));
+        }
+        ECHECK(osc_SetTriggerSource(source));
+        uint64_t ready_ns = getMonotonicTimeNs();
+
+        /* FPGA clears trigger source when trigger arrives. The timeout counts from here,
+         * so it is not shortened by the pre-trigger fill. The interval doubles while waiting. */
+        uint64_t interval = WAIT_TRIG_MIN_NS;
+        ECHECK(osc_GetTriggerSource(&trig_src));
+        while (trig_src != RP_TRIG_SRC_DISABLED) {
+            if (isTimedOut(ready_ns, timeout_ms)) return RP_ETMO;
+            sleepNs(interval);
+            interval = MIN(interval * 2, SEGMENT_POLL_MAX_NS);
+            ECHECK(osc_GetTriggerSource(&trig_src));
+        }
+
+        seg.timestamp_ns = getMonotonicTimeNs();
+        seg.dead_time_ns = ready_ns - stop_ns;
+        ECHECK(acq_GetWritePointerAtTrig(&seg.trig_pointer));
+
+        uint32_t written;
+        ECHECK(acq_GetWritePointer(&wp));
+        while ((written = acq_GetNormalizedDataPos(wp - seg.trig_pointer)) < post) {
+            if (isTimedOut(seg.timestamp_ns + post * period, timeout_ms)) return RP_ETMO;
+            sleepSamples(post - written, period);
+            ECHECK(acq_GetWritePointer(&wp));
+        }
+        stop_ns = getMonotonicTimeNs();
+
+        uint32_t pos = acq_GetNormalizedDataPos(seg.trig_pointer - pre_trigger);
+        bool last = (i + 1 == requested);
+
+        if (early_arm && !last) {
+            /* New acquisition starts writing behind the segment, read it out before it wraps around */
+            ECHECK(acq_Start());
+            ECHECK(sink(i, pos, size, arg));
+            uint64_t read_ns = getMonotonicTimeNs() - stop_ns;
+            if (read_ns / period + 1 > ADC_BUFFER_SIZE - size) {
+                /* Segment may have been overwritten, capture it again */
+                early_arm = false;
+                continue;
+            }
+            early_arm = 2 * (read_ns / period + 1) <= ADC_BUFFER_SIZE - size;
+        }
+        else {
+            ECHECK(sink(i, pos, size, arg));
+            uint64_t read_ns = getMonotonicTimeNs() - stop_ns;
+            if (!last) {
+                ECHECK(acq_Start());
+            }
+            early_arm = 2 * (read_ns / period + 1) <= ADC_BUFFER_SIZE - size;
+        }
+
+        if (segments != NULL) {
+            segments[i] = seg;
+        }
+        *count = i + 1;
     }
-    *buffer_size = size;
-    return acq_GetDataV(channel, start_pos, buffer_size, buffer);
+
+    return RP_OK;
 }
 
-/**
- * Use only when write pointer has stopped...
- */
-int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
+static int checkSegmentArgs(uint32_t size, uint32_t pre_trigger)
+{
+    if (size == 0 || size >= ADC_BUFFER_SIZE || pre_trigger > size) {
+        return RP_EOOR;
+    }
+    if (last_trig_src == RP_TRIG_SRC_DISABLED) {
+        return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+static int runSegments(uint32_t* count, uint32_t size, uint32_t pre_trigger, segment_sink_t sink, void* arg,
+                       rp_acq_segment_t* segments, int32_t timeout_ms)
 {
-    uint32_t pos;
+    uint32_t trig_dly;
+    ECHECK(osc_GetTriggerDelay(&trig_dly));
 
-    ECHECK(acq_GetWritePointer(&pos));
-    pos++;
+    /* Writing stops right after the segment; one extra sample covers the write pointer latency */
+    ECHECK(osc_SetTriggerDelay(size - pre_trigger + 1));
+    int ret = captureSegments(count, size, pre_trigger, sink, arg, segments, timeout_ms, last_trig_src);
+    ECHECK(osc_SetTriggerDelay(trig_dly));
 
-    return acq_GetDataV(channel, pos, size, buffer);
+    return ret;
 }
 
-int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer)
+int acq_GetSegments(uint32_t* count, uint32_t size, uint32_t pre_trigger, int16_t* arena1, int16_t* arena2,
+                    rp_acq_segment_t* segments, int32_t timeout_ms)
 {
-    *size = MIN(*size, ADC_BUFFER_SIZE);
+    ECHECK(checkSegmentArgs(size, pre_trigger));
 
-    uint32_t pos;
-    ECHECK(acq_GetWritePointer(&pos));
+    segment_arenas_t arenas = { .arena = { arena1, arena2 } };
+    return runSegments(count, size, pre_trigger, readSegment, &arenas, segments, timeout_ms);
+}
 
-    pos = (pos - (*size)) % ADC_BUFFER_SIZE;
+/* Per channel accumulators of ensemble averaging, NULL for channels not requested. The 32 bit
+ * sums take at most CMN_ACC_SQ_MAX_FRAMES frames before they are flushed into the 64 bit totals.
+ * A frame is staged in raw[] and only accumulated once the next one arrives, as it may still
+ * be captured again. */
+typedef struct {
+    uint32_t* raw[2];
+    int64_t staged;             // index of the staged frame, -1 for none
+    int32_t* sum[2];
+    uint32_t* sum_sq[2];
+    int64_t* sum_total[2];
+    uint64_t* sum_sq_total[2];
+    int32_t dc_offs[2];
+    uint32_t pending;
+} frame_acc_t;
+
+static void flushTotals(frame_acc_t* acc, uint32_t size)
+{
+    for (int ch = 0; ch < 2; ++ch) {
+        if (acc->sum[ch] != NULL) {
+            for (uint32_t i = 0; i < size; ++i) {
+                acc->sum_total[ch][i] += acc->sum[ch][i];
+                acc->sum_sq_total[ch][i] += acc->sum_sq[ch][i];
+            }
+            memset(acc->sum[ch], 0, size * sizeof(int32_t));
+            memset(acc->sum_sq[ch], 0, size * sizeof(uint32_t));
+        }
+    }
+    acc->pending = 0;
+}
+
+static void accumulateStaged(frame_acc_t* acc, uint32_t size)
+{
+    for (int ch = 0; ch < 2; ++ch) {
+        if (acc->sum[ch] != NULL) {
+            cmn_AccumulateCnts(ADC_BITS, acc->raw[ch], size, acc->dc_offs[ch], acc->sum[ch], acc->sum_sq[ch]);
+        }
+    }
+    acc->staged = -1;
 
-    return acq_GetDataV(channel, pos, size, buffer);
+    if (++acc->pending == CMN_ACC_SQ_MAX_FRAMES) {
+        flushTotals(acc, size);
+    }
 }
 
+static int accumulateSegment(uint32_t index, uint32_t pos, uint32_t size, void* arg)
+{
+    frame_acc_t* acc = (frame_acc_t*) arg;
 
-int acq_GetBufferSize(uint32_t *size) {
-    *size = ADC_BUFFER_SIZE;
+    /* a new index means the staged frame was kept */
+    if (acc->staged >= 0 && acc->staged != index) {
+        accumulateStaged(acc, size);
+    }
+
+    for (int ch = 0; ch < 2; ++ch) {
+        if (acc->sum[ch] == NULL) {
+            continue;
+        }
+        rp_acq_raw_spans_t spans;
+        ECHECK(acq_GetRawSpans((rp_channel_t) ch, pos, size, &spans));
+        /* ADC buffer is plain memory, dropping volatile lets the copy use wide loads */
+        memcpy(acc->raw[ch], (const uint32_t*) spans.data[0], spans.size[0] * sizeof(uint32_t));
+        memcpy(&acc->raw[ch][spans.size[0]], (const uint32_t*) spans.data[1], spans.size[1] * sizeof(uint32_t));
+    }
+    acc->staged = index;
     return RP_OK;
 }
 
+static int averageFrames(frame_acc_t* acc, uint32_t* count, uint32_t size, uint32_t pre_trigger,
+                         float* avg[2], float* var[2], int32_t timeout_ms)
+{
+    for (int ch = 0; ch < 2; ++ch) {
+        if (avg[ch] == NULL) {
+            continue;
+        }
+        rp_acq_conv_ctx_t ctx;
+        ECHECK(getConvCtx((rp_channel_t) ch, &ctx));
+        acc->dc_offs[ch] = ctx.dc_offs;
+        acc->raw[ch] = malloc(size * sizeof(uint32_t));
+        acc->sum[ch] = calloc(size, sizeof(int32_t));
+        acc->sum_sq[ch] = calloc(size, sizeof(uint32_t));
+        acc->sum_total[ch] = calloc(size, sizeof(int64_t));
+        acc->sum_sq_total[ch] = calloc(size, sizeof(uint64_t));
+        if (acc->raw[ch] == NULL || acc->sum[ch] == NULL || acc->sum_sq[ch] == NULL || acc->sum_total[ch] == NULL ||
+            acc->sum_sq_total[ch] == NULL) {
+            return RP_EOOR;
+        }
+    }
+
+    int ret = runSegments(count, size, pre_trigger, accumulateSegment, acc, NULL, timeout_ms);
+    if ((ret != RP_OK && ret != RP_ETMO) || *count == 0) {
+        return ret;
+    }
+    /* the last frame staged counts unless a timeout hit while it was captured again */
+    if (acc->staged >= 0 && acc->staged < *count) {
+        accumulateStaged(acc, size);
+    }
+    flushTotals(acc, size);
+
+    const double n = *count;
+    for (int ch = 0; ch < 2; ++ch) {
+        if (avg[ch] == NULL) {
+            continue;
+        }
+        rp_acq_conv_ctx_t ctx;
+        ECHECK(getConvCtx((rp_channel_t) ch, &ctx));
+        for (uint32_t i = 0; i < size; ++i) {
+            double mean = acc->sum_total[ch][i] / n;
+            avg[ch][i] = (float)mean * ctx.scale + ctx.offset;
+            if (var[ch] != NULL) {
+                double v = *count > 1 ? ((double)acc->sum_sq_total[ch][i] - mean * acc->sum_total[ch][i]) / (n - 1) : 0;
+                var[ch][i] = (float)(MAX(v, 0) * ctx.scale * ctx.scale);
+            }
+        }
+    }
+    return ret;
+}
+
+int acq_AverageFrames(uint32_t* count, uint32_t size, uint32_t pre_trigger, float* avg1, float* avg2,
+                      float* var1, float* var2, int32_t timeout_ms)
+{
+    ECHECK(checkSegmentArgs(size, pre_trigger));
+    if (*count == 0 || (avg1 == NULL && avg2 == NULL)) {
+        return RP_EOOR;
+    }
+
+    float* avg[2] = { avg1, avg2 };
+    float* var[2] = { avg1 ? var1 : NULL, avg2 ? var2 : NULL };
+    frame_acc_t acc;
+    memset(&acc, 0, sizeof(acc));
+    acc.staged = -1;
+
+    int ret = averageFrames(&acc, count, size, pre_trigger, avg, var, timeout_ms);
+
+    for (int ch = 0; ch < 2; ++ch) {
+        free(acc.raw[ch]);
+        free(acc.sum[ch]);
+        free(acc.sum_sq[ch]);
+        free(acc.sum_total[ch]);
+        free(acc.sum_sq_total[ch]);
+    }
+    return ret;
+}
+
 /**
  * Sets default configuration
  * @return
  */
-int acq_SetDefault() {
+static int setDefaultValues() {
     ECHECK(acq_SetChannelThreshold(RP_CH_1, 0.0));
     ECHECK(acq_SetChannelThreshold(RP_CH_2, 0.0));
     ECHECK(acq_SetChannelThresholdHyst(RP_CH_1, 0.0));
@@ -900,3 +1528,11 @@ int acq_SetDefault() {
 
     return RP_OK;
 }
+
+int acq_SetDefault() {
+    // Coalesce the configuration register writes, see cmn_RegBatchBegin()
+    ECHECK(cmn_RegBatchBegin());
+    int ret = setDefaultValues();
+    ECHECK(cmn_RegBatchCommit());
+    return ret;
+}
@@ -26,6 +26,8 @@ int acq_GetGainV(rp_channel_t channel, float* voltage);
 int acq_SetDecimation(rp_acq_decimation_t decimation);
 int acq_GetDecimation(rp_acq_decimation_t* decimation);
 int acq_GetDecimationFactor(uint32_t* decimation);
+int acq_SetDecimationRatio(uint32_t ratio);
+int acq_GetDecimationRatio(uint32_t* ratio);
 int acq_SetSamplingRate(rp_acq_sampling_rate_t sampling_rate);
 int acq_GetSamplingRate(rp_acq_sampling_rate_t* sampling_rate);
 int acq_GetSamplingRateHz(float* sampling_rate);
@@ -65,6 +67,14 @@ int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int acq_GetBufferSize(uint32_t *size);
+int acq_GetConvCtx(rp_channel_t channel, rp_acq_conv_ctx_t* ctx);
+int acq_WaitTrigger(int64_t timeout_ns);
+int acq_GetRawSpans(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_raw_spans_t* spans);
+int acq_CheckRawSpans(const rp_acq_raw_spans_t* spans, bool* valid);
+int acq_GetSegments(uint32_t* count, uint32_t size, uint32_t pre_trigger, int16_t* arena1, int16_t* arena2,
+                    rp_acq_segment_t* segments, int32_t timeout_ms);
+int acq_AverageFrames(uint32_t* count, uint32_t size, uint32_t pre_trigger, float* avg1, float* avg2,
+                      float* var1, float* var2, int32_t timeout_ms);
 
 int acq_SetDefault();
 
@@ -0,0 +1,453 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library continuous acquisition streaming implementation
+ *
+ * Background thread follows the ADC write pointer and copies every sample exactly once,
+ * in chunks of fixed size, into a preallocated single producer / single consumer queue.
+ * Queue indices are only written by one side each, so no locking is needed. Consumer is
+ * woken up through an eventfd, which can also be polled by the application.
+ * With a software decimation ratio set, the thread reads the ADC buffer in blocks, passes
+ * them through one decimator per channel and queues chunks of decimated samples.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "common.h"
+#include "calib.h"
+#include "oscilloscope.h"
+#include "acq_handler.h"
+#include "acq_stream.h"
+#include "decimator.h"
+
+/* @brief Longest producer sleep while waiting for a chunk to fill [ns] */
+static const uint64_t MAX_WAIT_NS = 10000000;
+
+/* @brief Stop re-signals blocked readers at this period until they left [ns] */
+static const uint64_t READER_WAKE_NS = 1000000;
+
+/* @brief Largest ADC block read at once when decimating in software */
+static const uint32_t MAX_DECIM_BLOCK = 16 * 1024 / 4;
+
+typedef struct {
+    uint64_t sequence;
+} stream_chunk_t;
+
+static struct {
+    bool running;
+    pthread_t thread;
+    int efd;
+    /* acq_StreamRead() calls in flight, stop waits for them before freeing */
+    uint32_t readers;
+
+    uint32_t chunk_size;
+    uint32_t chunk_num;
+    stream_chunk_t* chunks;
+    int16_t* data;
+
+    /* ADC samples read at once, chunk_size unless decimating in software */
+    uint32_t block_size;
+
+    /* software decimation, used only by producer */
+    uint32_t decimation;
+    rp_decimator_t* decim[2];
+    int16_t* block;
+    float* decim_out;
+    /* decimated samples of the last block, fresh_size per channel */
+    int16_t* fresh;
+    uint32_t fresh_size;
+    /* chunk being assembled, chunk_size per channel */
+    int16_t* pending;
+    uint32_t pending_fill;
+
+    /* written only by producer */
+    volatile uint32_t head;
+    /* written only by consumer */
+    volatile uint32_t tail;
+
+    rp_acq_stream_stats_t stats;
+} stream = { .running = false, .efd = -1 };
+
+static uint64_t getTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleepNs(uint64_t ns)
+{
+    struct timespec ts = { .tv_sec = ns / 1000000000ULL, .tv_nsec = ns % 1000000000ULL };
+    nanosleep(&ts, NULL);
+}
+
+static void notify()
+{
+    uint64_t one = 1;
+    if (write(stream.efd, &one, sizeof(one)) != sizeof(one)) {
+        fprintf(stderr, "Stream: failed to signal event\n");
+    }
+}
+
+static int copyBlock(rp_channel_t channel, uint32_t pos, uint32_t size, int32_t dc_offs, int16_t* buffer)
+{
+    rp_acq_raw_spans_t spans;
+    ECHECK(acq_GetRawSpans(channel, pos, size, &spans));
+
+    for (int s = 0; s < 2; ++s) {
+        const volatile uint32_t* raw = spans.data[s];
+        for (uint32_t i = 0; i < spans.size[s]; ++i) {
+            *buffer++ = cmn_CalibCnts(ADC_BITS, raw[i] & ADC_BITS_MAK, dc_offs);
+        }
+    }
+    return RP_OK;
+}
+
+/* Returns the free queue slot, or NULL when the queue is full and the chunk is dropped */
+static int16_t* reserveChunk()
+{
+    uint32_t head = stream.head;
+    uint32_t tail = __atomic_load_n(&stream.tail, __ATOMIC_ACQUIRE);
+
+    __atomic_add_fetch(&stream.stats.chunks, 1, __ATOMIC_RELAXED);
+
+    if (head - tail >= stream.chunk_num) {
+        __atomic_add_fetch(&stream.stats.overruns, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    return &stream.data[(size_t)(head % stream.chunk_num) * 2 * stream.chunk_size];
+}
+
+static void commitChunk(uint64_t sequence)
+{
+    uint32_t head = stream.head;
+    stream.chunks[head % stream.chunk_num].sequence = sequence;
+    __atomic_store_n(&stream.head, head + 1, __ATOMIC_RELEASE);
+    notify();
+}
+
+static int produceChunk(uint32_t pos, uint64_t* sequence)
+{
+    int16_t* data = reserveChunk();
+    if (data != NULL) {
+        rp_calib_params_t calib = calib_GetParams();
+        ECHECK(copyBlock(RP_CH_1, pos, stream.chunk_size, calib.fe_ch1_dc_offs, data));
+        ECHECK(copyBlock(RP_CH_2, pos, stream.chunk_size, calib.fe_ch2_dc_offs, data + stream.chunk_size));
+        commitChunk(*sequence);
+    }
+    (*sequence)++;
+    return RP_OK;
+}
+
+static int decimateBlock(rp_channel_t channel, uint32_t pos, int32_t dc_offs, uint32_t* size)
+{
+    ECHECK(copyBlock(channel, pos, stream.block_size, dc_offs, stream.block));
+    ECHECK(decim_Process(stream.decim[channel], stream.block, stream.block_size, stream.decim_out, size));
+
+    int16_t* out = &stream.fresh[channel * stream.fresh_size];
+    for (uint32_t i = 0; i < *size; ++i) {
+        out[i] = (int16_t)lrintf(stream.decim_out[i]);
+    }
+    return RP_OK;
+}
+
+/* Both decimators see the same number of samples, so they produce equally long output */
+static int produceDecimated(uint32_t pos, uint64_t* sequence)
+{
+    rp_calib_params_t calib = calib_GetParams();
+    uint32_t produced = 0, offset = 0;
+
+    ECHECK(decimateBlock(RP_CH_1, pos, calib.fe_ch1_dc_offs, &produced));
+    ECHECK(decimateBlock(RP_CH_2, pos, calib.fe_ch2_dc_offs, &produced));
+
+    while (offset < produced) {
+        uint32_t size = MIN(produced - offset, stream.chunk_size - stream.pending_fill);
+        for (int ch = 0; ch < 2; ++ch) {
+            memcpy(&stream.pending[ch * stream.chunk_size + stream.pending_fill],
+                   &stream.fresh[ch * stream.fresh_size + offset], size * sizeof(int16_t));
+        }
+        stream.pending_fill += size;
+        offset += size;
+
+        if (stream.pending_fill == stream.chunk_size) {
+            int16_t* data = reserveChunk();
+            if (data != NULL) {
+                memcpy(data, stream.pending, 2 * stream.chunk_size * sizeof(int16_t));
+                commitChunk(*sequence);
+            }
+            (*sequence)++;
+            stream.pending_fill = 0;
+        }
+    }
+    return RP_OK;
+}
+
+/* Readers see the stream stopped and are woken up, rp_AcqStreamStop() still releases it */
+static void stopOnError()
+{
+    __atomic_store_n(&stream.running, false, __ATOMIC_RELEASE);
+    notify();
+}
+
+static void* streamThreadFun(void* arg)
+{
+    uint32_t wp, decimation;
+    uint64_t sequence = 0;
+
+    if (acq_GetWritePointer(&wp) != RP_OK || acq_GetDecimationFactor(&decimation) != RP_OK) {
+        stopOnError();
+        return NULL;
+    }
+
+    const uint64_t period = ADC_SAMPLE_PERIOD * decimation;
+    /* Next sample to be copied, first one that is not yet written */
+    uint32_t next = acq_GetNormalizedDataPos(wp + 1);
+    uint32_t avail = 0;
+    uint64_t last_ns = getTimeNs();
+
+    while (__atomic_load_n(&stream.running, __ATOMIC_ACQUIRE)) {
+        if (acq_GetWritePointer(&wp) != RP_OK) {
+            stopOnError();
+            break;
+        }
+        uint64_t now_ns = getTimeNs();
+
+        /* Write pointer progress is only known modulo buffer size. Elapsed time bounds the
+         * real progress: when it could exceed the unread headroom, samples were lost. */
+        uint32_t fill = acq_GetNormalizedDataPos(wp + 1 - next);
+        uint64_t max_fill = avail + (now_ns - last_ns) / period + 1;
+        last_ns = now_ns;
+
+        if (max_fill >= ADC_BUFFER_SIZE || fill > ADC_BUFFER_SIZE - stream.block_size) {
+            uint64_t lost = MAX(max_fill, fill) - stream.block_size;
+            __atomic_add_fetch(&stream.stats.lost_samples, lost, __ATOMIC_RELAXED);
+            if (stream.decimation > 1) {
+                /* decimators restart on the new data, the unfinished chunk is dropped */
+                uint64_t chunk_in = (uint64_t)stream.chunk_size * stream.decimation;
+                sequence += 1 + lost / chunk_in;
+                stream.pending_fill = 0;
+                decim_Reset(stream.decim[RP_CH_1]);
+                decim_Reset(stream.decim[RP_CH_2]);
+            } else {
+                sequence += (lost + stream.chunk_size - 1) / stream.chunk_size;
+            }
+            next = acq_GetNormalizedDataPos(wp + 1 - stream.block_size);
+            fill = stream.block_size;
+        }
+
+        while (fill >= stream.block_size) {
+            int ret = stream.decimation > 1 ? produceDecimated(next, &sequence) : produceChunk(next, &sequence);
+            if (ret != RP_OK) {
+                stopOnError();
+                return NULL;
+            }
+            next = acq_GetNormalizedDataPos(next + stream.block_size);
+            fill -= stream.block_size;
+        }
+        avail = fill;
+
+        uint64_t wait_ns = (uint64_t)(stream.block_size - fill) * period;
+        sleepNs(MIN(wait_ns, MAX_WAIT_NS));
+    }
+
+    return NULL;
+}
+
+static void freeStream()
+{
+    for (int ch = 0; ch < 2; ++ch) {
+        if (stream.decim[ch] != NULL) {
+            decim_Destroy(stream.decim[ch]);
+            stream.decim[ch] = NULL;
+        }
+    }
+    free(stream.chunks);
+    free(stream.data);
+    free(stream.block);
+    free(stream.decim_out);
+    free(stream.fresh);
+    free(stream.pending);
+    stream.chunks = NULL;
+    stream.data = NULL;
+    stream.block = NULL;
+    stream.decim_out = NULL;
+    stream.fresh = NULL;
+    stream.pending = NULL;
+    if (stream.efd >= 0) {
+        close(stream.efd);
+        stream.efd = -1;
+    }
+}
+
+int acq_StreamStart(uint32_t chunk_size, uint32_t chunk_num)
+{
+    /* Event fd is open from start until stop, even when the thread stopped on an error */
+    if (stream.efd >= 0) {
+        return RP_EBSY;
+    }
+    if (chunk_size == 0 || chunk_size > ADC_BUFFER_SIZE / 2 || chunk_num < 2) {
+        return RP_EOOR;
+    }
+
+    stream.chunk_size = chunk_size;
+    stream.chunk_num = chunk_num;
+    stream.head = 0;
+    stream.tail = 0;
+    memset(&stream.stats, 0, sizeof(stream.stats));
+
+    uint32_t ratio, factor;
+    ECHECK(acq_GetDecimationRatio(&ratio));
+    ECHECK(acq_GetDecimationFactor(&factor));
+    stream.decimation = ratio / factor;
+    stream.block_size = chunk_size;
+    stream.pending_fill = 0;
+
+    stream.chunks = calloc(chunk_num, sizeof(stream_chunk_t));
+    stream.data = calloc((size_t)chunk_num * 2 * chunk_size, sizeof(int16_t));
+    stream.efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stream.chunks == NULL || stream.data == NULL || stream.efd < 0) {
+        freeStream();
+        return RP_EOOR;
+    }
+
+    if (stream.decimation > 1) {
+        stream.block_size = MIN((uint64_t)chunk_size * stream.decimation, MAX_DECIM_BLOCK);
+        stream.fresh_size = stream.block_size / stream.decimation + 1;
+        stream.block = calloc(stream.block_size, sizeof(int16_t));
+        stream.decim_out = calloc(stream.fresh_size, sizeof(float));
+        stream.fresh = calloc(2 * stream.fresh_size, sizeof(int16_t));
+        stream.pending = calloc(2 * chunk_size, sizeof(int16_t));
+        if (stream.block == NULL || stream.decim_out == NULL || stream.fresh == NULL || stream.pending == NULL
+            || decim_Create(stream.decimation, &stream.decim[RP_CH_1]) != RP_OK
+            || decim_Create(stream.decimation, &stream.decim[RP_CH_2]) != RP_OK) {
+            freeStream();
+            return RP_EOOR;
+        }
+    }
+
+    /* Continuous writing: no trigger, so the write pointer never stops */
+    int ret = acq_SetTriggerSrc(RP_TRIG_SRC_DISABLED);
+    if (ret == RP_OK) {
+        ret = acq_Start();
+    }
+    if (ret != RP_OK) {
+        freeStream();
+        return ret;
+    }
+
+    __atomic_store_n(&stream.running, true, __ATOMIC_SEQ_CST);
+    if (pthread_create(&stream.thread, NULL, streamThreadFun, NULL) != 0) {
+        __atomic_store_n(&stream.running, false, __ATOMIC_SEQ_CST);
+        freeStream();
+        return RP_ETHR;
+    }
+
+    return RP_OK;
+}
+
+int acq_StreamStop()
+{
+    if (stream.efd < 0) {
+        return RP_OK;
+    }
+
+    __atomic_store_n(&stream.running, false, __ATOMIC_SEQ_CST);
+    pthread_join(stream.thread, NULL);
+
+    /* Readers see running cleared once woken up, the queue is freed after the last one left */
+    while (__atomic_load_n(&stream.readers, __ATOMIC_SEQ_CST) != 0) {
+        notify();
+        sleepNs(READER_WAKE_NS);
+    }
+    freeStream();
+
+    return acq_Stop();
+}
+
+static int streamRead(int16_t* buffer1, int16_t* buffer2, uint64_t* sequence, int32_t timeout_ms)
+{
+    if (!__atomic_load_n(&stream.running, __ATOMIC_SEQ_CST)) {
+        return RP_EOOR;
+    }
+
+    uint32_t tail = stream.tail;
+    struct pollfd pfd = { .fd = stream.efd, .events = POLLIN };
+    uint64_t events;
+
+    /* Event counter is only used for wake up, queue indices tell what is available */
+    while (__atomic_load_n(&stream.head, __ATOMIC_ACQUIRE) == tail) {
+        if (!__atomic_load_n(&stream.running, __ATOMIC_ACQUIRE)) {
+            return RP_EOOR;
+        }
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            __atomic_add_fetch(&stream.stats.underruns, 1, __ATOMIC_RELAXED);
+            return RP_ETMO;
+        }
+        if (read(stream.efd, &events, sizeof(events)) < 0) {
+            events = 0;
+        }
+    }
+
+    uint32_t slot = tail % stream.chunk_num;
+    const int16_t* data = &stream.data[(size_t)slot * 2 * stream.chunk_size];
+
+    memcpy(buffer1, data, stream.chunk_size * sizeof(int16_t));
+    memcpy(buffer2, data + stream.chunk_size, stream.chunk_size * sizeof(int16_t));
+    if (sequence != NULL) {
+        *sequence = stream.chunks[slot].sequence;
+    }
+
+    __atomic_store_n(&stream.tail, tail + 1, __ATOMIC_RELEASE);
+    return RP_OK;
+}
+
+int acq_StreamRead(int16_t* buffer1, int16_t* buffer2, uint64_t* sequence, int32_t timeout_ms)
+{
+    __atomic_add_fetch(&stream.readers, 1, __ATOMIC_SEQ_CST);
+    int ret = streamRead(buffer1, buffer2, sequence, timeout_ms);
+    __atomic_sub_fetch(&stream.readers, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+int acq_StreamGetEventFd(int* fd)
+{
+    if (!__atomic_load_n(&stream.running, __ATOMIC_ACQUIRE)) {
+        return RP_EOOR;
+    }
+    *fd = stream.efd;
+    return RP_OK;
+}
+
+int acq_StreamGetStats(rp_acq_stream_stats_t* stats)
+{
+    stats->chunks = __atomic_load_n(&stream.stats.chunks, __ATOMIC_RELAXED);
+    stats->overruns = __atomic_load_n(&stream.stats.overruns, __ATOMIC_RELAXED);
+    stats->lost_samples = __atomic_load_n(&stream.stats.lost_samples, __ATOMIC_RELAXED);
+    stats->underruns = __atomic_load_n(&stream.stats.underruns, __ATOMIC_RELAXED);
+    stats->queued = __atomic_load_n(&stream.head, __ATOMIC_ACQUIRE) - __atomic_load_n(&stream.tail, __ATOMIC_ACQUIRE);
+    return RP_OK;
+}
+
+int acq_StreamResetStats()
+{
+    __atomic_store_n(&stream.stats.chunks, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stream.stats.overruns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stream.stats.lost_samples, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&stream.stats.underruns, 0, __ATOMIC_RELAXED);
+    return RP_OK;
+}
@@ -0,0 +1,29 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library continuous acquisition streaming interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_ACQ_STREAM_H_
+#define SRC_ACQ_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rp.h"
+
+int acq_StreamStart(uint32_t chunk_size, uint32_t chunk_num);
+int acq_StreamStop();
+int acq_StreamRead(int16_t* buffer1, int16_t* buffer2, uint64_t* sequence, int32_t timeout_ms);
+int acq_StreamGetEventFd(int* fd);
+int acq_StreamGetStats(rp_acq_stream_stats_t* stats);
+int acq_StreamResetStats();
+
+#endif /* SRC_ACQ_STREAM_H_ */
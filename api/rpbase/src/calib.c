@@ -27,9 +27,29 @@ static const int  eeprom_calib_off=0x0008;
 // Cached parameter values.
 static rp_calib_params_t calib, failsafa_params;
 
+/* Incremented whenever cached calibration parameters change */
+static volatile uint32_t calib_generation = 0;
+
+static void updateCachedParams(rp_calib_params_t params)
+{
+    calib = params;
+    __sync_add_and_fetch(&calib_generation, 1);
+}
+
 int calib_Init()
 {
-    ECHECK(calib_ReadParams(&calib));
+    rp_backend_t backend;
+    ECHECK(cmn_GetBackend(&backend));
+
+    /* There is no EEPROM behind the simulator, use nominal values */
+    if (backend == RP_BACKEND_SIM) {
+        calib_SetToZero();
+        return RP_OK;
+    }
+
+    rp_calib_params_t params;
+    ECHECK(calib_ReadParams(&params));
+    updateCachedParams(params);
     return RP_OK;
 }
 
@@ -47,6 +67,15 @@ rp_calib_params_t calib_GetParams()
     return calib;
 }
 
+/**
+ * Returns generation of cached parameters, changes whenever they are modified
+ * @return Generation number.
+ */
+uint32_t calib_GetGeneration()
+{
+    return calib_generation;
+}
+
 /**
  * @brief Read calibration parameters from EEPROM device.
  *
@@ -153,6 +182,7 @@ void calib_SetToZero() {
     calib.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
     calib.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20);
     calib.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1);
+    __sync_add_and_fetch(&calib_generation, 1);
 }
 
 uint32_t calib_GetFrontEndScale(rp_channel_t channel, rp_pinState_t gain) {
@@ -174,7 +204,7 @@ int calib_SetFrontEndOffset(rp_channel_t channel, rp_calib_params_t* out_params)
             params.fe_ch1_dc_offs = 0,
             params.fe_ch2_dc_offs = 0)
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    updateCachedParams(params);
 
     CHANNEL_ACTION(channel,
             params.fe_ch1_dc_offs = calib_GetDataMedian(channel),
@@ -202,7 +232,7 @@ int calib_SetFrontEndScaleLV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_lo = cmn_CalibFullScaleFromVoltage(20),
             params.fe_ch2_fs_g_lo = cmn_CalibFullScaleFromVoltage(20))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    updateCachedParams(params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_LOW);
@@ -234,7 +264,7 @@ int calib_SetFrontEndScaleHV(rp_channel_t channel, float referentialVoltage, rp_
             params.fe_ch1_fs_g_hi = cmn_CalibFullScaleFromVoltage(1),
             params.fe_ch2_fs_g_hi = cmn_CalibFullScaleFromVoltage(1))
     /* Acquire uses this calibration parameters - reset them */
-    calib = params;
+    updateCachedParams(params);
 
     /* Calculate real max adc voltage */
     float value = calib_GetDataMedianFloat(channel, RP_HIGH);
@@ -266,7 +296,7 @@ int calib_SetBackEndOffset(rp_channel_t channel) {
             params.be_ch1_dc_offs = 0,
             params.be_ch2_dc_offs = 0)
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    updateCachedParams(params);
 
     /* Generate zero signal */
     ECHECK(rp_GenReset());
@@ -294,7 +324,7 @@ int calib_SetBackEndScale(rp_channel_t channel) {
             params.be_ch1_fs = cmn_CalibFullScaleFromVoltage(1),
             params.be_ch2_fs = cmn_CalibFullScaleFromVoltage(1))
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    updateCachedParams(params);
 
     /* Generate constant signal signal */
     ECHECK(rp_GenReset());
@@ -351,7 +381,7 @@ int calib_CalibrateBackEnd(rp_channel_t channel, rp_calib_params_t* out_params)
             params.be_ch2_dc_offs = 0)
 
     /* Generate uses this calibration parameters - reset them */
-    calib = params;
+    updateCachedParams(params);
 
     float value1, value2;
     getGenAmp(channel, CONSTANT_SIGNAL_AMPLITUDE, &value1, &value2);
@@ -473,7 +503,7 @@ int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* mi
 int calib_setCachedParams() {
 	fprintf(stderr, "write FAILSAFE PARAMS\n");
     ECHECK(calib_WriteParams(failsafa_params));
-    calib = failsafa_params;
+    updateCachedParams(failsafa_params);
     
     return 0;
 }
@@ -25,6 +25,7 @@ int calib_Init();
 int calib_Release();
 
 rp_calib_params_t calib_GetParams();
+uint32_t calib_GetGeneration();
 int calib_WriteParams(rp_calib_params_t calib_params);
 void calib_SetToZero();
 
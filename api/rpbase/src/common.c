@@ -16,14 +16,60 @@
 #include <unistd.h>
 #include <sys/mman.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <pthread.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 #include "common.h"
+#include "sim_fpga.h"
 
 static int fd = -1;
+static rp_backend_t backend = RP_BACKEND_DEVMEM;
+static bool backend_set = false;
+static bool sim_active = false;
+
+int cmn_SetBackend(rp_backend_t value)
+{
+    if (value != RP_BACKEND_DEVMEM && value != RP_BACKEND_SIM) {
+        return RP_EOOR;
+    }
+    if (fd != -1 || sim_active) {
+        return RP_EBSY;
+    }
+    backend = value;
+    backend_set = true;
+    return RP_OK;
+}
+
+int cmn_GetBackend(rp_backend_t* value)
+{
+    *value = backend;
+    return RP_OK;
+}
 
 int cmn_Init()
 {
+    /* RP_BACKEND=sim selects the simulator unless the backend was chosen explicitly */
+    if (!backend_set) {
+        const char* env = getenv("RP_BACKEND");
+        backend = (env != NULL && strcmp(env, "sim") == 0) ? RP_BACKEND_SIM : RP_BACKEND_DEVMEM;
+    }
+
+    if (backend == RP_BACKEND_SIM) {
+        if (!sim_active) {
+            int ret = sim_Init();
+            if (ret != RP_OK) {
+                return ret;
+            }
+            sim_active = true;
+        }
+        return RP_OK;
+    }
+
     if (fd == -1) {
         if((fd = open("/dev/mem", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
@@ -34,6 +80,11 @@ int cmn_Init()
 
 int cmn_Release()
 {
+    if (sim_active) {
+        sim_active = false;
+        return sim_Release();
+    }
+
     if (fd != -1) {
         if(close(fd) < 0) {
             return RP_ECMD;
@@ -44,15 +95,26 @@ int cmn_Release()
     return RP_OK;
 }
 
+/* Lets the simulated FPGA act on a command written to its registers, no-op on hardware */
+int cmn_Sync()
+{
+    return sim_active ? sim_Sync() : RP_OK;
+}
+
 int cmn_Map(size_t size, size_t offset, void** mapped)
 {
+	if(sim_active) {
+		return sim_Map(size, offset, mapped);
+	}
+
 	if(fd == -1) {
 		return RP_EMMD;
 	}
 	
     *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
 
-    if(mapped == (void *) -1) {
+    if(*mapped == MAP_FAILED) {
+        *mapped = NULL;
         return RP_EMMD;
     }
 
@@ -61,6 +123,13 @@ int cmn_Map(size_t size, size_t offset, void** mapped)
 
 int cmn_Unmap(size_t size, void** mapped)
 {
+	if(sim_active) {
+		if((mapped == NULL) || (*mapped == NULL)) {
+			return RP_EUMD;
+		}
+		return sim_Unmap(size, mapped);
+	}
+
 	if(fd == -1) {
 		return RP_EUMD;
 	}
@@ -80,11 +149,173 @@ int cmn_Unmap(size_t size, void** mapped)
     return RP_OK;
 }
 
+/*
+ * Shadow registers
+ *
+ * Write-mostly control registers (which the FPGA never changes by itself) can be
+ * registered with cmn_ShadowRegister(). Reads of such registers are served from the
+ * shadow copy, which saves the bus read of the read-modify-writes. Every write marks
+ * its register dirty and dirty registers are always written, also when the value is
+ * the one last written, as another process (or spec_fpga through its own mapping) may
+ * have changed the register since. Between cmn_RegBatchBegin() and cmn_RegBatchCommit()
+ * writes are held back and each dirty register is written once at commit. Registers
+ * with side effects on write (arm, reset, trigger strobes) or updated by the FPGA must
+ * not be registered.
+ *
+ * Shadow updates are serialized by shadow_mutex. The batch depth is per thread: a batch
+ * only holds back the writes of the thread that began it, though its commit writes out
+ * every dirty register.
+ */
+
+#define CMN_SHADOW_MAX_RANGES 16
+
+typedef struct {
+    volatile uint32_t* hw;
+    uint32_t count;
+    uint32_t* shadow;       // value as set by the library
+    uint32_t* dirty;        // bit per register written since the last flush
+} shadow_range_t;
+
+static shadow_range_t shadow_ranges[CMN_SHADOW_MAX_RANGES];
+static pthread_mutex_t shadow_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread int batch_depth = 0;
+
+static shadow_range_t* findShadow(volatile uint32_t* field, uint32_t* index)
+{
+    for (int i = 0; i < CMN_SHADOW_MAX_RANGES; ++i) {
+        shadow_range_t* r = &shadow_ranges[i];
+        if (r->hw != NULL && field >= r->hw && field < r->hw + r->count) {
+            *index = field - r->hw;
+            return r;
+        }
+    }
+    return NULL;
+}
+
+#define SHADOW_DIRTY_WORDS(count) (((count) + 31) / 32)
+
+static void flushShadow(shadow_range_t* r)
+{
+    for (uint32_t w = 0; w < SHADOW_DIRTY_WORDS(r->count); ++w) {
+        while (r->dirty[w] != 0) {
+            uint32_t bit = __builtin_ctz(r->dirty[w]);
+            r->hw[w * 32 + bit] = r->shadow[w * 32 + bit];
+            r->dirty[w] &= ~(1u << bit);
+        }
+    }
+}
+
+int cmn_ShadowRegister(volatile uint32_t* hw, uint32_t count, uint32_t** shadow)
+{
+    pthread_mutex_lock(&shadow_mutex);
+    for (int i = 0; i < CMN_SHADOW_MAX_RANGES; ++i) {
+        shadow_range_t* r = &shadow_ranges[i];
+        if (r->hw == NULL) {
+            r->shadow = calloc(count + SHADOW_DIRTY_WORDS(count), sizeof(uint32_t));
+            if (r->shadow == NULL) {
+                pthread_mutex_unlock(&shadow_mutex);
+                return RP_EOOR;
+            }
+            r->dirty = r->shadow + count;
+            for (uint32_t j = 0; j < count; ++j) {
+                r->shadow[j] = hw[j];
+            }
+            r->count = count;
+            r->hw = hw;
+            if (shadow != NULL) {
+                *shadow = r->shadow;
+            }
+            pthread_mutex_unlock(&shadow_mutex);
+            return RP_OK;
+        }
+    }
+    pthread_mutex_unlock(&shadow_mutex);
+    return RP_EOOR;
+}
+
+int cmn_ShadowUnregister(volatile uint32_t* hw)
+{
+    uint32_t index;
+    pthread_mutex_lock(&shadow_mutex);
+    shadow_range_t* r = findShadow(hw, &index);
+    if (r == NULL) {
+        pthread_mutex_unlock(&shadow_mutex);
+        return RP_EIPV;
+    }
+    flushShadow(r);
+    free(r->shadow);
+    memset(r, 0, sizeof(shadow_range_t));
+    pthread_mutex_unlock(&shadow_mutex);
+    return RP_OK;
+}
+
+int cmn_ShadowReload()
+{
+    pthread_mutex_lock(&shadow_mutex);
+    for (int i = 0; i < CMN_SHADOW_MAX_RANGES; ++i) {
+        shadow_range_t* r = &shadow_ranges[i];
+        if (r->hw != NULL) {
+            flushShadow(r);
+            for (uint32_t j = 0; j < r->count; ++j) {
+                r->shadow[j] = r->hw[j];
+            }
+        }
+    }
+    pthread_mutex_unlock(&shadow_mutex);
+    return RP_OK;
+}
+
+int cmn_RegBatchBegin()
+{
+    batch_depth++;
+    return RP_OK;
+}
+
+int cmn_RegBatchCommit()
+{
+    if (batch_depth == 0) {
+        return RP_EIPV;
+    }
+    if (--batch_depth == 0) {
+        pthread_mutex_lock(&shadow_mutex);
+        for (int i = 0; i < CMN_SHADOW_MAX_RANGES; ++i) {
+            if (shadow_ranges[i].hw != NULL) {
+                flushShadow(&shadow_ranges[i]);
+            }
+        }
+        pthread_mutex_unlock(&shadow_mutex);
+    }
+    return RP_OK;
+}
+
+/* Read-modify-write of a shadowed register: new = (old & ~clear) | set, under shadow_mutex.
+ * The register is written at once, or marked dirty while a batch is open. Returns false when
+ * 'field' is not shadowed. */
+static bool updateShadow(volatile uint32_t* field, uint32_t clear, uint32_t set)
+{
+    uint32_t index;
+    pthread_mutex_lock(&shadow_mutex);
+    shadow_range_t* r = findShadow(field, &index);
+    if (r != NULL) {
+        r->shadow[index] = (r->shadow[index] & ~clear) | set;
+        if (batch_depth == 0) {
+            r->hw[index] = r->shadow[index];
+            r->dirty[index / 32] &= ~(1u << (index % 32));
+        } else {
+            r->dirty[index / 32] |= 1u << (index % 32);
+        }
+    }
+    pthread_mutex_unlock(&shadow_mutex);
+    return r != NULL;
+}
+
 int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask, uint32_t bitsToSetShift)
 {
     VALIDATE_BITS(value, mask);
-    uint32_t currentValue;
-    cmn_GetValue(field, &currentValue, 0xffffffff);
+    if (updateShadow(field, mask << bitsToSetShift, value << bitsToSetShift)) {
+        return RP_OK;
+    }
+    uint32_t currentValue = *field;
     currentValue &=  ~(mask << bitsToSetShift); // Clear all bits at specified location
     currentValue +=  (value << bitsToSetShift); // Set value at specified location
     SET_VALUE(*field, currentValue);
@@ -98,7 +329,12 @@ int cmn_SetValue(volatile uint32_t* field, uint32_t value, uint32_t mask)
 
 int cmn_GetShiftedValue(volatile uint32_t* field, uint32_t* value, uint32_t mask, uint32_t bitsToSetShift)
 {
-    *value = (*field >> bitsToSetShift) & mask;
+    uint32_t index;
+    pthread_mutex_lock(&shadow_mutex);
+    shadow_range_t* r = findShadow(field, &index);
+    uint32_t currentValue = r != NULL ? r->shadow[index] : *field;
+    pthread_mutex_unlock(&shadow_mutex);
+    *value = (currentValue >> bitsToSetShift) & mask;
     return RP_OK;
 }
 
@@ -110,6 +346,9 @@ int cmn_GetValue(volatile uint32_t* field, uint32_t* value, uint32_t mask)
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
+    if (updateShadow(field, 0, bits)) {
+        return RP_OK;
+    }
     SET_BITS(*field, bits);
     return RP_OK;
 }
@@ -117,6 +356,9 @@ int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
+    if (updateShadow(field, bits, 0)) {
+        return RP_OK;
+    }
     UNSET_BITS(*field, bits);
     return RP_OK;
 }
@@ -264,6 +506,131 @@ float cmn_CnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t
     return cmn_CnvCalibCntToV(field_len, calib_cnts, adc_max_v, cmn_CalibFullScaleToVoltage(calibScale), user_dc_off);
 }
 
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Precomputes linear coefficients for bulk counts to voltage conversion
+ *
+ * cmn_CnvCalibCntToV() is linear in calibrated counts, so for a given gain and calibration
+ * state it can be folded into voltage = calib_cnts * scale + offset. Coefficients are computed
+ * in double precision once, so that the per-sample work in cmn_CnvCntToVBuf() is a single
+ * float multiply-add.
+ *
+ * @param[in] field_len Number of field (ADC/DAC/Buffer) bits
+ * @param[in] adc_max_v Maximal ADC/DAC voltage, specified in [V]
+ * @param[in] calibScale Calibration scale factor, specified in [full scale] - EPROM calibration parameter storage format
+ * @param[in] user_dc_off User specified DC offset, specified in [V]
+ * @param[out] scale Voltage of one calibrated count [V]
+ * @param[out] offset Voltage added to every sample [V]
+ */
+
+void cmn_CnvCntToVCoef(uint32_t field_len, float adc_max_v, uint32_t calibScale, float user_dc_off, float* scale, float* offset)
+{
+    double calib = (double)cmn_CalibFullScaleToVoltage(calibScale) / ((double)FULL_SCALE_NORM/(double)adc_max_v);
+
+    *scale = (float)((double)adc_max_v / (double)(1 << (field_len - 1)) * calib);
+    *offset = (float)((double)user_dc_off * calib);
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Converts a contiguous block of ADC/DAC/Buffer counts to voltage [V]
+ *
+ * Bulk equivalent of cmn_CnvCntToV(). Sign extension, calibrated DC offset and limits are the
+ * same as in cmn_CalibCnts(), followed by the linear mapping precomputed by cmn_CnvCntToVCoef().
+ * Results differ from cmn_CnvCntToV() only by float rounding (well below 1 LSB).
+ * The loop has no branches or divisions, so it vectorizes; on NEON capable targets
+ * four samples are converted per iteration explicitly.
+ *
+ * @param[in] field_len Number of field (ADC/DAC/Buffer) bits
+ * @param[in] cnts Captured Signal Values, expressed in ADC/DAC counts
+ * @param[in] size Number of samples to convert
+ * @param[in] calib_dc_off Calibrated DC offset, specified in ADC/DAC counts
+ * @param[in] scale Scale, as returned by cmn_CnvCntToVCoef()
+ * @param[in] offset Offset, as returned by cmn_CnvCntToVCoef()
+ * @param[out] buffer Signal Values, expressed in user units [V]
+ */
+
+void cmn_CnvCntToVBuf(uint32_t field_len, const uint32_t* cnts, uint32_t size, int calib_dc_off, float scale, float offset, float* buffer)
+{
+    const int shift = 32 - field_len;
+    const int32_t lo = -1 * (1 << (field_len - 1));
+    const int32_t hi = (1 << (field_len - 1));
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const int32x4_t v_dc = vdupq_n_s32(calib_dc_off);
+    const int32x4_t v_lo = vdupq_n_s32(lo);
+    const int32x4_t v_hi = vdupq_n_s32(hi);
+    const int32x4_t v_shift = vdupq_n_s32(shift);
+    const int32x4_t v_nshift = vdupq_n_s32(-shift);
+    const float32x4_t v_scale = vdupq_n_f32(scale);
+    const float32x4_t v_offset = vdupq_n_f32(offset);
+
+    for (; i + 4 <= size; i += 4) {
+        int32x4_t m = vreinterpretq_s32_u32(vld1q_u32(&cnts[i]));
+        m = vshlq_s32(vshlq_s32(m, v_shift), v_nshift);
+        m = vminq_s32(vmaxq_s32(vsubq_s32(m, v_dc), v_lo), v_hi);
+        vst1q_f32(&buffer[i], vmlaq_f32(v_offset, vcvtq_f32_s32(m), v_scale));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        /* sign extend field, adopt with calibrated DC offset and check limits */
+        int32_t m = ((int32_t)(cnts[i] << shift) >> shift) - calib_dc_off;
+        m = MIN(MAX(m, lo), hi);
+        buffer[i] = (float)m * scale + offset;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Adds a block of ADC/DAC/Buffer counts to per sample sum and sum of squares accumulators
+ *
+ * Counts are calibrated as in cmn_CalibCnts(). A square of a calibrated count is at most
+ * 2^(2 * (field_len - 1)), so for 14 bit fields the 32 bit square accumulators can take
+ * CMN_ACC_SQ_MAX_FRAMES frames before the caller has to flush them into wider ones.
+ * On NEON capable targets four samples are accumulated per iteration explicitly.
+ *
+ * @param[in] field_len Number of field (ADC/DAC/Buffer) bits
+ * @param[in] cnts Captured Signal Values, expressed in ADC/DAC counts
+ * @param[in] size Number of samples to accumulate
+ * @param[in] calib_dc_off Calibrated DC offset, specified in ADC/DAC counts
+ * @param[in,out] sum Sum of calibrated counts, one per sample
+ * @param[in,out] sum_sq Sum of squared calibrated counts, one per sample
+ */
+
+void cmn_AccumulateCnts(uint32_t field_len, const uint32_t* cnts, uint32_t size, int calib_dc_off, int32_t* sum, uint32_t* sum_sq)
+{
+    const int shift = 32 - field_len;
+    const int32_t lo = -1 * (1 << (field_len - 1));
+    const int32_t hi = (1 << (field_len - 1));
+    uint32_t i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const int32x4_t v_dc = vdupq_n_s32(calib_dc_off);
+    const int32x4_t v_lo = vdupq_n_s32(lo);
+    const int32x4_t v_hi = vdupq_n_s32(hi);
+    const int32x4_t v_shift = vdupq_n_s32(shift);
+    const int32x4_t v_nshift = vdupq_n_s32(-shift);
+
+    for (; i + 4 <= size; i += 4) {
+        int32x4_t m = vreinterpretq_s32_u32(vld1q_u32(&cnts[i]));
+        m = vshlq_s32(vshlq_s32(m, v_shift), v_nshift);
+        m = vminq_s32(vmaxq_s32(vsubq_s32(m, v_dc), v_lo), v_hi);
+        vst1q_s32(&sum[i], vaddq_s32(vld1q_s32(&sum[i]), m));
+        uint32x4_t m_u = vreinterpretq_u32_s32(m);
+        vst1q_u32(&sum_sq[i], vmlaq_u32(vld1q_u32(&sum_sq[i]), m_u, m_u));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        int32_t m = ((int32_t)(cnts[i] << shift) >> shift) - calib_dc_off;
+        m = MIN(MAX(m, lo), hi);
+        sum[i] += m;
+        sum_sq[i] += (uint32_t)(m * m);
+    }
+}
+
 /**
  * @brief Converts voltage in [V] to ADC/DAC/Buffer counts
  *
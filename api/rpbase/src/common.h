@@ -52,16 +52,29 @@ else { \
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
 
+/* Frames of 14 bit squared counts that fit into 32 bit accumulators, see cmn_AccumulateCnts() */
+#define CMN_ACC_SQ_MAX_FRAMES 63
+
 #define FLOAT_EPS 0.00001f
 
 #define FULL_SCALE_NORM     20.0    // V
 
+int cmn_SetBackend(rp_backend_t value);
+int cmn_GetBackend(rp_backend_t* value);
+
 int cmn_Init();
 int cmn_Release();
+int cmn_Sync();
 
 int cmn_Map(size_t size, size_t offset, void** mapped);
 int cmn_Unmap(size_t size, void** mapped);
 
+int cmn_ShadowRegister(volatile uint32_t* hw, uint32_t count, uint32_t** shadow);
+int cmn_ShadowUnregister(volatile uint32_t* hw);
+int cmn_ShadowReload();
+int cmn_RegBatchBegin();
+int cmn_RegBatchCommit();
+
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_SetValue(volatile uint32_t* field, uint32_t value, uint32_t mask);
@@ -80,6 +93,9 @@ uint32_t cmn_CalibFullScaleFromVoltage(float voltageScale);
 int32_t cmn_CalibCnts(uint32_t field_len, uint32_t cnts, int calib_dc_off);
 float cmn_CnvCalibCntToV(uint32_t field_len, int32_t calib_cnts, float adc_max_v, float calibScale, float user_dc_off);
 float cmn_CnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off);
+void cmn_CnvCntToVCoef(uint32_t field_len, float adc_max_v, uint32_t calibScale, float user_dc_off, float* scale, float* offset);
+void cmn_CnvCntToVBuf(uint32_t field_len, const uint32_t* cnts, uint32_t size, int calib_dc_off, float scale, float offset, float* buffer);
+void cmn_AccumulateCnts(uint32_t field_len, const uint32_t* cnts, uint32_t size, int calib_dc_off, int32_t* sum, uint32_t* sum_sq);
 uint32_t cmn_CnvVToCnt(uint32_t field_len, float voltage, float adc_max_v, bool calibFS_LO, uint32_t calib_scale, int calib_dc_off, float user_dc_off);
 
 #endif /* COMMON_H_ */
@@ -0,0 +1,378 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library software decimation stage implementation
+ *
+ * Integer ratio R is split into a CIC decimator by R / P followed by a polyphase FIR
+ * decimator by P, P being the smallest factor of R that is at least 4. P is limited to 32,
+ * ratios without such a factor (e.g. primes above 32) would need a FIR as long as 32 * R. CIC integrators run on every
+ * input sample in wrapping integer arithmetic, 32 bit wide when the bit growth allows it.
+ * The FIR only computes every P-th output; its taps are designed at creation time to
+ * flatten the CIC droop over the passband and to suppress everything that would alias
+ * into it, so the whole response is known before any data is processed.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "common.h"
+#include "decimator.h"
+
+/* @brief Number of CIC integrator and comb stages. */
+#define CIC_ORDER           5
+
+/* @brief Smallest FIR decimation. CIC images of the passband are then at most 0.1 of the
+ * CIC output rate from its nulls, where 5 stages attenuate them by more than 90 dB. */
+#define FIR_MIN_RATIO       4
+
+/* @brief FIR length per polyphase branch, sets the transition band steepness. */
+#define FIR_TAPS_PER_PHASE  32
+
+/* @brief Largest FIR decimation, bounds the FIR to 1024 taps. */
+#define FIR_MAX_RATIO       32
+
+/* @brief Number of frequency points the FIR design integrates over. */
+#define DESIGN_GRID         256
+
+/* @brief CIC output samples buffered before they are passed to the FIR. */
+#define SCRATCH_SIZE        256
+
+struct rp_decimator_s {
+    uint32_t ratio;
+    uint32_t cic_ratio;
+    uint32_t fir_ratio;
+
+    /* CIC state, only low 32 bits are used when not wide */
+    bool cic_wide;
+    float cic_gain;
+    uint64_t integ[CIC_ORDER];
+    uint64_t comb[CIC_ORDER];
+    uint32_t cic_phase;
+
+    /* FIR state, history keeps every sample twice so the window is always contiguous */
+    uint32_t taps_num;
+    float* taps;
+    float* hist;
+    uint32_t hist_pos;
+    uint32_t fir_phase;
+
+    float scratch[SCRATCH_SIZE];
+};
+
+/* Smallest divisor of the ratio that is at least FIR_MIN_RATIO, or the ratio itself */
+static uint32_t firRatio(uint32_t ratio)
+{
+    for (uint32_t f = FIR_MIN_RATIO; f < ratio; ++f) {
+        if (ratio % f == 0) {
+            return f;
+        }
+    }
+    return ratio;
+}
+
+/* CIC amplitude response at 'freq' relative to the CIC output rate */
+static double cicResponse(uint32_t cic_ratio, double freq)
+{
+    double den = cic_ratio * sin(M_PI * freq / cic_ratio);
+    if (cic_ratio == 1 || fabs(den) < 1e-12) {
+        return 1.0;
+    }
+    return fabs(pow(sin(M_PI * freq) / den, CIC_ORDER));
+}
+
+/* FIR amplitude response at 'freq' relative to the FIR input rate */
+static double firResponse(const rp_decimator_t* dec, double freq)
+{
+    double re = 0, im = 0;
+    for (uint32_t n = 0; n < dec->taps_num; ++n) {
+        re += dec->taps[n] * cos(2 * M_PI * freq * n);
+        im -= dec->taps[n] * sin(2 * M_PI * freq * n);
+    }
+    return sqrt(re * re + im * im);
+}
+
+/*
+ * Frequency sampling design: desired response is the inverse CIC droop up to the passband edge,
+ * held up to the middle of the transition band and zero above. Its inverse transform is
+ * windowed with Blackman, which places the transition band around the cut off.
+ * Taps are normalized to unity DC gain.
+ */
+static void designTaps(rp_decimator_t* dec)
+{
+    const uint32_t len = dec->taps_num;
+    const double f_pass = DECIM_PASSBAND / dec->fir_ratio;
+    const double f_cut = 0.5 / dec->fir_ratio;
+    const double df = f_cut / DESIGN_GRID;
+    const double center = (len - 1) / 2.0;
+    double desired[DESIGN_GRID + 1];
+
+    for (int k = 0; k <= DESIGN_GRID; ++k) {
+        double d = 1.0 / cicResponse(dec->cic_ratio, MIN(k * df, f_pass));
+        /* trapezoidal integration weights */
+        desired[k] = (k == 0 || k == DESIGN_GRID) ? d / 2 : d;
+    }
+
+    double sum = 0;
+    for (uint32_t n = 0; n < len; ++n) {
+        double t = n - center;
+        double h = 0;
+        for (int k = 0; k <= DESIGN_GRID; ++k) {
+            h += desired[k] * cos(2 * M_PI * k * df * t);
+        }
+        h *= 2 * df;
+        h *= 0.42 - 0.5 * cos(2 * M_PI * n / (len - 1)) + 0.08 * cos(4 * M_PI * n / (len - 1));
+        dec->taps[n] = h;
+        sum += h;
+    }
+    for (uint32_t n = 0; n < len; ++n) {
+        dec->taps[n] /= sum;
+    }
+}
+
+static uint32_t cicBlock32(rp_decimator_t* dec, const int16_t* in, uint32_t size, float* out)
+{
+    uint32_t acc[CIC_ORDER], comb[CIC_ORDER];
+    uint32_t phase = dec->cic_phase;
+    uint32_t produced = 0;
+
+    for (int s = 0; s < CIC_ORDER; ++s) {
+        acc[s] = dec->integ[s];
+        comb[s] = dec->comb[s];
+    }
+
+    for (uint32_t i = 0; i < size; ++i) {
+        acc[0] += (uint32_t)(int32_t)in[i];
+        for (int s = 1; s < CIC_ORDER; ++s) {
+            acc[s] += acc[s - 1];
+        }
+        if (++phase == dec->cic_ratio) {
+            uint32_t y = acc[CIC_ORDER - 1];
+            for (int s = 0; s < CIC_ORDER; ++s) {
+                uint32_t prev = comb[s];
+                comb[s] = y;
+                y -= prev;
+            }
+            out[produced++] = (float)(int32_t)y * dec->cic_gain;
+            phase = 0;
+        }
+    }
+
+    for (int s = 0; s < CIC_ORDER; ++s) {
+        dec->integ[s] = acc[s];
+        dec->comb[s] = comb[s];
+    }
+    dec->cic_phase = phase;
+    return produced;
+}
+
+static uint32_t cicBlock64(rp_decimator_t* dec, const int16_t* in, uint32_t size, float* out)
+{
+    uint64_t acc[CIC_ORDER], comb[CIC_ORDER];
+    uint32_t phase = dec->cic_phase;
+    uint32_t produced = 0;
+
+    memcpy(acc, dec->integ, sizeof(acc));
+    memcpy(comb, dec->comb, sizeof(comb));
+
+    for (uint32_t i = 0; i < size; ++i) {
+        acc[0] += (uint64_t)(int64_t)in[i];
+        for (int s = 1; s < CIC_ORDER; ++s) {
+            acc[s] += acc[s - 1];
+        }
+        if (++phase == dec->cic_ratio) {
+            uint64_t y = acc[CIC_ORDER - 1];
+            for (int s = 0; s < CIC_ORDER; ++s) {
+                uint64_t prev = comb[s];
+                comb[s] = y;
+                y -= prev;
+            }
+            out[produced++] = (float)(int64_t)y * dec->cic_gain;
+            phase = 0;
+        }
+    }
+
+    memcpy(dec->integ, acc, sizeof(acc));
+    memcpy(dec->comb, comb, sizeof(comb));
+    dec->cic_phase = phase;
+    return produced;
+}
+
+/* Four partial sums let the loop pipeline without reassociating float additions */
+static float dotProduct(const float* a, const float* b, uint32_t size)
+{
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < size; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static uint32_t firBlock(rp_decimator_t* dec, const float* in, uint32_t size, float* out)
+{
+    const uint32_t len = dec->taps_num;
+    uint32_t pos = dec->hist_pos;
+    uint32_t phase = dec->fir_phase;
+    uint32_t produced = 0;
+
+    for (uint32_t i = 0; i < size; ++i) {
+        dec->hist[pos] = dec->hist[pos + len] = in[i];
+        if (++pos == len) {
+            pos = 0;
+        }
+        if (++phase == dec->fir_ratio) {
+            /* taps are symmetric, oldest first order of the window does not matter */
+            out[produced++] = dotProduct(dec->taps, &dec->hist[pos], len);
+            phase = 0;
+        }
+    }
+
+    dec->hist_pos = pos;
+    dec->fir_phase = phase;
+    return produced;
+}
+
+int decim_CheckRatio(uint32_t ratio)
+{
+    if (ratio < 2 || ratio > DECIM_MAX_RATIO || firRatio(ratio) > FIR_MAX_RATIO) {
+        return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+int decim_Create(uint32_t ratio, rp_decimator_t** dec)
+{
+    if (decim_CheckRatio(ratio) != RP_OK) {
+        return RP_EOOR;
+    }
+
+    rp_decimator_t* d = calloc(1, sizeof(rp_decimator_t));
+    if (d == NULL) {
+        return RP_EOOR;
+    }
+
+    d->ratio = ratio;
+    d->fir_ratio = firRatio(ratio);
+    d->cic_ratio = ratio / d->fir_ratio;
+    /* 16 bit input grows by CIC_ORDER * log2(cic_ratio) bits */
+    d->cic_wide = pow(d->cic_ratio, CIC_ORDER) > (double)(1 << 16);
+    d->cic_gain = 1.0 / pow(d->cic_ratio, CIC_ORDER);
+
+    d->taps_num = FIR_TAPS_PER_PHASE * d->fir_ratio;
+    d->taps = calloc(d->taps_num, sizeof(float));
+    d->hist = calloc(2 * d->taps_num, sizeof(float));
+    if (d->taps == NULL || d->hist == NULL) {
+        decim_Destroy(d);
+        return RP_EOOR;
+    }
+    designTaps(d);
+
+    *dec = d;
+    return RP_OK;
+}
+
+int decim_Destroy(rp_decimator_t* dec)
+{
+    if (dec == NULL) {
+        return RP_EOOR;
+    }
+    free(dec->taps);
+    free(dec->hist);
+    free(dec);
+    return RP_OK;
+}
+
+int decim_Reset(rp_decimator_t* dec)
+{
+    if (dec == NULL) {
+        return RP_EOOR;
+    }
+    memset(dec->integ, 0, sizeof(dec->integ));
+    memset(dec->comb, 0, sizeof(dec->comb));
+    memset(dec->hist, 0, 2 * dec->taps_num * sizeof(float));
+    dec->cic_phase = 0;
+    dec->hist_pos = 0;
+    dec->fir_phase = 0;
+    return RP_OK;
+}
+
+int decim_Process(rp_decimator_t* dec, const int16_t* in, uint32_t in_size, float* out, uint32_t* out_size)
+{
+    if (dec == NULL) {
+        return RP_EOOR;
+    }
+
+    uint32_t produced = 0;
+    while (in_size > 0) {
+        /* never more than SCRATCH_SIZE CIC outputs per block */
+        uint32_t size = MIN(in_size, SCRATCH_SIZE * dec->cic_ratio - dec->cic_phase);
+        uint32_t cic_out;
+
+        if (dec->cic_ratio == 1) {
+            for (uint32_t i = 0; i < size; ++i) {
+                dec->scratch[i] = in[i];
+            }
+            cic_out = size;
+        } else if (dec->cic_wide) {
+            cic_out = cicBlock64(dec, in, size, dec->scratch);
+        } else {
+            cic_out = cicBlock32(dec, in, size, dec->scratch);
+        }
+        produced += firBlock(dec, dec->scratch, cic_out, &out[produced]);
+
+        in += size;
+        in_size -= size;
+    }
+
+    *out_size = produced;
+    return RP_OK;
+}
+
+int decim_GetResponse(const rp_decimator_t* dec, float freq, float* gain)
+{
+    if (dec == NULL) {
+        return RP_EOOR;
+    }
+    /* FIR input rate is fir_ratio times the output rate */
+    double f = (double)freq / dec->fir_ratio;
+    *gain = cicResponse(dec->cic_ratio, f) * firResponse(dec, f);
+    return RP_OK;
+}
+
+int decim_GetDelay(const rp_decimator_t* dec, float* delay)
+{
+    if (dec == NULL) {
+        return RP_EOOR;
+    }
+    /* both stages are linear phase; delays in input samples */
+    double cic_delay = CIC_ORDER * (dec->cic_ratio - 1) / 2.0;
+    double fir_delay = (dec->taps_num - 1) / 2.0 * dec->cic_ratio;
+    *delay = (cic_delay + fir_delay) / dec->ratio;
+    return RP_OK;
+}
+
+int decim_GetSettle(const rp_decimator_t* dec, uint32_t* outputs)
+{
+    if (dec == NULL) {
+        return RP_EOOR;
+    }
+    /* outputs after a reset until the CIC combs and the whole FIR history hold input data */
+    *outputs = (dec->taps_num + CIC_ORDER + dec->fir_ratio - 1) / dec->fir_ratio;
+    return RP_OK;
+}
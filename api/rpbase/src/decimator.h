@@ -0,0 +1,36 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library software decimation stage interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_DECIMATOR_H_
+#define SRC_DECIMATOR_H_
+
+#include <stdint.h>
+#include "rp.h"
+
+/* @brief Largest software decimation ratio. */
+#define DECIM_MAX_RATIO      1024
+
+/* @brief Usable bandwidth, relative to the output sample rate. */
+#define DECIM_PASSBAND       0.4f
+
+int decim_CheckRatio(uint32_t ratio);
+int decim_Create(uint32_t ratio, rp_decimator_t** dec);
+int decim_Destroy(rp_decimator_t* dec);
+int decim_Reset(rp_decimator_t* dec);
+int decim_Process(rp_decimator_t* dec, const int16_t* in, uint32_t in_size, float* out, uint32_t* out_size);
+int decim_GetResponse(const rp_decimator_t* dec, float freq, float* gain);
+int decim_GetDelay(const rp_decimator_t* dec, float* delay);
+int decim_GetSettle(const rp_decimator_t* dec, uint32_t* outputs);
+
+#endif /* SRC_DECIMATOR_H_ */
@@ -35,7 +35,7 @@ uint32_t      chA_arb_size = BUFFER_LENGTH, chB_arb_size = BUFFER_LENGTH;
 float chA_arbitraryData[BUFFER_LENGTH];
 float chB_arbitraryData[BUFFER_LENGTH];
 
-int gen_SetDefaultValues() {
+static int setDefaultValues() {
     ECHECK(gen_Disable(RP_CH_1));
     ECHECK(gen_Disable(RP_CH_2));
     ECHECK(gen_setFrequency(RP_CH_1, 1000));
@@ -65,6 +65,14 @@ int gen_SetDefaultValues() {
     return RP_OK;
 }
 
+int gen_SetDefaultValues() {
+    // Coalesce the channel property writes, see cmn_RegBatchBegin()
+    ECHECK(cmn_RegBatchBegin());
+    int ret = setDefaultValues();
+    ECHECK(cmn_RegBatchCommit());
+    return ret;
+}
+
 int gen_Disable(rp_channel_t channel) {
     return generate_setOutputDisable(channel, true);
 }
@@ -21,61 +21,31 @@
 #include "generate.h"
 #include "calib.h"
 
-// Base Health address
-static size_t GENERATE_BASE_ADDR = 0x40200000;
-static size_t GENERATE_BASE_SIZE = 0x30000;
-
-typedef struct ch_properties {
-	unsigned int amplitudeScale		:14;
-	unsigned int 					:2;
-	unsigned int amplitudeOffset    :14;
-	unsigned int 					:2;
-	uint32_t counterWrap;
-	uint32_t startOffset;
-	uint32_t counterStep;
-    unsigned int                    :2;
-	uint32_t buffReadPointer        :14;
-    unsigned int                    :16;
-    uint32_t cyclesInOneBurst;
-    uint32_t burstRepetitions;
-    uint32_t delayBetweenBurstRepetitions;
-} ch_properties_t;
-
-typedef struct generate_control_s {
-	unsigned int AtriggerSelector   :4;
-	unsigned int ASM_WrapPointer    :1;
-	unsigned int                    :1;
-	unsigned int ASM_reset 		   	:1;
-	unsigned int AsetOutputTo0 	   	:1;
-    unsigned int AgatedBursts       :1;
-	unsigned int 				   	:7;
-
-	unsigned int BtriggerSelector   :4;
-	unsigned int BSM_WrapPointer    :1;
-	unsigned int                    :1;
-	unsigned int BSM_reset 		   	:1;
-	unsigned int BsetOutputTo0 	   	:1;
-    unsigned int BgatedBursts       :1;
-    unsigned int 				   	:7;
-
-	ch_properties_t properties_chA;
-	ch_properties_t properties_chB;
-} generate_control_t;
-
 static volatile generate_control_t *generate = NULL;
 static volatile int32_t *data_chA = NULL;
 static volatile int32_t *data_chB = NULL;
 
 
+
 int generate_Init() {
 //	ECHECK(cmn_Init());
 	ECHECK(cmn_Map(GENERATE_BASE_SIZE, GENERATE_BASE_ADDR, (void **) &generate));
 	data_chA = (int32_t *) ((char *) generate + (CHA_DATA_OFFSET));
 	data_chB = (int32_t *) ((char *) generate + (CHB_DATA_OFFSET));
+	// Channel properties are shadowed, see cmn_ShadowRegister(), except for the read
+	// pointer the FPGA updates
+	ECHECK(cmn_ShadowRegister((volatile uint32_t *) &generate->properties_chA, PROPERTIES_HEAD_WORDS, NULL));
+	ECHECK(cmn_ShadowRegister(&generate->properties_chA.cyclesInOneBurst, PROPERTIES_BURST_WORDS, NULL));
+	ECHECK(cmn_ShadowRegister((volatile uint32_t *) &generate->properties_chB, PROPERTIES_HEAD_WORDS, NULL));
+	ECHECK(cmn_ShadowRegister(&generate->properties_chB.cyclesInOneBurst, PROPERTIES_BURST_WORDS, NULL));
 	return RP_OK;
 }
 
 int generate_Release() {
+	ECHECK(cmn_ShadowUnregister(&generate->properties_chB.cyclesInOneBurst));
+	ECHECK(cmn_ShadowUnregister((volatile uint32_t *) &generate->properties_chB));
+	ECHECK(cmn_ShadowUnregister(&generate->properties_chA.cyclesInOneBurst));
+	ECHECK(cmn_ShadowUnregister((volatile uint32_t *) &generate->properties_chA));
 	ECHECK(cmn_Unmap(GENERATE_BASE_SIZE, (void **) &generate));
 //	ECHECK(cmn_Release());
 	data_chA = NULL;
@@ -119,8 +89,8 @@ int generate_setAmplitude(rp_channel_t channel, float amplitude) {
 	uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
 	ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-	ch_properties->amplitudeScale = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
-	return RP_OK;
+	uint32_t cnt = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
+	return cmn_SetValue((volatile uint32_t *) ch_properties, cnt, PROPERTY_VALUE_MASK);
 }
 
 int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
@@ -129,8 +99,10 @@ int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
     rp_calib_params_t calib = calib_GetParams();
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
+    uint32_t cnt;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *amplitude = cmn_CnvCntToV(DATA_BIT_LENGTH, ch_properties->amplitudeScale, AMPLITUDE_MAX, amp_max, 0, 0.0);
+    ECHECK(cmn_GetValue((volatile uint32_t *) ch_properties, &cnt, PROPERTY_VALUE_MASK));
+    *amplitude = cmn_CnvCntToV(DATA_BIT_LENGTH, cnt, AMPLITUDE_MAX, amp_max, 0, 0.0);
     return RP_OK;
 }
 
@@ -142,8 +114,8 @@ int generate_setDCOffset(rp_channel_t channel, float offset) {
 	uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 	
 	ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-	ch_properties->amplitudeOffset = cmn_CnvVToCnt(DATA_BIT_LENGTH, offset, (float) (OFFSET_MAX/2.f), false, amp_max, dc_offs, 0);
-	return RP_OK;
+	uint32_t cnt = cmn_CnvVToCnt(DATA_BIT_LENGTH, offset, (float) (OFFSET_MAX/2.f), false, amp_max, dc_offs, 0);
+	return cmn_SetShiftedValue((volatile uint32_t *) ch_properties, cnt, PROPERTY_VALUE_MASK, PROPERTY_OFFSET_SHIFT);
 }
 
 int generate_getDCOffset(rp_channel_t channel, float *offset) {
@@ -153,31 +125,34 @@ int generate_getDCOffset(rp_channel_t channel, float *offset) {
 	int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
 	uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 	
+    uint32_t cnt;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *offset = cmn_CnvCntToV(DATA_BIT_LENGTH, ch_properties->amplitudeOffset, (float) (OFFSET_MAX/2.f), amp_max, dc_offs, 0);
+    ECHECK(cmn_GetShiftedValue((volatile uint32_t *) ch_properties, &cnt, PROPERTY_VALUE_MASK, PROPERTY_OFFSET_SHIFT));
+    *offset = cmn_CnvCntToV(DATA_BIT_LENGTH, cnt, (float) (OFFSET_MAX/2.f), amp_max, dc_offs, 0);
     return RP_OK;
 }
 
 int generate_setFrequency(rp_channel_t channel, float frequency) {
 	volatile ch_properties_t *ch_properties;
 	ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-	ch_properties->counterStep = (uint32_t) round(65536 * frequency / DAC_FREQUENCY * BUFFER_LENGTH);
+	ECHECK(cmn_SetValue(&ch_properties->counterStep, (uint32_t) round(65536 * frequency / DAC_FREQUENCY * BUFFER_LENGTH), 0xFFFFFFFF));
 	channel == RP_CH_1 ? (generate->ASM_WrapPointer = 1) : (generate->BSM_WrapPointer = 1);
 	return RP_OK;
 }
 
 int generate_getFrequency(rp_channel_t channel, float *frequency) {
     volatile ch_properties_t *ch_properties;
+    uint32_t step;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *frequency = (float) round((ch_properties->counterStep * DAC_FREQUENCY) / (65536 * BUFFER_LENGTH));
+    ECHECK(cmn_GetValue(&ch_properties->counterStep, &step, 0xFFFFFFFF));
+    *frequency = (float) round((step * DAC_FREQUENCY) / (65536 * BUFFER_LENGTH));
     return RP_OK;
 }
 
 int generate_setWrapCounter(rp_channel_t channel, uint32_t size) {
-	CHANNEL_ACTION(channel,
-			generate->properties_chA.counterWrap = 65536 * size - 1,
-			generate->properties_chB.counterWrap = 65536 * size - 1)
-	return RP_OK;
+	volatile ch_properties_t *ch_properties;
+	ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
+	return cmn_SetValue(&ch_properties->counterWrap, 65536 * size - 1, 0xFFFFFFFF);
 }
 
 int generate_setTriggerSource(rp_channel_t channel, unsigned short value) {
@@ -211,43 +186,37 @@ int generate_getGatedBurst(rp_channel_t channel, uint32_t *value) {
 int generate_setBurstCount(rp_channel_t channel, uint32_t num) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->cyclesInOneBurst = num;
-    return RP_OK;
+    return cmn_SetValue(&ch_properties->cyclesInOneBurst, num, 0xFFFFFFFF);
 }
 
 int generate_getBurstCount(rp_channel_t channel, uint32_t *num) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *num = ch_properties->cyclesInOneBurst;
-    return RP_OK;
+    return cmn_GetValue(&ch_properties->cyclesInOneBurst, num, 0xFFFFFFFF);
 }
 
 int generate_setBurstRepetitions(rp_channel_t channel, uint32_t repetitions) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->burstRepetitions = repetitions;
-    return RP_OK;
+    return cmn_SetValue(&ch_properties->burstRepetitions, repetitions, 0xFFFFFFFF);
 }
 
 int generate_getBurstRepetitions(rp_channel_t channel, uint32_t *repetitions) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *repetitions = ch_properties->burstRepetitions;
-    return RP_OK;
+    return cmn_GetValue(&ch_properties->burstRepetitions, repetitions, 0xFFFFFFFF);
 }
 
 int generate_setBurstDelay(rp_channel_t channel, uint32_t delay) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    ch_properties->delayBetweenBurstRepetitions = delay;
-    return RP_OK;
+    return cmn_SetValue(&ch_properties->delayBetweenBurstRepetitions, delay, 0xFFFFFFFF);
 }
 
 int generate_getBurstDelay(rp_channel_t channel, uint32_t *delay) {
     volatile ch_properties_t *ch_properties;
     ECHECK(getChannelPropertiesAddress(&ch_properties, channel));
-    *delay = ch_properties->delayBetweenBurstRepetitions;
-    return RP_OK;
+    return cmn_GetValue(&ch_properties->delayBetweenBurstRepetitions, delay, 0xFFFFFFFF);
 }
 
 int generate_simultaneousTrigger() {
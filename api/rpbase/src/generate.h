@@ -14,6 +14,8 @@
 #ifndef __GENERATE_H
 #define __GENERATE_H
 
+#include <stdint.h>
+
 #define LEVEL_MAX	            1.0	        // V
 #define AMPLITUDE_MAX           1.0         // V
 #define ARBITRARY_MIN          -1.0	        // V
@@ -37,8 +39,54 @@
 #define CHA_DATA_OFFSET         0x10000
 #define CHB_DATA_OFFSET         0x20000
 #define DATA_BIT_LENGTH         14
+#define PROPERTY_VALUE_MASK     ((1 << DATA_BIT_LENGTH) - 1)    // amplitude scale and offset
+#define PROPERTY_OFFSET_SHIFT   16
+#define PROPERTIES_HEAD_WORDS   4   // amplitude to counter step, see ch_properties_t
+#define PROPERTIES_BURST_WORDS  3   // burst count to burst delay
 #define MICRO                   1e6
 
+// Base Generate address
+#define GENERATE_BASE_ADDR 0x40200000
+#define GENERATE_BASE_SIZE 0x30000
+
+typedef struct ch_properties {
+	unsigned int amplitudeScale		:14;
+	unsigned int 					:2;
+	unsigned int amplitudeOffset    :14;
+	unsigned int 					:2;
+	uint32_t counterWrap;
+	uint32_t startOffset;
+	uint32_t counterStep;
+    unsigned int                    :2;
+	uint32_t buffReadPointer        :14;
+    unsigned int                    :16;
+    uint32_t cyclesInOneBurst;
+    uint32_t burstRepetitions;
+    uint32_t delayBetweenBurstRepetitions;
+} ch_properties_t;
+
+typedef struct generate_control_s {
+	unsigned int AtriggerSelector   :4;
+	unsigned int ASM_WrapPointer    :1;
+	unsigned int                    :1;
+	unsigned int ASM_reset 		   	:1;
+	unsigned int AsetOutputTo0 	   	:1;
+    unsigned int AgatedBursts       :1;
+	unsigned int 				   	:7;
+
+	unsigned int BtriggerSelector   :4;
+	unsigned int BSM_WrapPointer    :1;
+	unsigned int                    :1;
+	unsigned int BSM_reset 		   	:1;
+	unsigned int BsetOutputTo0 	   	:1;
+    unsigned int BgatedBursts       :1;
+    unsigned int 				   	:7;
+
+	ch_properties_t properties_chA;
+	ch_properties_t properties_chB;
+} generate_control_t;
+
+
 int generate_Init();
 int generate_Release();
 
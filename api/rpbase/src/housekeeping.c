@@ -64,11 +64,17 @@ int hk_Init()
 {
 //    ECHECK(cmn_Init());
     ECHECK(cmn_Map(HOUSEKEEPING_BASE_SIZE, HOUSEKEEPING_BASE_ADDR, (void**)&hk));
+
+    // Digital loop, expansion connector directions and outputs, LEDs
+    ECHECK(cmn_ShadowRegister(&hk->digital_loop, 5, NULL));
+    ECHECK(cmn_ShadowRegister(&hk->led_control, 1, NULL));
     return RP_OK;
 }
 
 int hk_Release()
 {
+    ECHECK(cmn_ShadowUnregister(&hk->led_control));
+    ECHECK(cmn_ShadowUnregister(&hk->digital_loop));
     ECHECK(cmn_Unmap(HOUSEKEEPING_BASE_SIZE, (void**)&hk));
 //    ECHECK(cmn_Release());
     return RP_OK;
@@ -113,7 +119,9 @@ int hk_UnsetLedBits(uint32_t bits)
 
 int hk_AreLedBitsSet(uint32_t bits, bool* result)
 {
-    return cmn_AreBitsSet(hk->led_control, bits, LED_CONTROL_MASK, result);
+    uint32_t value;
+    ECHECK(cmn_GetValue(&hk->led_control, &value, 0xFFFFFFFF));
+    return cmn_AreBitsSet(value, bits, LED_CONTROL_MASK, result);
 }
 
 
@@ -133,7 +141,9 @@ int hk_UnsetExCdPBits(uint32_t bits)
 
 int hk_AreExCdPBitsSet(uint32_t bits, bool* result)
 {
-    return cmn_AreBitsSet(hk->ex_cd_p, bits, EX_CD_P_MASK, result);
+    uint32_t value;
+    ECHECK(cmn_GetValue(&hk->ex_cd_p, &value, 0xFFFFFFFF));
+    return cmn_AreBitsSet(value, bits, EX_CD_P_MASK, result);
 }
 
 
@@ -153,7 +163,9 @@ int hk_UnsetExCdNBits(uint32_t bits)
 
 int hk_AreExCdNBitsSet(uint32_t bits, bool* result)
 {
-    return cmn_AreBitsSet(hk->ex_cd_n, bits, EX_CD_N_MASK, result);
+    uint32_t value;
+    ECHECK(cmn_GetValue(&hk->ex_cd_n, &value, 0xFFFFFFFF));
+    return cmn_AreBitsSet(value, bits, EX_CD_N_MASK, result);
 }
 
 
@@ -173,7 +185,9 @@ int hk_UnsetExCoPBits(uint32_t bits)
 
 int hk_AreExCoPBitsSet(uint32_t bits, bool* result)
 {
-    return cmn_AreBitsSet(hk->ex_co_p, bits, EX_CO_P_MASK, result);
+    uint32_t value;
+    ECHECK(cmn_GetValue(&hk->ex_co_p, &value, 0xFFFFFFFF));
+    return cmn_AreBitsSet(value, bits, EX_CO_P_MASK, result);
 }
 
 
@@ -194,7 +208,9 @@ int hk_UnsetExCoNBits(uint32_t bits)
 
 int hk_AreExCoNBitsSet(uint32_t bits, bool* result)
 {
-    return cmn_AreBitsSet(hk->ex_co_n, bits, EX_CO_N_MASK, result);
+    uint32_t value;
+    ECHECK(cmn_GetValue(&hk->ex_co_n, &value, 0xFFFFFFFF));
+    return cmn_AreBitsSet(value, bits, EX_CO_N_MASK, result);
 }
 
 
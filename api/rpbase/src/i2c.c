@@ -13,6 +13,7 @@
 */
 
 
+#include "common.h"
 #include "i2c.h"
 #include "rp.h"
 #include <errno.h>
@@ -28,6 +29,12 @@ int fd = -1;
 
 int i2c_Init() {
     char filename[40];
+    rp_backend_t backend;
+
+    ECHECK(cmn_GetBackend(&backend));
+    if (backend == RP_BACKEND_SIM) {
+        return RP_OK;
+    }
 
     if (fd == -1) {
         sprintf(filename, I2C_DEVICE_NAME);
@@ -39,6 +46,9 @@ int i2c_Init() {
 }
 
 int i2c_Release() {
+    if (fd == -1) {
+        return RP_OK;
+    }
     if (close(fd)) {
         return RP_EFCB;
     }
@@ -22,6 +22,8 @@
 #include "dpin_handler.h"
 #include "oscilloscope.h"
 #include "acq_handler.h"
+#include "acq_stream.h"
+#include "decimator.h"
 #include "analog_mixed_signals.h"
 #include "apin_handler.h"
 #include "health.h"
@@ -30,6 +32,7 @@
 #include "generate.h"
 #include "gen_handler.h"
 #include "i2c.h"
+#include "sim_fpga.h"
 
 static char version[50];
 
@@ -58,6 +61,7 @@ int rp_Init()
 
 int rp_Release()
 {
+    ECHECK(acq_StreamStop());
     ECHECK(osc_Release())
     ECHECK(generate_Release());
     ECHECK(health_Release());
@@ -86,6 +90,31 @@ const char* rp_GetVersion()
     return version;
 }
 
+int rp_SetBackend(rp_backend_t backend)
+{
+    return cmn_SetBackend(backend);
+}
+
+int rp_GetBackend(rp_backend_t* backend)
+{
+    return cmn_GetBackend(backend);
+}
+
+int rp_RegBatchBegin()
+{
+    return cmn_RegBatchBegin();
+}
+
+int rp_RegBatchCommit()
+{
+    return cmn_RegBatchCommit();
+}
+
+int rp_RegCacheReload()
+{
+    return cmn_ShadowReload();
+}
+
 const char* rp_GetError(int errorCode) {
     switch (errorCode) {
         case RP_OK:
@@ -134,6 +163,12 @@ const char* rp_GetError(int errorCode) {
             return "Failed to read from the bus";
         case RP_EFWB:
             return "Failed to write to the bus";
+        case RP_ETMO:
+            return "Operation timed out";
+        case RP_ETHR:
+            return "Failed to start thread";
+        case RP_EBSY:
+            return "Resource is busy";
         default:
             return "Unknown error";
     }
@@ -291,6 +326,16 @@ int rp_AcqGetDecimationFactor(uint32_t* decimation)
     return acq_GetDecimationFactor(decimation);
 }
 
+int rp_AcqSetDecimationRatio(uint32_t ratio)
+{
+    return acq_SetDecimationRatio(ratio);
+}
+
+int rp_AcqGetDecimationRatio(uint32_t* ratio)
+{
+    return acq_GetDecimationRatio(ratio);
+}
+
 int rp_AcqSetSamplingRate(rp_acq_sampling_rate_t sampling_rate)
 {
     return acq_SetSamplingRate(sampling_rate);
@@ -331,6 +376,11 @@ int rp_AcqGetTriggerState(rp_acq_trig_state_t* state)
     return acq_GetTriggerState(state);
 }
 
+int rp_AcqWaitTrigger(int64_t timeout_ns)
+{
+    return acq_WaitTrigger(timeout_ns);
+}
+
 int rp_AcqSetTriggerDelay(int32_t decimated_data_num)
 {
     return acq_SetTriggerDelay(decimated_data_num, false);
@@ -468,6 +518,97 @@ int rp_AcqGetBufSize(uint32_t *size) {
     return acq_GetBufferSize(size);
 }
 
+int rp_AcqGetConvCtx(rp_channel_t channel, rp_acq_conv_ctx_t* ctx)
+{
+    return acq_GetConvCtx(channel, ctx);
+}
+
+int rp_AcqGetRawSpans(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_raw_spans_t* spans)
+{
+    return acq_GetRawSpans(channel, pos, size, spans);
+}
+
+int rp_AcqCheckRawSpans(const rp_acq_raw_spans_t* spans, bool* valid)
+{
+    return acq_CheckRawSpans(spans, valid);
+}
+
+int rp_AcqGetSegments(uint32_t* count, uint32_t size, uint32_t pre_trigger, int16_t* arena1, int16_t* arena2,
+                      rp_acq_segment_t* segments, int32_t timeout_ms)
+{
+    return acq_GetSegments(count, size, pre_trigger, arena1, arena2, segments, timeout_ms);
+}
+
+int rp_AcqAverageFrames(uint32_t* count, uint32_t size, uint32_t pre_trigger, float* avg1, float* avg2,
+                        float* var1, float* var2, int32_t timeout_ms)
+{
+    return acq_AverageFrames(count, size, pre_trigger, avg1, avg2, var1, var2, timeout_ms);
+}
+
+int rp_AcqStreamStart(uint32_t chunk_size, uint32_t chunk_num)
+{
+    return acq_StreamStart(chunk_size, chunk_num);
+}
+
+int rp_AcqStreamStop()
+{
+    return acq_StreamStop();
+}
+
+int rp_AcqStreamRead(int16_t* buffer1, int16_t* buffer2, uint64_t* sequence, int32_t timeout_ms)
+{
+    return acq_StreamRead(buffer1, buffer2, sequence, timeout_ms);
+}
+
+int rp_AcqStreamGetEventFd(int* fd)
+{
+    return acq_StreamGetEventFd(fd);
+}
+
+int rp_AcqStreamGetStats(rp_acq_stream_stats_t* stats)
+{
+    return acq_StreamGetStats(stats);
+}
+
+int rp_AcqStreamResetStats()
+{
+    return acq_StreamResetStats();
+}
+
+/**
+ * Decimator methods
+ */
+
+int rp_DecimatorCreate(uint32_t ratio, rp_decimator_t** dec)
+{
+    return decim_Create(ratio, dec);
+}
+
+int rp_DecimatorDestroy(rp_decimator_t* dec)
+{
+    return decim_Destroy(dec);
+}
+
+int rp_DecimatorReset(rp_decimator_t* dec)
+{
+    return decim_Reset(dec);
+}
+
+int rp_DecimatorProcess(rp_decimator_t* dec, const int16_t* in, uint32_t in_size, float* out, uint32_t* out_size)
+{
+    return decim_Process(dec, in, in_size, out, out_size);
+}
+
+int rp_DecimatorGetResponse(const rp_decimator_t* dec, float freq, float* gain)
+{
+    return decim_GetResponse(dec, freq, gain);
+}
+
+int rp_DecimatorGetDelay(const rp_decimator_t* dec, float* delay)
+{
+    return decim_GetDelay(dec, delay);
+}
+
 /**
  * Health methods
  */
@@ -607,4 +748,20 @@ int rp_I2cRead(int addr, char *data, int length) {
 
 int rp_I2cWrite(int addr, char *data, int length) {
     return i2c_write(addr, data, length);
-}
\ No newline at end of file
+}
+
+/**
+* Simulator methods
+*/
+
+int rp_SimSetWaveform(rp_channel_t channel, rp_sim_waveform_t waveform, float frequency, float amplitude, float offset, float noise) {
+    return sim_SetWaveform(channel, waveform, frequency, amplitude, offset, noise);
+}
+
+int rp_SimSetArbWaveform(rp_channel_t channel, const float* data, uint32_t length) {
+    return sim_SetArbWaveform(channel, data, length);
+}
+
+int rp_SimExtTrigger() {
+    return sim_ExtTrigger();
+}
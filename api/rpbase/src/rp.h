@@ -76,6 +76,12 @@ extern "C" {
 #define RP_EFRB   21
 /** Failed to write to the bus */
 #define RP_EFWB   22
+/** Operation timed out */
+#define RP_ETMO   23
+/** Failed to start thread */
+#define RP_ETHR   24
+/** Resource is busy */
+#define RP_EBSY   25
 
 #define SPECTR_OUT_SIG_LEN (2*1024)
 
@@ -239,6 +245,64 @@ typedef enum {
 } rp_acq_trig_state_t;
 
 
+/**
+ * Zero-copy view of a window in the ADC buffer, as returned by rp_AcqGetRawSpans().
+ * The window is split into at most two contiguous spans of raw ADC words. Each word holds
+ * a 14 bit two's complement ADC count (not calibrated) in the lower bits.
+ */
+typedef struct {
+    const volatile uint32_t* data[2]; //!< Start of first and second span (NULL when the span is empty)
+    uint32_t size[2];                 //!< Number of samples in first and second span
+    uint32_t pos;                     //!< Normalized buffer position of the first sample in the window
+    uint32_t write_pointer;           //!< Write pointer when the spans were taken
+    uint32_t trig_pointer;            //!< Write pointer at trigger when the spans were taken
+    bool     triggered;               //!< Trigger state when the spans were taken
+    uint32_t decimation;              //!< Decimation factor when the spans were taken
+    uint64_t timestamp_ns;            //!< CLOCK_MONOTONIC time when the spans were taken [ns]
+    uint32_t sequence;                //!< Acquisition sequence number, incremented on every start, reset and decimation change
+} rp_acq_raw_spans_t;
+
+
+/**
+ * Statistics of continuous acquisition streaming, as returned by rp_AcqStreamGetStats().
+ */
+typedef struct {
+    uint64_t chunks;       //!< Number of chunks taken from the ADC buffer, including dropped ones
+    uint64_t overruns;     //!< Number of chunks dropped because the stream queue was full
+    uint64_t lost_samples; //!< Number of samples overwritten in the ADC buffer before they could be read
+    uint64_t underruns;    //!< Number of reads that timed out on an empty stream queue
+    uint32_t queued;       //!< Number of chunks currently waiting in the stream queue
+} rp_acq_stream_stats_t;
+
+
+/**
+ * Per segment information of segmented acquisition, as returned by rp_AcqGetSegments().
+ */
+typedef struct {
+    uint64_t timestamp_ns; //!< CLOCK_MONOTONIC time when the trigger was detected [ns]
+    uint32_t trig_pointer; //!< Write pointer at trigger
+    uint64_t dead_time_ns; //!< Time acquisition could not trigger before this segment: from end of previous segment (or the call) until re-armed with pre-trigger data filled [ns]
+} rp_acq_segment_t;
+
+/**
+ * Count to volt conversion context of one acquisition channel, as returned by rp_AcqGetConvCtx().
+ * Voltage of raw sample is ((int)sign extended counts - dc_offs) * scale + offset, with the calibrated
+ * counts limited to the ADC range.
+ */
+typedef struct {
+    float scale;         //!< Volts per count, combines gain and front end calibration
+    float offset;        //!< Volts added after scaling
+    int32_t dc_offs;     //!< Front end DC offset in counts
+    uint32_t generation; //!< Calibration and gain generation the coefficients belong to, 0 if never filled
+} rp_acq_conv_ctx_t;
+
+/**
+ * Software decimation stage: CIC followed by a CIC compensating polyphase FIR.
+ * Created with rp_DecimatorCreate(), one instance per channel.
+ */
+typedef struct rp_decimator_s rp_decimator_t;
+
+
 /**
  * Calibration parameters, stored in the EEPROM device
  */
@@ -255,6 +319,26 @@ typedef struct {
     int32_t  be_ch2_dc_offs; //!< Back end DC offset, on channel B
 } rp_calib_params_t;
 
+/**
+ * Type representing register access backend
+ */
+typedef enum {
+    RP_BACKEND_DEVMEM,  //!< FPGA registers mapped from /dev/mem
+    RP_BACKEND_SIM      //!< Registers backed by process memory and a behavioural FPGA model
+} rp_backend_t;
+
+/**
+ * Type representing signal fed to simulated ADC inputs
+ */
+typedef enum {
+    RP_SIM_WAVE_NONE,       //!< Offset and noise only
+    RP_SIM_WAVE_SINE,       //!< Sine wave
+    RP_SIM_WAVE_SQUARE,     //!< Square wave
+    RP_SIM_WAVE_TRIANGLE,   //!< Triangular wave
+    RP_SIM_WAVE_ARBITRARY,  //!< Waveform set with rp_SimSetArbWaveform(), one value per ADC clock
+    RP_SIM_WAVE_ASG         //!< Output of the same signal generator channel (loopback)
+} rp_sim_waveform_t;
+
 typedef struct wf_func_table_t {
     int (*rp_spectr_wf_init)();
     int (*rp_spectr_wf_clean)();
@@ -305,6 +389,51 @@ const char* rp_GetVersion();
  */
 const char* rp_GetError(int errorCode);
 
+/**
+ * Selects how FPGA registers are accessed. Must be called before rp_Init(). If not called, the
+ * simulator is selected when RP_BACKEND environment variable is set to "sim", /dev/mem otherwise.
+ * @param backend Register access backend.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the library is already initialized, the return value is RP_EBSY.
+ */
+int rp_SetBackend(rp_backend_t backend);
+
+/**
+ * Gets currently selected register access backend.
+ * @param backend Current register access backend.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_GetBackend(rp_backend_t* backend);
+
+/**
+ * Starts a register batch. Until the matching rp_RegBatchCommit(), writes to write-mostly configuration
+ * registers (decimation, trigger levels, hysteresis, trigger delay, filters, generator channel properties,
+ * digital outputs and LEDs) only update the library's shadow copies; each written register is then written
+ * once at commit. Arm, reset, trigger source and output enable still take effect immediately.
+ * Batches may be nested, registers are written when the outermost batch is committed.
+ * A batch belongs to the calling thread: writes from other threads are not held back, and it has to be
+ * committed from the thread that began it.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_RegBatchBegin();
+
+/**
+ * Ends a register batch started with rp_RegBatchBegin() and writes the registers set in it to the FPGA.
+ * @return If the function is successful, the return value is RP_OK.
+ * If no batch is open, the return value is RP_EIPV.
+ */
+int rp_RegBatchCommit();
+
+/**
+ * Re-reads shadowed configuration registers from the FPGA. Needed only when these registers
+ * are modified outside the library (e.g. by another process).
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_RegCacheReload();
+
 
 ///@}
 /** @name Digital loop
@@ -585,6 +714,34 @@ int rp_AcqGetDecimation(rp_acq_decimation_t* decimation);
  */
 int rp_AcqGetDecimationFactor(uint32_t* decimation);
 
+/**
+ * Sets a decimation ratio of 1 or any multiple of 8. Other ratios are rejected: the smallest FPGA
+ * decimation under software decimation is 8, as software can not keep up with 125 MS/s.
+ * The ratio is split into an FPGA decimation and a software decimation stage of up to 1024
+ * (see rp_DecimatorCreate() for the software ratios supported); the FPGA part is chosen so the software
+ * part is at least 8 where possible.
+ * The software stage is applied to acquisition streaming, to the rp_AcqGet*Data* buffer reads and
+ * to rp_AcqGetSamplingRateHz(). rp_AcqGetDecimation(), rp_AcqGetDecimationFactor(), buffer positions
+ * and rp_AcqGetSegments() / rp_AcqAverageFrames() stay at the FPGA part. Setting a decimation with
+ * rp_AcqSetDecimation() or rp_AcqSetSamplingRate() clears the software part.
+ * Under software decimation a buffer read returns one sample every 'software ratio' buffer positions,
+ * sample k centered on position pos + k * ratio. Samples around the read window settle the filter, so
+ * a read returns at most ADC buffer size / software ratio minus the filter settling length samples.
+ * @param ratio Total decimation ratio.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EOOR if the ratio can not be split into an FPGA and a supported software part, e.g. 8 * 1021.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqSetDecimationRatio(uint32_t ratio);
+
+/**
+ * Gets the total decimation ratio, FPGA decimation factor times software decimation ratio.
+ * @param ratio Returns decimation ratio.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetDecimationRatio(uint32_t* ratio);
+
 /**
  * Sets the sampling rate for acquiring signal. There is only a set of pre-defined sampling rate
  * values which can be specified. See the #rp_acq_sampling_rate_t enum values.
@@ -599,6 +756,7 @@ int rp_AcqSetSamplingRate(rp_acq_sampling_rate_t sampling_rate);
  * values which can be returned. See the #rp_acq_sampling_rate_t enum values.
  * @param sampling_rate Returns one of pre-defined sampling rate value which is currently set
  * @return If the function is successful, the return value is RP_OK.
+ * RP_EOOR if a software decimation ratio is set with rp_AcqSetDecimationRatio(), use rp_AcqGetSamplingRateHz().
  * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
  */
 int rp_AcqGetSamplingRate(rp_acq_sampling_rate_t* sampling_rate);
@@ -606,7 +764,8 @@ int rp_AcqGetSamplingRate(rp_acq_sampling_rate_t* sampling_rate);
 /**
  * Gets the sampling rate for acquiring signal in a numerical form in Hz. Although this method returns a float
  * value representing the current value of the sampling rate, there is only a set of pre-defined sampling rate
- * values which can be returned. See the #rp_acq_sampling_rate_t enum values.
+ * values which can be returned. See the #rp_acq_sampling_rate_t enum values. Includes the software
+ * decimation ratio set with rp_AcqSetDecimationRatio().
  * @param sampling_rate returns currently set sampling rate in Hz
  * @return If the function is successful, the return value is RP_OK.
  * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
@@ -660,6 +819,18 @@ int rp_AcqGetTriggerSrc(rp_acq_trig_src_t* source);
  */
 int rp_AcqGetTriggerState(rp_acq_trig_state_t* state);
 
+/**
+ * Blocks until the acquisition is triggered, sleeping between checks instead of busy polling.
+ * The check interval adapts to the current decimation and to the time left to fill the pre-trigger
+ * part of the buffer. Trigger is detected by the FPGA clearing the trigger source, so the trigger
+ * source must be set before waiting, otherwise the function returns immediately.
+ * @param timeout_ns Maximum time to wait in ns. Negative value waits indefinitely.
+ * @return If the acquisition was triggered, the return value is RP_OK.
+ * If the timeout expired, the return value is RP_ETMO.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqWaitTrigger(int64_t timeout_ns);
+
 /**
  * Sets the number of decimated data after trigger written into memory.
  * @param decimated_data_num Number of decimated data. It must not be higher than the ADC buffer size.
@@ -919,6 +1090,219 @@ int rp_AcqGetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int rp_AcqGetBufSize(uint32_t* size);
 
+/**
+ * Updates count to volt conversion context of a channel. Coefficients are recomputed only when the
+ * gain or calibration changed since the context was last filled, otherwise the call returns immediately.
+ * Initialize the context with zeros before the first call.
+ * @param channel Channel A or B.
+ * @param ctx Conversion context, kept by the caller between calls.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetConvCtx(rp_channel_t channel, rp_acq_conv_ctx_t* ctx);
+
+/**
+ * Returns a zero-copy view of the ADC buffer window starting at 'pos' with 'size' samples.
+ * No data is copied: spans point directly into the mapped ADC buffer, so the caller can run
+ * its processing on them. Together with the spans, the write pointer, write pointer at trigger
+ * and trigger state valid at the time of the call are returned.
+ * Use rp_AcqCheckRawSpans() after processing to check that the FPGA did not overwrite the window meanwhile.
+ * @param channel Channel A or B for which we want to retrieve the ADC buffer view.
+ * @param pos Starting position of the window in the ADC buffer.
+ * @param size Length of the window. Must not be larger than the ADC buffer.
+ * @param spans The view of the window, with acquisition metadata.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetRawSpans(rp_channel_t channel, uint32_t pos, uint32_t size, rp_acq_raw_spans_t* spans);
+
+/**
+ * Checks whether a view returned by rp_AcqGetRawSpans() still holds the data it pointed to
+ * when it was taken. The view is invalid when the acquisition was restarted since, or when
+ * the FPGA could have written into the window (write pointer progress and elapsed time are checked).
+ * @param spans The view returned by rp_AcqGetRawSpans().
+ * @param valid Returns true if the window was not overwritten.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqCheckRawSpans(const rp_acq_raw_spans_t* spans, bool* valid);
+
+/**
+ * Starts continuous, gap-free acquisition streaming with the currently set decimation.
+ * Trigger is disabled and a background thread follows the write pointer, copying both channels
+ * in chunks of 'chunk_size' samples (calibrated ADC counts, as rp_AcqGetDataRaw()) into a
+ * preallocated queue of 'chunk_num' chunks. When a software decimation ratio is set with
+ * rp_AcqSetDecimationRatio(), samples pass through the software decimation stage first and
+ * chunks hold decimated samples, rounded to counts.
+ * @param chunk_size Number of samples per channel in one chunk. At most half of the ADC buffer.
+ * @param chunk_num Number of chunks in the stream queue, at least 2.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamStart(uint32_t chunk_size, uint32_t chunk_num);
+
+/**
+ * Stops acquisition streaming and releases the stream queue. Also needed after the stream thread stopped
+ * on an error, before streaming can be started again. rp_AcqStreamRead() calls blocked in other threads
+ * are woken up and return RP_EOOR; the queue is released after they returned.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamStop();
+
+/**
+ * Takes the oldest chunk from the stream queue. Blocks until a chunk is available or the timeout expires.
+ * Chunk sequence numbers increase by one for consecutive chunks; a larger step means samples were lost.
+ * @param buffer1 Output buffer for channel A, at least 'chunk_size' long.
+ * @param buffer2 Output buffer for channel B, at least 'chunk_size' long.
+ * @param sequence Returns sequence number of the chunk. Can be NULL.
+ * @param timeout_ms Timeout in milliseconds. 0 returns immediately, -1 waits forever.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETMO if no chunk became available in time (counted as underrun).
+ * RP_EOOR if the stream is not running; the stream thread stops on an error and wakes up the readers.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamRead(int16_t* buffer1, int16_t* buffer2, uint64_t* sequence, int32_t timeout_ms);
+
+/**
+ * Returns an eventfd that becomes readable when new chunks are put into the stream queue.
+ * It can be used with poll/select/epoll; rp_AcqStreamRead() clears it.
+ * @param fd Returned file descriptor. Valid until rp_AcqStreamStop().
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamGetEventFd(int* fd);
+
+/**
+ * Returns streaming throughput and drop statistics.
+ * @param stats Returned statistics.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamGetStats(rp_acq_stream_stats_t* stats);
+
+/**
+ * Clears streaming statistics counters.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqStreamResetStats();
+
+/**
+ * Captures 'count' consecutive triggered segments of 'size' samples into caller provided arenas.
+ * Trigger source is the one last set with rp_AcqSetTriggerSrc(). It is kept disabled until the pre-trigger
+ * part is in the buffer, including the first segment, so each segment holds 'pre_trigger' samples before the trigger. The trigger delay is set internally so that writing stops right after
+ * the segment and restored on return. The acquisition is re-armed inside the library as soon as
+ * a segment is complete; when the segment can be read out before the new acquisition could overwrite it,
+ * re-arm happens even before the read out. Data is in calibrated ADC counts, as rp_AcqGetDataRaw().
+ * @param count Number of segments to capture. Returns number of segments captured.
+ * @param size Number of samples per segment. Must be smaller than the ADC buffer.
+ * @param pre_trigger Number of samples before trigger in each segment. Must not be larger than 'size'.
+ * @param arena1 Output buffer for channel A, at least 'count' * 'size' long. Can be NULL.
+ * @param arena2 Output buffer for channel B, at least 'count' * 'size' long. Can be NULL.
+ * @param segments Output segment information, at least 'count' long.
+ * @param timeout_ms Maximal time to wait for each trigger in milliseconds, counted from the moment the pre-trigger
+ * part is in the buffer and the trigger is enabled, -1 waits forever.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETMO if a trigger did not arrive in time; 'count' then returns number of segments captured.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqGetSegments(uint32_t* count, uint32_t size, uint32_t pre_trigger, int16_t* arena1, int16_t* arena2,
+                      rp_acq_segment_t* segments, int32_t timeout_ms);
+
+/**
+ * Captures 'count' triggered frames the same way as rp_AcqGetSegments() and averages them on the board.
+ * Each frame is accumulated sample by sample into integer sums as soon as it is captured, so only
+ * the averaged frame and its variance are returned. Averaging n frames lowers uncorrelated noise by sqrt(n).
+ * @param count Number of frames to average, not zero. Returns number of frames averaged.
+ * @param size Number of samples per frame. Must be smaller than the ADC buffer.
+ * @param pre_trigger Number of samples before trigger in each frame. Must not be larger than 'size'.
+ * @param avg1 Output averaged frame of channel A in V, at least 'size' long. Can be NULL.
+ * @param avg2 Output averaged frame of channel B in V, at least 'size' long. Can be NULL.
+ * @param var1 Output per sample variance across frames of channel A in V^2, at least 'size' long.
+ * Zero when only one frame is averaged. Can be NULL.
+ * @param var2 Output per sample variance across frames of channel B in V^2. Can be NULL.
+ * @param timeout_ms Maximal time to wait for each trigger in milliseconds, -1 waits forever.
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_ETMO if a trigger did not arrive in time; 'count' then returns number of frames averaged
+ * and, unless it is zero, the outputs hold their average. Outputs are not written when no frame
+ * was captured.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAverageFrames(uint32_t* count, uint32_t size, uint32_t pre_trigger, float* avg1, float* avg2,
+                        float* var1, float* var2, int32_t timeout_ms);
+
+
+///@}
+/** @name Decimator
+ * Streaming software decimation by an integer ratio from 2 to 1024. The ratio is split into a
+ * 5 stage CIC decimator and a polyphase FIR decimator by the smallest factor of the ratio that is at least 4.
+ * That factor must not exceed 32, which bounds the FIR to 1024 taps: ratios up to 32 and ratios with a
+ * factor from 4 to 32 are supported, others (e.g. primes above 32 or twice such a prime) are rejected.
+ * The FIR compensates the CIC droop and suppresses aliases: the response is flat within 0.05 dB
+ * up to 0.4 of the output sample rate and everything that aliases into that band is attenuated by more than 75 dB.
+ */
+///@{
+
+/**
+ * Creates a decimator and designs its filter.
+ * @param ratio Decimation ratio, 2 to 1024, with a factor from 4 to 32 unless it is at most 32.
+ * @param dec Returns the decimator. Release it with rp_DecimatorDestroy().
+ * @return If the function is successful, the return value is RP_OK.
+ * RP_EOOR if the ratio is out of range or its FIR stage would be longer than 1024 taps.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DecimatorCreate(uint32_t ratio, rp_decimator_t** dec);
+
+/**
+ * Releases a decimator.
+ * @param dec Decimator created with rp_DecimatorCreate().
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DecimatorDestroy(rp_decimator_t* dec);
+
+/**
+ * Clears the filter state, as after creation. Use it when input samples were lost.
+ * @param dec Decimator created with rp_DecimatorCreate().
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DecimatorReset(rp_decimator_t* dec);
+
+/**
+ * Feeds consecutive samples through the decimator. Filter state carries over between calls,
+ * so a signal can be processed in blocks of any size.
+ * @param dec Decimator created with rp_DecimatorCreate().
+ * @param in Input samples.
+ * @param in_size Number of input samples.
+ * @param out Output samples, in the same units as the input (unity DC gain).
+ * Must hold at least in_size / ratio + 1 samples.
+ * @param out_size Returns number of output samples.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DecimatorProcess(rp_decimator_t* dec, const int16_t* in, uint32_t in_size, float* out, uint32_t* out_size);
+
+/**
+ * Gets amplitude response of the whole decimator at an input frequency.
+ * @param dec Decimator created with rp_DecimatorCreate().
+ * @param freq Input frequency relative to the output sample rate. Values above 0.5 give
+ * the attenuation of components that alias into the output band.
+ * @param gain Returns linear amplitude gain.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DecimatorGetResponse(const rp_decimator_t* dec, float freq, float* gain);
+
+/**
+ * Gets group delay of the decimator. The filter has linear phase, so it is the same at all frequencies.
+ * @param dec Decimator created with rp_DecimatorCreate().
+ * @param delay Returns delay in output samples.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_DecimatorGetDelay(const rp_decimator_t* dec, float* delay);
 
 ///@}
 /** @name Health
@@ -1226,6 +1610,44 @@ int rp_I2cRead(int addr, char *data, int length);
 */
 int rp_I2cWrite(int addr, char *data, int length);
 
+///@}
+/** @name Simulator
+ * Test signal injection, valid only with RP_BACKEND_SIM backend. Inputs are in volts,
+ * where +-1 V is the ADC full scale.
+ */
+///@{
+
+/**
+* Sets signal fed to simulated ADC input.
+* @param channel Channel A or B.
+* @param waveform Signal shape.
+* @param frequency Signal frequency in Hz.
+* @param amplitude Signal amplitude in V.
+* @param offset DC offset in V, added to the signal.
+* @param noise Amplitude of uniform noise in V, added to the signal.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_SimSetWaveform(rp_channel_t channel, rp_sim_waveform_t waveform, float frequency, float amplitude, float offset, float noise);
+
+/**
+* Sets arbitrary signal fed to simulated ADC input and selects RP_SIM_WAVE_ARBITRARY waveform.
+* The data is repeated, one value per (non-decimated) ADC clock.
+* @param channel Channel A or B.
+* @param data Signal values in V. Data is copied.
+* @param length Number of values.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_SimSetArbWaveform(rp_channel_t channel, const float* data, uint32_t length);
+
+/**
+* Generates one pulse on simulated external trigger input.
+* @return If the function is successful, the return value is RP_OK.
+* If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+*/
+int rp_SimExtTrigger();
+
 ///@}
 
 #ifdef __cplusplus
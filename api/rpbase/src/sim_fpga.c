@@ -0,0 +1,489 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library simulated FPGA register backend implementation
+ *
+ * Register blocks are mapped to anonymous process memory instead of /dev/mem. A model
+ * thread periodically brings the oscilloscope block up to date with real time: write
+ * pointer advances at 125 MS/s / decimation, threshold, immediate, external and ASG
+ * triggers are evaluated sample by sample and writing stops after the trigger delay,
+ * unless arm keep is set.
+ * ADC inputs are fed with injectable test waveforms or with the output of the signal
+ * generator model, which follows the generate.c register layout.
+ *
+ * Only the last buffer length of samples is generated when the model falls behind
+ * (e.g. at decimation 1), so triggers within skipped samples are not seen. A trigger is
+ * only taken where the buffer in front of it was generated, and the post-trigger part
+ * is never skipped.
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "generate.h"
+#include "sim_fpga.h"
+
+#define SIM_MAX_REGIONS 8
+
+/* @brief Model update period [ns] */
+static const uint64_t SIM_TICK_NS = 50000;
+
+/* Oscilloscope configuration register bits */
+static const uint32_t CONF_ARM      = 0x1;
+static const uint32_t CONF_RST      = 0x2;
+static const uint32_t CONF_TRIG_ST  = 0x4;
+static const uint32_t CONF_ARM_KEEP = 0x8;
+
+typedef struct {
+    size_t offset;
+    size_t size;
+    void* mem;
+    int refs;
+} sim_region_t;
+
+typedef struct {
+    rp_sim_waveform_t waveform;
+    float frequency;
+    float amplitude;
+    float offset;
+    float noise;
+    float* arb;
+    uint32_t arb_len;
+} sim_input_t;
+
+typedef struct {
+    bool writing;
+    bool triggered;
+    uint32_t wp;
+    uint32_t post_left;
+    uint64_t sample;        // decimated samples written since start of simulation
+    uint64_t last_ns;
+    bool pe_armed[2];
+    bool ne_armed[2];
+    bool asg_wrap;
+} sim_osc_t;
+
+static sim_region_t regions[SIM_MAX_REGIONS];
+static sim_input_t inputs[2];
+static sim_osc_t osc;
+static volatile bool ext_trigger = false;
+static unsigned int noise_seed = 1;
+
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t sim_thread;
+static volatile bool sim_running = false;
+
+static uint64_t getTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int32_t signExtend(uint32_t value, int bits)
+{
+    return (int32_t)(value << (32 - bits)) >> (32 - bits);
+}
+
+/* Returns region that contains the whole [offset, offset + size) range, must be called locked */
+static void* findRegion(size_t offset, size_t size)
+{
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem != NULL && offset >= regions[i].offset && offset + size <= regions[i].offset + regions[i].size) {
+            return (char*)regions[i].mem + (offset - regions[i].offset);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Signal generator model
+ */
+
+/* Output of generator channel at DAC clock cycle, in DAC full scale units */
+static float asgOutput(volatile generate_control_t* gen, rp_channel_t channel, uint64_t clk, bool* wrapped)
+{
+    volatile ch_properties_t* prop = channel == RP_CH_1 ? &gen->properties_chA : &gen->properties_chB;
+    const volatile int32_t* data = (int32_t*)((char*)gen + (channel == RP_CH_1 ? CHA_DATA_OFFSET : CHB_DATA_OFFSET));
+    bool disabled = channel == RP_CH_1 ? gen->AsetOutputTo0 : gen->BsetOutputTo0;
+    uint64_t wrap = (uint64_t)prop->counterWrap + 1;
+
+    if (disabled || prop->counterStep == 0 || wrap <= 1) {
+        *wrapped = false;
+        return 0;
+    }
+
+    uint64_t ptr = (prop->startOffset + (uint64_t)prop->counterStep * clk) % wrap;
+    *wrapped = ptr < prop->counterStep;
+
+    int32_t value = signExtend(data[(ptr >> 16) % BUFFER_LENGTH], DATA_BIT_LENGTH);
+    int32_t out = (value * (int32_t)prop->amplitudeScale) / (1 << (DATA_BIT_LENGTH - 1))
+                + signExtend(prop->amplitudeOffset, DATA_BIT_LENGTH);
+
+    return (float)MIN(MAX(out, -(1 << (DATA_BIT_LENGTH - 1))), (1 << (DATA_BIT_LENGTH - 1)) - 1) / (1 << (DATA_BIT_LENGTH - 1));
+}
+
+/*
+ * Oscilloscope model
+ */
+
+static float inputSample(volatile generate_control_t* gen, rp_channel_t channel, uint64_t clk, bool* asg_wrap)
+{
+    const sim_input_t* in = &inputs[channel];
+    double t = (double)clk * ADC_SAMPLE_PERIOD * 1e-9;
+    double phase = in->frequency * t - floor(in->frequency * t);
+    float v = in->offset;
+    bool wrapped = false;
+
+    switch (in->waveform) {
+    case RP_SIM_WAVE_SINE:
+        v += in->amplitude * sin(2 * M_PI * phase);
+        break;
+    case RP_SIM_WAVE_SQUARE:
+        v += phase < 0.5 ? in->amplitude : -in->amplitude;
+        break;
+    case RP_SIM_WAVE_TRIANGLE:
+        v += in->amplitude * (phase < 0.5 ? 4 * phase - 1 : 3 - 4 * phase);
+        break;
+    case RP_SIM_WAVE_ARBITRARY:
+        if (in->arb_len > 0) {
+            v += in->arb[clk % in->arb_len];
+        }
+        break;
+    case RP_SIM_WAVE_ASG:
+        if (gen != NULL) {
+            v += asgOutput(gen, channel, clk, &wrapped);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (in->noise > 0) {
+        v += in->noise * (2.0f * rand_r(&noise_seed) / RAND_MAX - 1.0f);
+    }
+    if (channel == RP_CH_1) {
+        *asg_wrap = wrapped;
+    }
+    return v;
+}
+
+static bool checkTrigger(volatile osc_control_t* reg, uint32_t source, const int32_t cnts[2])
+{
+    int ch = (source == RP_TRIG_SRC_CHA_PE || source == RP_TRIG_SRC_CHA_NE) ? 0 : 1;
+    int32_t thr = signExtend(ch == 0 ? reg->cha_thr : reg->chb_thr, 14);
+    int32_t hyst = (ch == 0 ? reg->cha_hystersis : reg->chb_hystersis) & 0x3FFF;
+
+    switch (source) {
+    case RP_TRIG_SRC_NOW:
+        return true;
+    case RP_TRIG_SRC_CHA_PE:
+    case RP_TRIG_SRC_CHB_PE:
+        if (osc.pe_armed[ch] && cnts[ch] >= thr) {
+            return true;
+        }
+        osc.pe_armed[ch] |= cnts[ch] < thr - hyst;
+        return false;
+    case RP_TRIG_SRC_CHA_NE:
+    case RP_TRIG_SRC_CHB_NE:
+        if (osc.ne_armed[ch] && cnts[ch] <= thr) {
+            return true;
+        }
+        osc.ne_armed[ch] |= cnts[ch] > thr + hyst;
+        return false;
+    case RP_TRIG_SRC_EXT_PE:
+    case RP_TRIG_SRC_EXT_NE:
+        return __sync_bool_compare_and_swap(&ext_trigger, true, false);
+    case RP_TRIG_SRC_AWG_PE:
+    case RP_TRIG_SRC_AWG_NE:
+        return osc.asg_wrap;
+    default:
+        return false;
+    }
+}
+
+static void oscTick(volatile osc_control_t* reg, volatile generate_control_t* gen, uint64_t now_ns)
+{
+    uint32_t conf = reg->conf;
+    uint32_t decimation = MAX(reg->data_dec & 0x1FFFF, 1);
+    uint64_t period = ADC_SAMPLE_PERIOD * decimation;
+    volatile uint32_t* buf[2] = {
+        (uint32_t*)((char*)reg + OSC_CHA_OFFSET),
+        (uint32_t*)((char*)reg + OSC_CHB_OFFSET)
+    };
+
+    if (conf & CONF_RST) {
+        osc.writing = false;
+        osc.triggered = false;
+        __sync_fetch_and_and(&reg->conf, ~(CONF_RST | CONF_ARM | CONF_TRIG_ST));
+        reg->pre_trigger_counter = 0;
+    }
+    if (conf & CONF_ARM) {
+        /* Writing starts at the arm, time before it passed without writing */
+        uint64_t idle = (now_ns - osc.last_ns) / period;
+        osc.sample += idle;
+        osc.last_ns += idle * period;
+        osc.writing = true;
+        osc.triggered = false;
+        memset(osc.pe_armed, 0, sizeof(osc.pe_armed));
+        memset(osc.ne_armed, 0, sizeof(osc.ne_armed));
+        __sync_fetch_and_and(&reg->conf, ~(CONF_ARM | CONF_TRIG_ST));
+        reg->pre_trigger_counter = 0;
+    }
+
+    uint64_t n = (now_ns - osc.last_ns) / period;
+    osc.last_ns += n * period;
+
+    if (!osc.writing || n == 0) {
+        osc.sample += n;
+        return;
+    }
+
+    /* Skipped samples would be overwritten anyway, the trigger is only checked once the
+     * stale part in front of the trigger delay is overwritten */
+    uint64_t stale = 0;
+    bool stopping = osc.triggered && !(conf & CONF_ARM_KEEP);
+    if (n > ADC_BUFFER_SIZE && !stopping) {
+        uint64_t skip = n - ADC_BUFFER_SIZE;
+        osc.sample += skip;
+        osc.wp = (osc.wp + skip) % ADC_BUFFER_SIZE;
+        if (!osc.triggered) {
+            reg->pre_trigger_counter += skip;
+        }
+        n = ADC_BUFFER_SIZE;
+        stale = ADC_BUFFER_SIZE - MIN(reg->trigger_delay, ADC_BUFFER_SIZE);
+    }
+
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t clk = ++osc.sample * decimation;
+        int32_t cnts[2];
+
+        osc.wp = (osc.wp + 1) % ADC_BUFFER_SIZE;
+        for (int ch = 0; ch < 2; ++ch) {
+            float v = inputSample(gen, (rp_channel_t)ch, clk, &osc.asg_wrap);
+            cnts[ch] = MIN(MAX((int32_t)lrintf(v * (1 << 13)), -(1 << 13)), (1 << 13) - 1);
+            buf[ch][osc.wp] = (uint32_t)cnts[ch] & 0x3FFF;
+        }
+
+        if (!osc.triggered) {
+            reg->pre_trigger_counter++;
+            uint32_t source = reg->trig_source & 0xF;
+            if (source != RP_TRIG_SRC_DISABLED && i >= stale && checkTrigger(reg, source, cnts)) {
+                osc.triggered = true;
+                osc.post_left = reg->trigger_delay;
+                reg->wr_ptr_trigger = osc.wp;
+                reg->trig_source = RP_TRIG_SRC_DISABLED;
+                __sync_fetch_and_or(&reg->conf, CONF_TRIG_ST);
+            }
+        }
+        else if (conf & CONF_ARM_KEEP) {
+            continue;
+        }
+        else if (osc.post_left == 0 || --osc.post_left == 0) {
+            osc.writing = false;
+            osc.sample += n - i - 1;
+            break;
+        }
+    }
+
+    reg->wr_ptr_cur = osc.wp;
+}
+
+static void simTick()
+{
+    pthread_mutex_lock(&sim_mutex);
+    volatile osc_control_t* reg = findRegion(OSC_BASE_ADDR, OSC_BASE_SIZE);
+    volatile generate_control_t* gen = findRegion(GENERATE_BASE_ADDR, GENERATE_BASE_SIZE);
+    if (reg != NULL) {
+        oscTick(reg, gen, getTimeNs());
+    }
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static void* simThreadFun(void* arg)
+{
+    struct timespec tick = { .tv_sec = 0, .tv_nsec = SIM_TICK_NS };
+
+    while (sim_running) {
+        simTick();
+        nanosleep(&tick, NULL);
+    }
+    return NULL;
+}
+
+/*
+ * Backend interface
+ */
+
+int sim_Init()
+{
+    if (sim_running) {
+        return RP_OK;
+    }
+
+    memset(&osc, 0, sizeof(osc));
+    osc.last_ns = getTimeNs();
+
+    sim_running = true;
+    if (pthread_create(&sim_thread, NULL, simThreadFun, NULL) != 0) {
+        sim_running = false;
+        return RP_ETHR;
+    }
+    return RP_OK;
+}
+
+int sim_Release()
+{
+    if (!sim_running) {
+        return RP_OK;
+    }
+
+    sim_running = false;
+    pthread_join(sim_thread, NULL);
+
+    for (int ch = 0; ch < 2; ++ch) {
+        free(inputs[ch].arb);
+        inputs[ch].arb = NULL;
+        inputs[ch].arb_len = 0;
+    }
+    return RP_OK;
+}
+
+/* Brings the model up to date now, so a command written to the registers (arm, reset)
+ * takes effect before the caller reads the counters it clears, as on the FPGA */
+int sim_Sync()
+{
+    if (sim_running) {
+        simTick();
+    }
+    return RP_OK;
+}
+
+int sim_Map(size_t size, size_t offset, void** mapped)
+{
+    int ret = RP_EMMD;
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    pthread_mutex_lock(&sim_mutex);
+
+    /* Blocks mapped by several modules share the same registers */
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem != NULL && offset >= regions[i].offset && offset + size <= regions[i].offset + regions[i].size) {
+            regions[i].refs++;
+            *mapped = (char*)regions[i].mem + (offset - regions[i].offset);
+            pthread_mutex_unlock(&sim_mutex);
+            return RP_OK;
+        }
+    }
+
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        if (regions[i].mem == NULL) {
+            size_t len = (size + page_size - 1) & ~(page_size - 1);
+            void* mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem != MAP_FAILED) {
+                regions[i].offset = offset;
+                regions[i].size = len;
+                regions[i].mem = mem;
+                regions[i].refs = 1;
+                *mapped = mem;
+                ret = RP_OK;
+            }
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&sim_mutex);
+    return ret;
+}
+
+int sim_Unmap(size_t size, void** mapped)
+{
+    int ret = RP_EUMD;
+
+    pthread_mutex_lock(&sim_mutex);
+    for (int i = 0; i < SIM_MAX_REGIONS; ++i) {
+        char* mem = regions[i].mem;
+        if (mem != NULL && (char*)*mapped >= mem && (char*)*mapped < mem + regions[i].size) {
+            if (--regions[i].refs == 0) {
+                munmap(mem, regions[i].size);
+                regions[i].mem = NULL;
+            }
+            *mapped = NULL;
+            ret = RP_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sim_mutex);
+
+    return ret;
+}
+
+/*
+ * Test signal injection
+ */
+
+int sim_SetWaveform(rp_channel_t channel, rp_sim_waveform_t waveform, float frequency, float amplitude, float offset, float noise)
+{
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (waveform > RP_SIM_WAVE_ASG || frequency < 0 || noise < 0) {
+        return RP_EOOR;
+    }
+
+    pthread_mutex_lock(&sim_mutex);
+    inputs[channel].waveform = waveform;
+    inputs[channel].frequency = frequency;
+    inputs[channel].amplitude = amplitude;
+    inputs[channel].offset = offset;
+    inputs[channel].noise = noise;
+    pthread_mutex_unlock(&sim_mutex);
+
+    return RP_OK;
+}
+
+int sim_SetArbWaveform(rp_channel_t channel, const float* data, uint32_t length)
+{
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+
+    float* arb = NULL;
+    if (length > 0) {
+        arb = malloc(length * sizeof(float));
+        if (arb == NULL) {
+            return RP_EOOR;
+        }
+        memcpy(arb, data, length * sizeof(float));
+    }
+
+    pthread_mutex_lock(&sim_mutex);
+    free(inputs[channel].arb);
+    inputs[channel].arb = arb;
+    inputs[channel].arb_len = length;
+    inputs[channel].waveform = RP_SIM_WAVE_ARBITRARY;
+    pthread_mutex_unlock(&sim_mutex);
+
+    return RP_OK;
+}
+
+int sim_ExtTrigger()
+{
+    ext_trigger = true;
+    return RP_OK;
+}
@@ -0,0 +1,33 @@
+/**
+ * $Id: $
+ *
+ * @brief Red Pitaya library simulated FPGA register backend interface
+ *
+ * @Author Red Pitaya
+ *
+ * (c) Red Pitaya  http://www.redpitaya.com
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SRC_SIM_FPGA_H_
+#define SRC_SIM_FPGA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rp.h"
+
+int sim_Init();
+int sim_Release();
+int sim_Sync();
+
+int sim_Map(size_t size, size_t offset, void** mapped);
+int sim_Unmap(size_t size, void** mapped);
+
+int sim_SetWaveform(rp_channel_t channel, rp_sim_waveform_t waveform, float frequency, float amplitude, float offset, float noise);
+int sim_SetArbWaveform(rp_channel_t channel, const float* data, uint32_t length);
+int sim_ExtTrigger();
+
+#endif /* SRC_SIM_FPGA_H_ */
@@ -19,6 +19,9 @@
 #include <unistd.h>
 #include <math.h>
 #include <stdlib.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 #include "spec_dsp.h"
 //#include "spectrometerApp.h"
@@ -30,11 +33,26 @@ extern const int c_spectr_fpga_adc_bits;
 
 /* length of output signals: floor(SPECTR_FPGA_SIG_LEN/2) */
 
-/* Internal structures used in DSP  */
-double                *rp_hann_window   = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out1 = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out2 = NULL;
-kiss_fftr_cfg         rp_kiss_fft_cfg  = NULL;
+/* Internal structures used in DSP, the FFT plans and buffers are shared by both
+ * channels which are transformed one after the other. Windows and plans are
+ * indexed by the Welch segment length, SPECTR_FPGA_SIG_LEN >> index. */
+float                 *rp_hann_window[RP_SPECTR_WELCH_LENS];
+float                 *rp_spectr_fft_in = NULL;
+kiss_fft_cpx          *rp_kiss_fft_out  = NULL;
+kiss_fftr_cfg          rp_kiss_fft_cfg[RP_SPECTR_WELCH_LENS];
+
+/* Averaging settings, guarded as they are set from outside the processing */
+pthread_mutex_t        rp_spectr_avg_mutex = PTHREAD_MUTEX_INITIALIZER;
+int                    rp_spectr_welch_seg = 1;
+rp_spectr_avg_mode_t   rp_spectr_avg_mode  = rp_spectr_avg_linear;
+int                    rp_spectr_avg_cnt   = 1;
+int                    rp_spectr_avg_restart = 1;
+
+/* Accumulators, used by rp_spectr_process() only: average in linear power [mW],
+ * holds in dBm, SPECTR_OUT_SIG_LEN each. Channel A first, channel B follows. */
+float                 *rp_spectr_avg_acc = NULL;
+float                 *rp_spectr_max_acc = NULL;
+float                 *rp_spectr_min_acc = NULL;
 
 /* constants - calibration dependant */
 /* Power calc. impedance*/
@@ -85,19 +103,24 @@ int rp_spectr_prepare_freq_vector(float **freq_out, double f_s, float freq_range
 
 int rp_spectr_hann_init()
 {
-    int i;
+    int i, l;
 
-    rp_spectr_hann_clean(rp_hann_window);
+    rp_spectr_hann_clean();
 
-    rp_hann_window = (double *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(double));
-    if(rp_hann_window == NULL) {
-        fprintf(stderr, "rp_spectr_hann_create() can not allocate mem");
-        return -1;
-    }
-    
-    for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
-        rp_hann_window[i] = RP_SPECTR_HANN_AMP * 
-            (1 - cos(2*M_PI*i / (double)(SPECTR_FPGA_SIG_LEN-1)));
+    for(l = 0; l < RP_SPECTR_WELCH_LENS; l++) {
+        int len = SPECTR_FPGA_SIG_LEN >> l;
+
+        rp_hann_window[l] = (float *)malloc(len * sizeof(float));
+        if(rp_hann_window[l] == NULL) {
+            fprintf(stderr, "rp_spectr_hann_create() can not allocate mem");
+            rp_spectr_hann_clean();
+            return -1;
+        }
+
+        for(i = 0; i < len; i++) {
+            rp_hann_window[l][i] = RP_SPECTR_HANN_AMP * 
+                (1 - cos(2*M_PI*i / (double)(len-1)));
+        }
     }
 
     return 0;
@@ -105,159 +128,344 @@ int rp_spectr_hann_init()
 
 int rp_spectr_hann_clean()
 {
-    if(rp_hann_window) {
-        free(rp_hann_window);
-        rp_hann_window = NULL;
+    for(int l = 0; l < RP_SPECTR_WELCH_LENS; l++) {
+        if(rp_hann_window[l]) {
+            free(rp_hann_window[l]);
+            rp_hann_window[l] = NULL;
+        }
     }
     return 0;
 }
 
-
-int rp_spectr_hann_filter(double *cha_in, double *chb_in,
-                          double **cha_out, double **chb_out)
+int rp_spectr_fft_init()
 {
-    int i;
-    double *cha_o = *cha_out;
-    double *chb_o = *chb_out;
+    int l, failed = 0;
 
-    if(!cha_in || !chb_in || !*cha_out || !*chb_out)
-        return -1;
-    for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
-        cha_o[i] = cha_in[i] * rp_hann_window[i];
-        chb_o[i] = chb_in[i] * rp_hann_window[i];
-    }
+    rp_spectr_fft_clean();
 
-    return 0;
-}
+    rp_spectr_fft_in =
+        (float *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(float));
+    rp_kiss_fft_out = 
+        (kiss_fft_cpx *)malloc((c_dsp_sig_len + 1) * sizeof(kiss_fft_cpx));
 
-int rp_spectr_fft_init()
-{
-    if(rp_kiss_fft_out1 || rp_kiss_fft_out2 || rp_kiss_fft_cfg) {
-        rp_spectr_fft_clean();
+    for(l = 0; l < RP_SPECTR_WELCH_LENS; l++) {
+        rp_kiss_fft_cfg[l] = kiss_fftr_alloc(SPECTR_FPGA_SIG_LEN >> l, 0, NULL, NULL);
+        failed |= !rp_kiss_fft_cfg[l];
     }
 
-    rp_kiss_fft_out1 = 
-        (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
-    rp_kiss_fft_out2 =
-        (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
+    rp_spectr_avg_acc = (float *)malloc(2 * SPECTR_OUT_SIG_LEN * sizeof(float));
+    rp_spectr_max_acc = (float *)malloc(2 * SPECTR_OUT_SIG_LEN * sizeof(float));
+    rp_spectr_min_acc = (float *)malloc(2 * SPECTR_OUT_SIG_LEN * sizeof(float));
 
-    rp_kiss_fft_cfg = kiss_fftr_alloc(SPECTR_FPGA_SIG_LEN, 0, NULL, NULL);
+    if(!rp_spectr_fft_in || !rp_kiss_fft_out || failed ||
+       !rp_spectr_avg_acc || !rp_spectr_max_acc || !rp_spectr_min_acc) {
+        fprintf(stderr, "rp_spectr_fft_init() can not allocate mem\n");
+        rp_spectr_fft_clean();
+        return -1;
+    }
 
+    /* holds read before the first spectrum show the floor */
+    for(l = 0; l < 2 * SPECTR_OUT_SIG_LEN; l++)
+        rp_spectr_max_acc[l] = rp_spectr_min_acc[l] = -120;
+    rp_spectr_avg_reset();
     return 0;
 }
 
 int rp_spectr_fft_clean()
 {
     kiss_fft_cleanup();
-    if(rp_kiss_fft_out1) {
-        free(rp_kiss_fft_out1);
-        rp_kiss_fft_out1 = NULL;
+    if(rp_spectr_fft_in) {
+        free(rp_spectr_fft_in);
+        rp_spectr_fft_in = NULL;
     }
-    if(rp_kiss_fft_out2) {
-        free(rp_kiss_fft_out2);
-        rp_kiss_fft_out2 = NULL;
+    if(rp_kiss_fft_out) {
+        free(rp_kiss_fft_out);
+        rp_kiss_fft_out = NULL;
     }
-    if(rp_kiss_fft_cfg) {
-        free(rp_kiss_fft_cfg);
-        rp_kiss_fft_cfg = NULL;
+    for(int l = 0; l < RP_SPECTR_WELCH_LENS; l++) {
+        if(rp_kiss_fft_cfg[l]) {
+            free(rp_kiss_fft_cfg[l]);
+            rp_kiss_fft_cfg[l] = NULL;
+        }
     }
+    free(rp_spectr_avg_acc);
+    free(rp_spectr_max_acc);
+    free(rp_spectr_min_acc);
+    rp_spectr_avg_acc = rp_spectr_max_acc = rp_spectr_min_acc = NULL;
     return 0;
 }
 
-int rp_spectr_fft(double *cha_in, double *chb_in, 
-                  double **cha_out, double **chb_out)
+int rp_spectr_set_welch(int segments)
 {
-    double *cha_o = *cha_out;
-    double *chb_o = *chb_out;
-    int i;
-    if(!cha_in || !chb_in || !*cha_out || !*chb_out)
+    if((segments < 1) || (segments > RP_SPECTR_WELCH_MAX_SEG) ||
+       (segments & (segments + 1))) {
+        fprintf(stderr, "rp_spectr_set_welch() wrong number of segments\n");
         return -1;
+    }
+
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    rp_spectr_welch_seg = segments;
+    rp_spectr_avg_restart = 1;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
+    return 0;
+}
+
+int rp_spectr_get_welch(void)
+{
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    int segments = rp_spectr_welch_seg;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
+    return segments;
+}
 
-    if(!rp_kiss_fft_out1 || !rp_kiss_fft_out2 || !rp_kiss_fft_cfg) {
-        fprintf(stderr, "rp_spect_fft not initialized");
+int rp_spectr_set_avg(rp_spectr_avg_mode_t mode, int count)
+{
+    if(((mode != rp_spectr_avg_linear) && (mode != rp_spectr_avg_exp)) ||
+       (count < 1) || (count > RP_SPECTR_AVG_MAX_CNT)) {
+        fprintf(stderr, "rp_spectr_set_avg() wrong parameters\n");
         return -1;
     }
 
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)cha_in, rp_kiss_fft_out1);
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)chb_in, rp_kiss_fft_out2);
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    rp_spectr_avg_mode = mode;
+    rp_spectr_avg_cnt = count;
+    rp_spectr_avg_restart = 1;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
+    return 0;
+}
 
-    for(i = 0; i < c_dsp_sig_len; i++) {                     // FFT limited to fs/2, specter of amplitudes
-        cha_o[i] = sqrt(pow(rp_kiss_fft_out1[i].r, 2) + 
-                        pow(rp_kiss_fft_out1[i].i, 2));
-        chb_o[i] = sqrt(pow(rp_kiss_fft_out2[i].r, 2) + 
-                        pow(rp_kiss_fft_out2[i].i, 2));
+int rp_spectr_set_avg_mode(rp_spectr_avg_mode_t mode)
+{
+    if((mode != rp_spectr_avg_linear) && (mode != rp_spectr_avg_exp)) {
+        fprintf(stderr, "rp_spectr_set_avg_mode() wrong mode\n");
+        return -1;
     }
+
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    rp_spectr_avg_mode = mode;
+    rp_spectr_avg_restart = 1;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
     return 0;
 }
 
-int rp_spectr_decimate(double *cha_in, double *chb_in, 
-                       float **cha_out, float **chb_out,
-                       int in_len, int out_len)
+int rp_spectr_set_avg_count(int count)
 {
-    int step;
-    int i, j;
-    float *cha_o = *cha_out;
-    float *chb_o = *chb_out;
-
-    if(!cha_in || !chb_in || !*cha_out || !*chb_out)
+    if((count < 1) || (count > RP_SPECTR_AVG_MAX_CNT)) {
+        fprintf(stderr, "rp_spectr_set_avg_count() wrong count\n");
         return -1;
+    }
 
-    step = (int)round((float)in_len / (float)out_len);
-    if(step < 1)
-        step = 1;
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    rp_spectr_avg_cnt = count;
+    rp_spectr_avg_restart = 1;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
+    return 0;
+}
 
-    for(i = 0, j = 0; i < out_len; i++, j+=step) {
-        int k=j;
+int rp_spectr_get_avg(rp_spectr_avg_mode_t *mode, int *count)
+{
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    *mode = rp_spectr_avg_mode;
+    *count = rp_spectr_avg_cnt;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
+    return 0;
+}
 
-        if(j >= in_len) {
-            fprintf(stderr, "rp_spectr_decimate() index too high\n");
-            return -1;
+int rp_spectr_avg_reset(void)
+{
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    rp_spectr_avg_restart = 1;
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
+    return 0;
+}
+
+/* Signed, windowed float samples of a run of raw counts (14 bit two's complement) */
+static void spectr_load(const int *raw, const float *win, float *out, int len)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const int32x4_t half = vdupq_n_s32(1 << 13);
+    const int32x4_t full = vdupq_n_s32(1 << 14);
+    for(; i + 4 <= len; i += 4) {
+        int32x4_t v = vld1q_s32(&raw[i]);
+        uint32x4_t neg = vcgtq_s32(v, half);
+        v = vsubq_s32(v, vandq_s32(vreinterpretq_s32_u32(neg), full));
+        vst1q_f32(&out[i], vmulq_f32(vcvtq_f32_s32(v), vld1q_f32(&win[i])));
+    }
+#endif
+
+    for(; i < len; i++) {
+        int v = raw[i];
+        if(v > (1<<13))
+            v -= (1<<14);
+        out[i] = (float)v * win[i];
+    }
+}
+
+/* One channel through the FFT: the ring of raw counts is read from start on in
+ * segments of SPECTR_FPGA_SIG_LEN >> len_idx samples, each one half a segment after
+ * the previous. Power of the bins of every output point, times scale and averaged
+ * over the segments, goes to out. The amplitudes of c_dsp_sig_len bins go to amp
+ * unless it is NULL; shorter segments have fewer bins, each is repeated over the
+ * full length bins it covers and scaled to the full length amplitude. */
+static void spectr_transform(const int *raw, int start, int len_idx, int segments,
+                             double *amp, float *out, float scale)
+{
+    const kiss_fft_cpx *c = rp_kiss_fft_out;
+    const float *win = rp_hann_window[len_idx];
+    const int len  = SPECTR_FPGA_SIG_LEN >> len_idx;
+    const int step = SPECTR_DEC_STEP >> len_idx;
+    const int ratio = 1 << len_idx;
+    /* |X|^2 grows with the square of the length */
+    float seg_scale = scale * (float)(ratio * ratio) / (float)segments;
+    int i, j, s;
+
+    for(s = 0; s < segments; s++) {
+        /* ring read in two contiguous runs, the window index continues across the wrap */
+        int pos = (start + s * (len >> 1)) & (SPECTR_FPGA_SIG_LEN - 1);
+        int run = SPECTR_FPGA_SIG_LEN - pos;
+        if(run > len)
+            run = len;
+        spectr_load(&raw[pos], win, rp_spectr_fft_in, run);
+        spectr_load(raw, &win[run], &rp_spectr_fft_in[run], len - run);
+
+        kiss_fftr(rp_kiss_fft_cfg[len_idx], rp_spectr_fft_in, rp_kiss_fft_out);
+
+        if(amp) {
+            for(i = 0; i < (len >> 1); i++) {
+                float p = c[i].r * c[i].r + c[i].i * c[i].i;
+                amp[i] = s ? amp[i] + p : p;
+            }
         }
-        cha_o[i] = 0;
-        chb_o[i] = 0;
-	
-	/* Conversion factor from ADC counts to Volts */
-    	double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
-	
-        for(k=j; k < j+step; k++) {
-	
-	/* Conversion to power (Watts) */  
-        double cha_p = pow(cha_in[k] * c2v, 2) / c_imp /
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2; // x 2 for unilateral spectral density representation
-        double chb_p = pow(chb_in[k] * c2v, 2) / c_imp /                   // c_imp = 50 Ohms, is the transmission line impdeance   
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2;
-	  
-	  
-            cha_o[i] += (float)cha_p;  // Summing the power expressed in Watts associated to each FFT bin
-            chb_o[i] += (float)chb_p;
+
+        for(i = 0, j = 0; i < SPECTR_OUT_SIG_LEN; i++, j += step) {
+            float p = 0;
+            int k = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+            if(step >= 4) {
+                float32x4_t acc = vdupq_n_f32(0);
+                for(; k + 4 <= step; k += 4) {
+                    float32x4x2_t v = vld2q_f32((const float *)&c[j + k]);
+                    acc = vmlaq_f32(acc, v.val[0], v.val[0]);
+                    acc = vmlaq_f32(acc, v.val[1], v.val[1]);
+                }
+                float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+                p = vget_lane_f32(vpadd_f32(sum, sum), 0);
+            }
+#endif
+            for(; k < step; k++)
+                p += c[j + k].r * c[j + k].r + c[j + k].i * c[j + k].i;
+            out[i] = s ? out[i] + p * seg_scale : p * seg_scale;
         }
     }
 
-    return 0;
+    /* downwards, so a bin is spread before its slot is overwritten */
+    if(amp) {
+        for(i = c_dsp_sig_len - 1; i >= 0; i--)
+            amp[i] = sqrt(amp[i / ratio] / segments) * ratio;
+    }
+}
+
+/* Adds a spectrum in linear power to the average with weight w and returns the
+ * average in place of it */
+static void spectr_average(float *pwr, float *acc, float w)
+{
+    int i;
+
+    if(w >= 1) {
+        memcpy(acc, pwr, SPECTR_OUT_SIG_LEN * sizeof(float));
+        return;
+    }
+    for(i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
+        acc[i] += (pwr[i] - acc[i]) * w;
+        pwr[i] = acc[i];
+    }
 }
 
-int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
-                         float **cha_out, float **chb_out,
-                         float *peak_power_cha, float *peak_freq_cha,
-                         float *peak_power_chb, float *peak_freq_chb,
-                         float freq_range)
+static void spectr_hold(const float *db, float *max, float *min, int restart)
 {
     int i;
-    float *cha_o = *cha_out;
-    float *chb_o = *chb_out;
-    double max_pw_cha = -1e5;
-    double max_pw_chb = -1e5;
+
+    if(restart) {
+        memcpy(max, db, SPECTR_OUT_SIG_LEN * sizeof(float));
+        memcpy(min, db, SPECTR_OUT_SIG_LEN * sizeof(float));
+        return;
+    }
+    for(i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
+        max[i] = (db[i] > max[i]) ? db[i] : max[i];
+        min[i] = (db[i] < min[i]) ? db[i] : min[i];
+    }
+}
+
+/* Converts power in mW to dBm in place, with the DC span suppressed, and returns the
+ * peak power summed over the bins around it and the index of the peak */
+static void spectr_to_dBm(float *pwr, float *peak_power, int *peak_idx)
+{
+    /* Avoiding -Inf due to log10(0.0) */
+    const float c_min_pwr  = 1.0e-12; /* [mW] */
+    /* Issue #3369: Remove DC component */
+    const float c_dc_noise = 1.0e-8;  /* [mW], -80 dBm */
+    const int   c_dc_span  = 2;       /* [output samples] */
+    /* Power correction (summing contributions of contiguous bins) */
+    const int   c_pwr_int_cnts = 3;   /* Number of bins on the left and right side of the max */
+    float max_pw = -1;
+    float sum = 0;
+    int max_idx = 0;
+    int i;
+
+    for(i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
+        if(i < c_dc_span)
+            pwr[i] = c_dc_noise;
+        else if(!(pwr[i] > c_min_pwr))
+            pwr[i] = c_min_pwr;
+
+        /* Find peaks */
+        if(pwr[i] > max_pw) {
+            max_pw  = pwr[i];
+            max_idx = i;
+        }
+    }
+
+    for(i = max_idx - c_pwr_int_cnts; i <= max_idx + c_pwr_int_cnts; i++) {
+        if((i >= 0) && (i < SPECTR_OUT_SIG_LEN))
+            sum += pwr[i];
+    }
+
+    for(i = 0; i < SPECTR_OUT_SIG_LEN; i++)
+        pwr[i] = 10 * log10f(pwr[i]);  // mW -> dBm
+
+    *peak_power = (sum <= 1.0e-10) ? -200.0 : 10 * log10f(sum);
+    *peak_idx = max_idx;
+}
+
+int rp_spectr_process(const int *cha_raw, const int *chb_raw, int start,
+                      float *cha_out, float *chb_out,
+                      double *cha_amp, double *chb_amp,
+                      float *peak_power_cha, float *peak_freq_cha,
+                      float *peak_power_chb, float *peak_freq_chb,
+                      float freq_range)
+{
+    /* averaging state, kept between calls */
+    static int len_idx = 0, segments = 1, avg_cnt = 1, avg_n = 0;
+    static rp_spectr_avg_mode_t avg_mode = rp_spectr_avg_linear;
     int max_pw_idx_cha = 0;
     int max_pw_idx_chb = 0;
+    int restart = 0;
     float freq_smpl = spectr_get_fpga_smpl_freq() / 
         (float)spectr_fpga_cnv_freq_range_to_dec(freq_range);
 
     /* Divider to get to the right units - [MHz], [kHz] or [Hz] */
     float unit_div = 1e6;
 
-    if(!cha_in || !chb_in || !*cha_out || !*chb_out)
+    if(!cha_raw || !chb_raw || !cha_out || !chb_out)
         return -1;
 
+    if(!rp_hann_window[0] || !rp_kiss_fft_cfg[0] || !rp_spectr_avg_acc) {
+        fprintf(stderr, "rp_spectr_process() not initialized\n");
+        return -1;
+    }
+
     switch(spectr_fpga_cnv_freq_range_to_unit(freq_range)) {
     case 2:
         unit_div = 1e6;
@@ -269,98 +477,71 @@ int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
         unit_div = 1;
         break;
     default:
-        fprintf(stderr, "rp_spectr_prepare_freq_vector() wrong freq_range\n");
+        fprintf(stderr, "rp_spectr_process() wrong freq_range\n");
         return -1;
     }
 
-    for(i = 0; i < SPECTR_OUT_SIG_LEN; i++) {
+    /* Conversion factor from ADC counts to Volts */
+    double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
+    /* |X|^2 in counts to power in mW: c_imp = 50 Ohms is the transmission line
+     * impedance, x 2 for unilateral spectral density representation */
+    float scale = (float)(c2v * c2v / c_imp / (double)SPECTR_FPGA_SIG_LEN / 
+                          (double)SPECTR_FPGA_SIG_LEN * 2 * c_w2mw);
+
+    pthread_mutex_lock(&rp_spectr_avg_mutex);
+    if(rp_spectr_avg_restart) {
+        segments = rp_spectr_welch_seg;
+        for(len_idx = 0; (2 << len_idx) - 1 < segments; len_idx++)
+            ;
+        avg_mode = rp_spectr_avg_mode;
+        avg_cnt  = rp_spectr_avg_cnt;
+        avg_n    = 0;
+        restart  = 1;
+        rp_spectr_avg_restart = 0;
+    }
+    pthread_mutex_unlock(&rp_spectr_avg_mutex);
 
-        /* Conversion to power (Watts) */
-    	
-	    
-	double cha_p=cha_in[i];
-        double chb_p=chb_in[i];    
+    /* the linear average starts over once complete, the exponential one keeps
+     * weighting new spectra with 1/count */
+    if((avg_mode == rp_spectr_avg_linear) && (avg_n >= avg_cnt))
+        avg_n = 0;
+    if(avg_n < avg_cnt)
+        avg_n++;
 
-	
-	
-    
-	// Avoiding -Inf due to log10(0.0) 
-	
-	if (cha_p * c_w2mw > 1.0e-12 )	
-        cha_o[i] = 10 * log10(cha_p * c_w2mw);  // W -> mW -> dBm
-	else	
-	cha_o[i]=10 * log10(1.0e-12);  
-	
-	
-        if (chb_p * c_w2mw > 1.0e-12 )        	
-        chb_o[i] = 10 * log10(chb_p * c_w2mw);
-	else	
-	 chb_o[i]=10 * log10(1.0e-12);
-	
-
-	
-
-        /* Issue #3369: Remove DC component */
-        const float c_dc_noise = -80.0; /* [dBm] */
-        const int   c_dc_span  =  2;    /* [output samples] */
-        if (i < c_dc_span) {
-            cha_o[i] = c_dc_noise;
-            chb_o[i] = c_dc_noise;
-        }
+    spectr_transform(cha_raw, start, len_idx, segments, cha_amp, cha_out, scale);
+    spectr_transform(chb_raw, start, len_idx, segments, chb_amp, chb_out, scale);
 
-        /* Find peaks */
-        if(cha_o[i] > max_pw_cha) {
-            max_pw_cha     = cha_o[i];
-            max_pw_idx_cha = i;
-        }
-        if(chb_o[i] > max_pw_chb) {
-            max_pw_chb     = chb_o[i];
-            max_pw_idx_chb = i;
-        }
-    }
+    spectr_average(cha_out, rp_spectr_avg_acc, 1.0f / avg_n);
+    spectr_average(chb_out, &rp_spectr_avg_acc[SPECTR_OUT_SIG_LEN], 1.0f / avg_n);
+
+    spectr_to_dBm(cha_out, peak_power_cha, &max_pw_idx_cha);
+    spectr_to_dBm(chb_out, peak_power_chb, &max_pw_idx_chb);
+
+    spectr_hold(cha_out, rp_spectr_max_acc, rp_spectr_min_acc, restart);
+    spectr_hold(chb_out, &rp_spectr_max_acc[SPECTR_OUT_SIG_LEN],
+                &rp_spectr_min_acc[SPECTR_OUT_SIG_LEN], restart);
 
-	// Power correction (summing contributions of contiguous bins)
-	const int c_pwr_int_cnts=3; // Number of bins on the left and right side of the max
-	float cha_pwr=0;
-	float chb_pwr=0;
-	int ii;
-	int ixxa,ixxb;
-        for(ii = 0; ii < (c_pwr_int_cnts*2+1); ii++) {
-	  
-	  ixxa=max_pw_idx_cha+ii-c_pwr_int_cnts;
-	  ixxb=max_pw_idx_chb+ii-c_pwr_int_cnts;
-	  
-	if ((ixxa>=0) && (ixxa<SPECTR_OUT_SIG_LEN)) 
-	 {
-	   cha_pwr+=pow(10.0,cha_o[ixxa]/10.0);
-	 }
-	if ((ixxb>=0) && (ixxb<SPECTR_OUT_SIG_LEN)) 
-	 {
-	   chb_pwr+=pow(10.0,chb_o[ixxb]/10.0);
-	 }	 
-	
-	
-	}
-       
-       if (cha_pwr<=1.0e-10)
-        max_pw_cha  = -200.0;
-       else
-        max_pw_cha     = 10.0 * log10(cha_pwr);
-       
-       if (chb_pwr<=1.0e-10)
-	max_pw_chb  = -200.0;
-       else
-        max_pw_chb     = 10.0 * log10(chb_pwr);
-       
-
-       
-    *peak_power_cha = max_pw_cha;
     *peak_freq_cha = ((float)max_pw_idx_cha / (float)SPECTR_OUT_SIG_LEN * 
                       freq_smpl  / 2) / unit_div;
-    *peak_power_chb = max_pw_chb;
     *peak_freq_chb = ((float)max_pw_idx_chb / (float)SPECTR_OUT_SIG_LEN * 
                       freq_smpl / 2) / unit_div;
 
     return 0;
 }
 
+int rp_spectr_get_hold(float *cha_max, float *chb_max,
+                       float *cha_min, float *chb_min)
+{
+    const size_t len = SPECTR_OUT_SIG_LEN * sizeof(float);
+
+    if(!rp_spectr_max_acc || !rp_spectr_min_acc) {
+        fprintf(stderr, "rp_spectr_get_hold() not initialized\n");
+        return -1;
+    }
+
+    memcpy(cha_max, rp_spectr_max_acc, len);
+    memcpy(chb_max, &rp_spectr_max_acc[SPECTR_OUT_SIG_LEN], len);
+    memcpy(cha_min, rp_spectr_min_acc, len);
+    memcpy(chb_min, &rp_spectr_min_acc[SPECTR_OUT_SIG_LEN], len);
+    return 0;
+}
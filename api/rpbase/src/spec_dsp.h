@@ -30,37 +30,57 @@ int rp_spectr_prepare_freq_vector(float **freq_out, double f_s,
 int rp_spectr_hann_init();
 int rp_spectr_hann_clean();
 
-/* Input & Outputs of SPECTR_FPGA_SIG_LEN */
-int rp_spectr_hann_filter(double *cha_in, double *chb_in,
-                          double **cha_out, double **chb_out);
-
 int rp_spectr_fft_init();
 int rp_spectr_fft_clean();
 
-/* Inputs length: SPECTR_FPGA_SIG_LEN
- * Outputs length: floor(SPECTR_FPGA_SIG_LEN/2) 
- * Output is not complex number as usually is from the FFT but abs() value of the
- * calculation.
- */
-int rp_spectr_fft(double *cha_in, double *chb_in, 
-                  double **cha_out, double **chb_out);
+/* FFT bins summed into one output point (usually from internal 8k -> output 2k) */
+#define SPECTR_DEC_STEP (c_dsp_sig_len / SPECTR_OUT_SIG_LEN)
+
+/* Welch averaging - a capture is split in segments overlapping by 50%, each one
+ * windowed and transformed on its own. 1, 3 or 7 segments give segment lengths of
+ * SPECTR_FPGA_SIG_LEN, 1/2 and 1/4 of it, so the bins still add up to whole
+ * output points. */
+#define RP_SPECTR_WELCH_LENS    3
+#define RP_SPECTR_WELCH_MAX_SEG ((2 << (RP_SPECTR_WELCH_LENS - 1)) - 1)
 
+/* Averaging of successive spectra, in linear power */
+typedef enum rp_spectr_avg_mode_e {
+    rp_spectr_avg_linear = 0, /* equal weights, restarts after count spectra */
+    rp_spectr_avg_exp         /* weight 1/count once count spectra are in */
+} rp_spectr_avg_mode_t;
 
-/*
- * Decimation (usually from internal 8k -> output 2k)
-*/
-int rp_spectr_decimate(double *cha_in, double *chb_in,
-                       float **cha_out, float **chb_out,
-                       int in_len, int out_len);
+#define RP_SPECTR_AVG_MAX_CNT 1000
 
-/* Converts amplitude of the signal to Voltage (k_c2v - counts 2 voltage) and
- * to dBm (k_dBm) & convert to linear scale (20*log10())
- * Input & Outputs of length SPECTR_OUT_SIG_LEN (decimated length)
+/* Settings may be changed from any thread, they take effect with the next
+ * rp_spectr_process() and restart the average and the hold traces */
+int rp_spectr_set_welch(int segments);
+int rp_spectr_get_welch(void);
+int rp_spectr_set_avg(rp_spectr_avg_mode_t mode, int count);
+int rp_spectr_set_avg_mode(rp_spectr_avg_mode_t mode);
+int rp_spectr_set_avg_count(int count);
+int rp_spectr_get_avg(rp_spectr_avg_mode_t *mode, int *count);
+int rp_spectr_avg_reset(void);
+
+/* Spectra of both channels in one pass per channel, single precision.
+ * Inputs: raw ADC counts, rings of SPECTR_FPGA_SIG_LEN read from index start on
+ * (as the FPGA buffers from spectr_fpga_get_sig_ptr()). The Hann window is applied
+ * while the counts are loaded, the power of the FFT bins (r^2 + i^2) is averaged
+ * over the Welch segments, summed over the bins of an output point, averaged with
+ * the previous spectra and converted to dBm.
+ * Outputs: cha_out, chb_out of length SPECTR_OUT_SIG_LEN in dBm, peak power
+ * and frequency of each channel. cha_amp, chb_amp receive the FFT amplitudes
+ * (length c_dsp_sig_len) for the waterfall, NULL skips them.
  */
-int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
-                         float **cha_out, float **chb_out,
-                         float *peak_power_cha, float *peak_freq_cha,
-                         float *peak_power_chb, float *peak_freq_chb,
-                         float freq_range);
+int rp_spectr_process(const int *cha_raw, const int *chb_raw, int start,
+                      float *cha_out, float *chb_out,
+                      double *cha_amp, double *chb_amp,
+                      float *peak_power_cha, float *peak_freq_cha,
+                      float *peak_power_chb, float *peak_freq_chb,
+                      float freq_range);
+
+/* Max-hold and min-hold traces in dBm (length SPECTR_OUT_SIG_LEN) of the spectra
+ * rp_spectr_process() returned since the last restart */
+int rp_spectr_get_hold(float *cha_max, float *chb_max,
+                       float *cha_min, float *chb_min);
 
 #endif //__DSP_H
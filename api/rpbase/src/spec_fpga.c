@@ -23,6 +23,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+#include "common.h"
 #include "spec_fpga.h"
 
 /* internals */
@@ -31,9 +32,6 @@ spectr_fpga_reg_mem_t *g_spectr_fpga_reg_mem = NULL;
 uint32_t           *g_spectr_fpga_cha_mem = NULL;
 uint32_t           *g_spectr_fpga_chb_mem = NULL;
 
-/* The memory file descriptor used to mmap() the FPGA space */
-int             g_spectr_fpga_mem_fd = -1;
-
 /* constants */
 /* ADC format = s.13 */
 const int c_spectr_fpga_adc_bits = 14;
@@ -55,8 +53,8 @@ double __rp_rand()
 int __spectr_fpga_cleanup_mem(void)
 {
     if(g_spectr_fpga_reg_mem) {
-        if(munmap(g_spectr_fpga_reg_mem, SPECTR_FPGA_BASE_SIZE) < 0) {
-            fprintf(stderr, "munmap() failed: %s\n", strerror(errno));
+        if(cmn_Unmap(SPECTR_FPGA_BASE_SIZE, (void **) &g_spectr_fpga_reg_mem) != RP_OK) {
+            fprintf(stderr, "cmn_Unmap() failed\n");
             return -1;
         }
         g_spectr_fpga_reg_mem = NULL;
@@ -65,50 +63,28 @@ int __spectr_fpga_cleanup_mem(void)
         if(g_spectr_fpga_chb_mem)
             g_spectr_fpga_chb_mem = NULL;
     }
-    if(g_spectr_fpga_mem_fd >= 0) {
-        close(g_spectr_fpga_mem_fd);
-        g_spectr_fpga_mem_fd = -1;
-    }
 
     return 0;
 }
 
 static int get_hw_rev(hw_rev_t *hw_rev)
 {
-    void *page_ptr;
-    long page_addr, page_size = sysconf(_SC_PAGESIZE);
-    const long c_hk_fpga_base_addr = 0x40000000;
+    void *page_ptr = NULL;
     const long c_hk_fpga_base_size = 0x20;
-    int fd = -1;
-
-    fd = open("/dev/mem", O_RDONLY | O_SYNC);
-    if(fd < 0) {
-        fprintf(stderr, "open(/dev/mem) failed: %s\n", strerror(errno));
-        return -1;
-    }
-
-    page_addr = c_hk_fpga_base_addr & (~(page_size-1));
 
-    page_ptr = mmap(NULL, c_hk_fpga_base_size, PROT_READ,
-                          MAP_SHARED, fd, page_addr);
-
-    if((void *)page_ptr == MAP_FAILED) {
-        fprintf(stderr, "mmap() failed: %s\n", strerror(errno));
-        close(fd);
+    if(cmn_Map(c_hk_fpga_base_size, HK_FPGA_BASE_ADDR, &page_ptr) != RP_OK) {
+        fprintf(stderr, "cmn_Map() failed\n");
         return -1;
     }
 
     hk_fpga_reg_mem_t *hk = page_ptr;
     *hw_rev = hk->rev & HK_FPGA_HW_REV_MASK;
 
-    if(munmap(page_ptr, c_hk_fpga_base_size) < 0) {
-        fprintf(stderr, "munmap() failed: %s\n", strerror(errno));
-        close(fd);
+    if(cmn_Unmap(c_hk_fpga_base_size, &page_ptr) != RP_OK) {
+        fprintf(stderr, "cmn_Unmap() failed\n");
         return -1;
     }
 
-    close (fd);
-
     return 0;
 }
 
@@ -134,9 +110,6 @@ static int update_hw_spec_par(void)
 
 int spectr_fpga_init(void)
 {
-    void *page_ptr;
-    long page_addr, page_off, page_size = sysconf(_SC_PAGESIZE);
-
     /* update hw specific parmateres */
     if(update_hw_spec_par()<0){
     	return -1;
@@ -146,23 +119,12 @@ int spectr_fpga_init(void)
     if(__spectr_fpga_cleanup_mem() < 0)
         return -1;
 
-    g_spectr_fpga_mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if(g_spectr_fpga_mem_fd < 0) {
-        fprintf(stderr, "open(/dev/mem) failed: %s\n", strerror(errno));
-        return -1;
-    }
-
-    page_addr = SPECTR_FPGA_BASE_ADDR & (~(page_size-1));
-    page_off  = SPECTR_FPGA_BASE_ADDR - page_addr;
-
-    page_ptr = mmap(NULL, SPECTR_FPGA_BASE_SIZE, PROT_READ | PROT_WRITE,
-                          MAP_SHARED, g_spectr_fpga_mem_fd, page_addr);
-    if((void *)page_ptr == MAP_FAILED) {
-        fprintf(stderr, "mmap() failed: %s\n", strerror(errno));
-        __spectr_fpga_cleanup_mem();
+    /* Mapped through the common module so the selected register backend is used */
+    if(cmn_Map(SPECTR_FPGA_BASE_SIZE, SPECTR_FPGA_BASE_ADDR, (void **) &g_spectr_fpga_reg_mem) != RP_OK) {
+        fprintf(stderr, "cmn_Map() failed\n");
+        g_spectr_fpga_reg_mem = NULL;
         return -1;
     }
-    g_spectr_fpga_reg_mem = page_ptr + page_off;
     g_spectr_fpga_cha_mem = (uint32_t *)g_spectr_fpga_reg_mem + 
         (SPECTR_FPGA_CHA_OFFSET / sizeof(uint32_t));
     g_spectr_fpga_chb_mem = (uint32_t *)g_spectr_fpga_reg_mem + 
@@ -230,6 +192,9 @@ int spectr_fpga_update_params(int trig_imm, int trig_source, int trig_edge,
     g_spectr_fpga_reg_mem->chb_filt_pp = gain_hi_chb_filt_pp;
     g_spectr_fpga_reg_mem->chb_filt_kk = gain_hi_chb_filt_kk;
 
+    /* Registers were written through a separate mapping, refresh the library shadow copies */
+    cmn_ShadowReload();
+
     return 0;
 }
 
@@ -255,6 +220,7 @@ int spectr_fpga_set_trigger(uint32_t trig_source)
 int spectr_fpga_set_trigger_delay(uint32_t trig_delay)
 {
     g_spectr_fpga_reg_mem->trigger_delay = trig_delay;
+    cmn_ShadowReload();
     return 0;
 }
 
@@ -270,33 +236,26 @@ int spectr_fpga_get_sig_ptr(int **cha_signal, int **chb_signal)
     return 0;
 }
 
-int spectr_fpga_get_signal(double **cha_signal, double **chb_signal)
+int spectr_fpga_copy_signal(int *cha_signal, int *chb_signal)
 {
     int wr_ptr_trig;
     int in_idx, out_idx;
-    double *cha_o = *cha_signal;
-    double *chb_o = *chb_signal;
 
-    if(!cha_o || !chb_o) {
-        fprintf(stderr, "spectr_fpga_get_signal() not initialized\n");
+    if(!cha_signal || !chb_signal) {
+        fprintf(stderr, "spectr_fpga_copy_signal() not initialized\n");
         return -1;
     }
 
     spectr_fpga_get_wr_ptr(NULL, &wr_ptr_trig);
 
+    /* word reads only, the buffers are device memory */
     for(in_idx = wr_ptr_trig + 1, out_idx = 0; 
         out_idx < SPECTR_FPGA_SIG_LEN; in_idx++, out_idx++) {
         if(in_idx >= SPECTR_FPGA_SIG_LEN)
             in_idx = in_idx % SPECTR_FPGA_SIG_LEN;
 
-        cha_o[out_idx] = g_spectr_fpga_cha_mem[in_idx];
-        chb_o[out_idx] = g_spectr_fpga_chb_mem[in_idx];
-
-        // convert to signed
-        if(cha_o[out_idx] > (double)(1<<13))
-            cha_o[out_idx] -= (double)(1<<14);
-        if(chb_o[out_idx] > (double)(1<<13))
-            chb_o[out_idx] -= (double)(1<<14);
+        cha_signal[out_idx] = g_spectr_fpga_cha_mem[in_idx];
+        chb_signal[out_idx] = g_spectr_fpga_chb_mem[in_idx];
     }
     return 0;
 }
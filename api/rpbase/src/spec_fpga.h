@@ -203,8 +203,9 @@ int spectr_fpga_triggered(void);
 /* Returns pointer to the ChA and ChB signals (of length SPECTR_FPGA_SIG_LEN) */
 int spectr_fpga_get_sig_ptr(int **cha_signal, int **chb_signal);
 
-/* Copies the last acquisition (trig wr. ptr -> curr. wr. ptr) */
-int spectr_fpga_get_signal(double **cha_signal, double **chb_signal);
+/* Copies the last acquisition (trig wr. ptr -> curr. wr. ptr) as raw counts,
+ * oldest sample first (outputs of length SPECTR_FPGA_SIG_LEN) */
+int spectr_fpga_copy_signal(int *cha_signal, int *chb_signal);
 
 /* Returns signal pointers from the FPGA */
 int spectr_fpga_get_wr_ptr(int *wr_ptr_curr, int *wr_ptr_trig);
@@ -233,7 +234,6 @@ float spectr_fpga_cnv_cnt_to_v(int cnts);
 
 /* debugging - will be removed */
 extern spectr_fpga_reg_mem_t *g_spectr_fpga_reg_mem;
-extern                int  g_spectr_fpga_mem_fd;
 int __spectr_fpga_cleanup_mem(void);
 
 #endif /* __FPGA_H*/
@@ -44,13 +44,8 @@ void *rp_spectr_worker_thread(void *args);
 /* Signals directly pointing at the FPGA mem space */
 int                  *rp_fpga_cha_signal, *rp_fpga_chb_signal;
 
-/* Internal structures */
-/* Size = SPECTR_FPGA_SIG_LEN  */
-double *rp_cha_in = NULL;
-double *rp_chb_in = NULL;
-
 /* DSP structures */
-/* size = c_dsp_sig_len */
+/* FFT amplitudes for the waterfall, size = c_dsp_sig_len */
 double *rp_cha_fft = NULL;
 double *rp_chb_fft = NULL;
 
@@ -90,11 +85,9 @@ int rp_spectr_worker_init(void)
         return -1;
     }
 
-    rp_cha_in = (double *)malloc(sizeof(double) * SPECTR_FPGA_SIG_LEN);
-    rp_chb_in = (double *)malloc(sizeof(double) * SPECTR_FPGA_SIG_LEN);
     rp_cha_fft = (double *)malloc(sizeof(double) * c_dsp_sig_len);
     rp_chb_fft = (double *)malloc(sizeof(double) * c_dsp_sig_len);
-    if(!rp_cha_in || !rp_chb_in || !rp_cha_fft || !rp_chb_fft) {
+    if(!rp_cha_fft || !rp_chb_fft) {
         rp_spectr_worker_clean();
         return -1;
     }
@@ -170,14 +163,6 @@ int rp_spectr_worker_clean(void)
         free(jpg_fname_chb);
         jpg_fname_chb = NULL;
     }
-    if(rp_cha_in) {
-        free(rp_cha_in);
-        rp_cha_in = NULL;
-    }
-    if(rp_chb_in) {
-        free(rp_chb_in);
-        rp_chb_in = NULL;
-    }
     if(rp_cha_fft) {
         free(rp_cha_fft);
         rp_cha_fft = NULL;
@@ -436,32 +421,23 @@ void *rp_spectr_worker_thread(void *args)
             continue;
         }
 
-        /* retrieve data and process it*/
-        spectr_fpga_get_signal(&rp_cha_in, &rp_chb_in);
+        /* process the data straight from the FPGA buffers, the oldest sample
+         * follows the trigger write pointer */
+        int wr_ptr_trig;
+        spectr_fpga_get_wr_ptr(NULL, &wr_ptr_trig);
 
         rp_spectr_prepare_freq_vector(&rp_tmp_signals[0], 
                                       c_spectr_fpga_smpl_freq,
                                       curr_params[FREQ_RANGE_PARAM].value);
 
-        rp_spectr_hann_filter(&rp_cha_in[0], &rp_chb_in[0],
-                              &rp_cha_in, &rp_chb_in);
-        
-        rp_spectr_fft(&rp_cha_in[0], &rp_chb_in[0], 
-                      (double **)&rp_cha_fft, (double **)&rp_chb_fft);
-        
-        rp_spectr_decimate(&rp_cha_fft[0], &rp_chb_fft[0], 
-                           (float **)&rp_tmp_signals[1], 
-                           (float **)&rp_tmp_signals[2],
-                           c_dsp_sig_len, SPECTR_OUT_SIG_LEN);
-        
-        rp_spectr_cnv_to_dBm(&rp_tmp_signals[1][0], &rp_tmp_signals[2][0], 
-                             (float **)&rp_tmp_signals[1], 
-                             (float **)&rp_tmp_signals[2], 
-                             &tmp_result.peak_pw_cha, 
-                             &tmp_result.peak_pw_freq_cha,
-                             &tmp_result.peak_pw_chb, 
-                             &tmp_result.peak_pw_freq_chb,
-                             curr_params[FREQ_RANGE_PARAM].value);
+        rp_spectr_process(rp_fpga_cha_signal, rp_fpga_chb_signal, wr_ptr_trig + 1,
+                          rp_tmp_signals[1], rp_tmp_signals[2],
+                          rp_cha_fft, rp_chb_fft,
+                          &tmp_result.peak_pw_cha, 
+                          &tmp_result.peak_pw_freq_cha,
+                          &tmp_result.peak_pw_chb, 
+                          &tmp_result.peak_pw_freq_chb,
+                          curr_params[FREQ_RANGE_PARAM].value);
 
         /* Calculate the map used for Waterfall diagram  */
         rp_spectr_wf_calc(&rp_cha_fft[0], &rp_chb_fft[0]);
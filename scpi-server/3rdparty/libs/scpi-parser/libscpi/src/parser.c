@@ -559,6 +559,50 @@ size_t SCPI_ResultBufferInt16(scpi_t * context, const int16_t *data, uint32_t si
     }
 }
 
+size_t resultBufferUInt8Bin(scpi_t * context, const uint8_t *data, uint32_t size) {
+    size_t result = 0;
+
+    result += writeBinHeader(context, size, sizeof(uint8_t));
+
+    if (result == 0) {
+        return result;
+    }
+
+    result += writeData(context, (const char*)data, size);
+    context->output_binary_count++;
+    return result;
+}
+
+size_t resultBufferUInt8Ascii(scpi_t * context, const uint8_t *data, uint32_t size) {
+    size_t result = 0;
+    result += writeDelimiter(context);
+    result += writeData(context, "{", 1);
+
+    uint32_t i;
+    size_t len;
+    char buffer[12];
+    for (i = 0; i < size-1; i++) {
+        len = longToStr(data[i], buffer, sizeof (buffer));
+        result += writeData(context, buffer, len);
+        result += writeData(context, ",", 1);
+    }
+    len = longToStr(data[i], buffer, sizeof (buffer));
+    result += writeData(context, buffer, len);
+    result += writeData(context, "}", 1);
+    context->output_count++;
+    return result;
+}
+
+size_t SCPI_ResultBufferUInt8(scpi_t * context, const uint8_t *data, uint32_t size) {
+
+    if (context->binary_output == true) {
+        return resultBufferUInt8Bin(context, data, size);
+    }
+    else {
+        return resultBufferUInt8Ascii(context, data, size);
+    }
+}
+
 size_t resultBufferFloatBin(scpi_t * context, const float *data, uint32_t size) {
     size_t result = 0;
 
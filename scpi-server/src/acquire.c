@@ -22,6 +22,21 @@
 
 rp_scpi_acq_unit_t unit     = RP_SCPI_VOLTS;        // default value
 
+/* ADC buffer size is 16 k samples */
+#define ADC_BUFFER_SIZE     (16 * 1024)
+
+/* Per trigger timeout of averaged acquisition, keeps the server responsive without trigger */
+#define AVG_TRIG_TIMEOUT_MS 1000
+
+/* Output of the data queries, sized for the whole ADC buffer */
+static float    data_v[ADC_BUFFER_SIZE];
+static int16_t  data_raw[ADC_BUFFER_SIZE];
+
+/* Variance of the last averaged acquisition, per channel */
+static float    avg_var[2][ADC_BUFFER_SIZE];
+static uint32_t avg_var_size[2] = { 0, 0 };
+static uint32_t avg_frames[2] = { 0, 0 };
+
 scpi_result_t RP_AcqSetDataFormat(scpi_t *context) {
     const char * param;
     size_t param_len;
@@ -91,21 +106,24 @@ scpi_result_t RP_AcqReset(scpi_t *context) {
 scpi_result_t RP_AcqSetDecimation(scpi_t *context) {
     int value;
 
-    // read first parameter DECIMATION (1,8,64,1024,8192,65536)
+    // read first parameter DECIMATION (1,8,64,1024,8192,65536 or any other multiple of 8)
     if (!SCPI_ParamInt(context, &value, false)) {
         syslog(LOG_ERR, "*ACQ:DEC is missing first parameter.");
         return SCPI_RES_ERR;
     }
-
-    // Convert decimation to rp_acq_decimation_t
-    rp_acq_decimation_t decimation;
-    if (getRpDecimation(value, &decimation)) {
+    if (value <= 0) {
         syslog(LOG_ERR, "*ACQ:DEC parameter decimation is invalid.");
         return SCPI_RES_ERR;
     }
 
-    // Now set the decimation
-    int result = rp_AcqSetDecimation(decimation);
+    // Predefined decimations set the FPGA only, others are split into FPGA and software decimation
+    int result;
+    rp_acq_decimation_t decimation;
+    if (getRpDecimation(value, &decimation) == RP_OK) {
+        result = rp_AcqSetDecimation(decimation);
+    } else {
+        result = rp_AcqSetDecimationRatio((uint32_t) value);
+    }
 
     if (RP_OK != result) {
         syslog(LOG_ERR, "*ACQ:DEC Failed to set decimation: %s", rp_GetError(result));
@@ -118,22 +136,15 @@ scpi_result_t RP_AcqSetDecimation(scpi_t *context) {
 }
 
 scpi_result_t RP_AcqGetDecimation(scpi_t *context) {
-    // Get decimation
-    rp_acq_decimation_t decimation;
-    int result = rp_AcqGetDecimation(&decimation);
+    // Get total decimation, FPGA times software decimation
+    uint32_t value;
+    int result = rp_AcqGetDecimationRatio(&value);
 
     if (RP_OK != result) {
         syslog(LOG_ERR, "*ACQ:DEC? Failed to get decimation: %s", rp_GetError(result));
         return SCPI_RES_ERR;
     }
 
-    // Convert decimation to int
-    int value;
-    if (RP_OK != getRpDecimationInt(decimation, &value)) {
-        syslog(LOG_ERR, "*ACQ:DEC? Failed to convert decimation to integer: %s", rp_GetError(result));
-        return SCPI_RES_ERR;
-    }
-
     // Return back result
     SCPI_ResultDouble(context, value);
 
@@ -557,6 +568,30 @@ scpi_result_t RP_AcqGetChanel2OldestDataAll(scpi_t *context) {
     return RP_AcqGetOldestDataAll(RP_CH_2, context);
 }
 
+scpi_result_t RP_AcqGetChanel1AvgData(scpi_t *context) {
+    return RP_AcqGetAvgData(RP_CH_1, context);
+}
+
+scpi_result_t RP_AcqGetChanel2AvgData(scpi_t *context) {
+    return RP_AcqGetAvgData(RP_CH_2, context);
+}
+
+scpi_result_t RP_AcqGetChanel1AvgCount(scpi_t *context) {
+    return RP_AcqGetAvgCount(RP_CH_1, context);
+}
+
+scpi_result_t RP_AcqGetChanel2AvgCount(scpi_t *context) {
+    return RP_AcqGetAvgCount(RP_CH_2, context);
+}
+
+scpi_result_t RP_AcqGetChanel1AvgVariance(scpi_t *context) {
+    return RP_AcqGetAvgVariance(RP_CH_1, context);
+}
+
+scpi_result_t RP_AcqGetChanel2AvgVariance(scpi_t *context) {
+    return RP_AcqGetAvgVariance(RP_CH_2, context);
+}
+
 scpi_result_t RP_AcqGetBufferSize(scpi_t *context) {
     uint32_t size;
     int result = rp_AcqGetBufSize(&size);
@@ -634,10 +669,13 @@ scpi_result_t RP_AcqGetLatestData(rp_channel_t channel, scpi_t *context) {
         syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:LAT:N? is missing first parameter.");
         return SCPI_RES_ERR;
     }
+    if (size > ADC_BUFFER_SIZE) {
+        size = ADC_BUFFER_SIZE;
+    }
 
     int result;
     if (unit == RP_SCPI_VOLTS) {
-        float buffer[size];
+        float *buffer = data_v;
         result = rp_AcqGetLatestDataV(channel, &size, buffer);
 
         if (RP_OK != result) {
@@ -649,7 +687,7 @@ scpi_result_t RP_AcqGetLatestData(rp_channel_t channel, scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
     }
     else {
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetLatestDataRaw(channel, &size, buffer);
 
         if (RP_OK != result) {
@@ -680,10 +718,13 @@ scpi_result_t RP_AcqGetData(rp_channel_t channel, scpi_t *context) {
         syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? is missing second parameter.");
         return SCPI_RES_ERR;
     }
+    if (size > ADC_BUFFER_SIZE) {
+        size = ADC_BUFFER_SIZE;
+    }
 
     int result;
     if (unit == RP_SCPI_VOLTS) {
-        float buffer[size];
+        float *buffer = data_v;
         result = rp_AcqGetDataV(channel, start, &size, buffer);
 
         if (RP_OK != result) {
@@ -695,7 +736,7 @@ scpi_result_t RP_AcqGetData(rp_channel_t channel, scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
     }
     else {
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetDataRaw(channel, start, &size, buffer);
 
         if (RP_OK != result) {
@@ -719,10 +760,13 @@ scpi_result_t RP_AcqGetOldestData(rp_channel_t channel, scpi_t *context) {
         syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:OLD:N? is missing first parameter.");
         return SCPI_RES_ERR;
     }
+    if (size > ADC_BUFFER_SIZE) {
+        size = ADC_BUFFER_SIZE;
+    }
 
     int result;
     if (unit == RP_SCPI_VOLTS) {
-        float buffer[size];
+        float *buffer = data_v;
         result = rp_AcqGetOldestDataV(channel, &size, buffer);
 
         if (RP_OK != result) {
@@ -734,7 +778,7 @@ scpi_result_t RP_AcqGetOldestData(rp_channel_t channel, scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
     }
     else {
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
 
         if (RP_OK != result) {
@@ -770,7 +814,7 @@ scpi_result_t RP_AcqGetDataPos(rp_channel_t channel, scpi_t *context) {
     rp_AcqGetBufSize(&size);
 
     if (unit == RP_SCPI_VOLTS) {
-        float buffer[size];
+        float *buffer = data_v;
         result = rp_AcqGetDataPosV(channel, start, end, buffer, &size);
 
         if (RP_OK != result) {
@@ -782,7 +826,7 @@ scpi_result_t RP_AcqGetDataPos(rp_channel_t channel, scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
     }
     else {
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetDataPosRaw(channel, start, end, buffer, &size);
 
         if (RP_OK != result) {
@@ -809,7 +853,7 @@ scpi_result_t RP_AcqGetOldestDataAll(rp_channel_t channel, scpi_t *context) {
     }
 
     if (unit == RP_SCPI_VOLTS) {
-        float buffer[size];
+        float *buffer = data_v;
         result = rp_AcqGetOldestDataV(channel, &size, buffer);
 
         if (RP_OK != result) {
@@ -821,7 +865,7 @@ scpi_result_t RP_AcqGetOldestDataAll(rp_channel_t channel, scpi_t *context) {
         SCPI_ResultBufferFloat(context, buffer, size);
     }
     else {
-        int16_t buffer[size];
+        int16_t *buffer = data_raw;
         result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
 
         if (RP_OK != result) {
@@ -837,3 +881,80 @@ scpi_result_t RP_AcqGetOldestDataAll(rp_channel_t channel, scpi_t *context) {
 
     return SCPI_RES_OK;
 }
+
+scpi_result_t RP_AcqGetAvgData(rp_channel_t channel, scpi_t *context) {
+    uint32_t frames, size, pre_trigger;
+    // read first parameter FRAMES
+    if (!SCPI_ParamUInt(context, &frames, true)) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG? is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    // read second parameter SIZE
+    if (!SCPI_ParamUInt(context, &size, true)) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG? is missing second parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    // read third parameter PRE TRIGGER
+    if (!SCPI_ParamUInt(context, &pre_trigger, true)) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG? is missing third parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    if (frames == 0) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG? parameter frames is invalid.");
+        return SCPI_RES_ERR;
+    }
+
+    if (size == 0 || size > ADC_BUFFER_SIZE) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG? parameter size is invalid.");
+        return SCPI_RES_ERR;
+    }
+
+    float *buffer = data_v;
+    float *var = avg_var[channel];
+    avg_var_size[channel] = 0;
+    avg_frames[channel] = 0;
+
+    int result = rp_AcqAverageFrames(&frames, size, pre_trigger,
+                                     channel == RP_CH_1 ? buffer : NULL, channel == RP_CH_2 ? buffer : NULL,
+                                     channel == RP_CH_1 ? var : NULL, channel == RP_CH_2 ? var : NULL,
+                                     AVG_TRIG_TIMEOUT_MS);
+
+    // on a trigger timeout the frames captured so far are averaged
+    if (RP_OK != result && (RP_ETMO != result || frames == 0)) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG? Failed to average data: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    avg_var_size[channel] = size;
+    avg_frames[channel] = frames;
+
+    // Return back result
+    SCPI_ResultBufferFloat(context, buffer, size);
+
+    syslog(LOG_INFO, "*ACQ:SOUR<n>:DATA:AVG? Successfully returned average of %u frames.", frames);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqGetAvgCount(rp_channel_t channel, scpi_t *context) {
+    SCPI_ResultUInt(context, avg_frames[channel]);
+
+    syslog(LOG_INFO, "*ACQ:SOUR<n>:DATA:AVG:COUNT? Successfully returned number of averaged frames.");
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqGetAvgVariance(rp_channel_t channel, scpi_t *context) {
+    if (avg_var_size[channel] == 0) {
+        syslog(LOG_ERR, "*ACQ:SOUR<n>:DATA:AVG:VAR? No averaged data.");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBufferFloat(context, avg_var[channel], avg_var_size[channel]);
+
+    syslog(LOG_INFO, "*ACQ:SOUR<n>:DATA:AVG:VAR? Successfully returned variance.");
+
+    return SCPI_RES_OK;
+}
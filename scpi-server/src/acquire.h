@@ -62,6 +62,12 @@ scpi_result_t RP_AcqGetChanel1OldestData(scpi_t * context);
 scpi_result_t RP_AcqGetChanel2OldestData(scpi_t * context);
 scpi_result_t RP_AcqGetChanel1LatestData(scpi_t * context);
 scpi_result_t RP_AcqGetChanel2LatestData(scpi_t * context);
+scpi_result_t RP_AcqGetChanel1AvgData(scpi_t * context);
+scpi_result_t RP_AcqGetChanel2AvgData(scpi_t * context);
+scpi_result_t RP_AcqGetChanel1AvgCount(scpi_t * context);
+scpi_result_t RP_AcqGetChanel2AvgCount(scpi_t * context);
+scpi_result_t RP_AcqGetChanel1AvgVariance(scpi_t * context);
+scpi_result_t RP_AcqGetChanel2AvgVariance(scpi_t * context);
 scpi_result_t RP_AcqGetBufferSize(scpi_t * context);
 
 scpi_result_t RP_AcqSetGain(rp_channel_t channel, scpi_t * context);
@@ -71,5 +77,8 @@ scpi_result_t RP_AcqGetOldestDataAll(rp_channel_t channel, scpi_t * context);
 scpi_result_t RP_AcqGetOldestData(rp_channel_t channel, scpi_t * context);
 scpi_result_t RP_AcqGetDataPos(rp_channel_t channel, scpi_t * context);
 scpi_result_t RP_AcqGetData(rp_channel_t channel, scpi_t * context);
+scpi_result_t RP_AcqGetAvgData(rp_channel_t channel, scpi_t * context);
+scpi_result_t RP_AcqGetAvgCount(rp_channel_t channel, scpi_t * context);
+scpi_result_t RP_AcqGetAvgVariance(rp_channel_t channel, scpi_t * context);
 
 #endif /* ACQUIRE_H_ */
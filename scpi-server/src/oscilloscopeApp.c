@@ -15,6 +15,7 @@
 #include <syslog.h>
 #include "oscilloscopeApp.h"
 #include <string.h>
+#include <stdlib.h>
 
 #include "../../api/rpApplications/src/rpApp.h"
 #include "../3rdparty/libs/scpi-parser/libscpi/inc/scpi/parser.h"
@@ -60,6 +61,16 @@ scpi_result_t RP_APP_OscAutoscale(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t RP_APP_OscResetMeasureStatistics(scpi_t *context) {
+    int result = rpApp_OscResetMeasureStatistics();
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:MEAS:STAT:RST Failed: %s.", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:MEAS:STAT:RST Successfully.");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_APP_OscSingle(scpi_t *context) {
     int result = rpApp_OscSingle();
     if (RP_OK != result) {
@@ -174,6 +185,26 @@ scpi_result_t RP_APP_OscChannel3GetViewData(scpi_t *context) {
     return RP_APP_OscGetViewData(RPAPP_OSC_SOUR_MATH, context);
 }
 
+scpi_result_t RP_APP_OscChannel1GetViewEnvelope(scpi_t *context) {
+    return RP_APP_OscGetViewEnvelope(RPAPP_OSC_SOUR_CH1, context);
+}
+
+scpi_result_t RP_APP_OscChannel2GetViewEnvelope(scpi_t *context) {
+    return RP_APP_OscGetViewEnvelope(RPAPP_OSC_SOUR_CH2, context);
+}
+
+scpi_result_t RP_APP_OscChannel1GetPersistenceImage(scpi_t *context) {
+    return RP_APP_OscGetPersistenceImage(RPAPP_OSC_SOUR_CH1, context);
+}
+
+scpi_result_t RP_APP_OscChannel2GetPersistenceImage(scpi_t *context) {
+    return RP_APP_OscGetPersistenceImage(RPAPP_OSC_SOUR_CH2, context);
+}
+
+scpi_result_t RP_APP_OscChannel3GetPersistenceImage(scpi_t *context) {
+    return RP_APP_OscGetPersistenceImage(RPAPP_OSC_SOUR_MATH, context);
+}
+
 scpi_result_t RP_APP_OscChannel1MeasureAmplitude(scpi_t *context) {
     return RP_APP_OscMeasureAmplitude(RPAPP_OSC_SOUR_CH1, context);
 }
@@ -270,6 +301,30 @@ scpi_result_t RP_APP_OscChannel3RMS(scpi_t *context) {
     return RP_APP_OscMeasureRMS(RPAPP_OSC_SOUR_MATH, context);
 }
 
+scpi_result_t RP_APP_OscChannel1MeasureStatistics(scpi_t *context) {
+    return RP_APP_OscMeasureStatistics(RPAPP_OSC_SOUR_CH1, context);
+}
+
+scpi_result_t RP_APP_OscChannel2MeasureStatistics(scpi_t *context) {
+    return RP_APP_OscMeasureStatistics(RPAPP_OSC_SOUR_CH2, context);
+}
+
+scpi_result_t RP_APP_OscChannel3MeasureStatistics(scpi_t *context) {
+    return RP_APP_OscMeasureStatistics(RPAPP_OSC_SOUR_MATH, context);
+}
+
+scpi_result_t RP_APP_OscChannel1EnableMeasureStatistics(scpi_t *context) {
+    return RP_APP_OscEnableMeasureStatistics(RPAPP_OSC_SOUR_CH1, context);
+}
+
+scpi_result_t RP_APP_OscChannel2EnableMeasureStatistics(scpi_t *context) {
+    return RP_APP_OscEnableMeasureStatistics(RPAPP_OSC_SOUR_CH2, context);
+}
+
+scpi_result_t RP_APP_OscChannel3EnableMeasureStatistics(scpi_t *context) {
+    return RP_APP_OscEnableMeasureStatistics(RPAPP_OSC_SOUR_MATH, context);
+}
+
 scpi_result_t RP_APP_OscChannel1GetCursorVoltage(scpi_t *context) {
     return RP_APP_OscGetCursorVoltage(RPAPP_OSC_SOUR_CH1, context);
 }
@@ -723,6 +778,197 @@ scpi_result_t RP_APP_OscGetViewPart(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t RP_APP_OscSetPeakDetect(scpi_t *context) {
+    bool value;
+    if (!SCPI_ParamBool(context, &value, true)) {
+        syslog(LOG_ERR, "*OSC:PEAK is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscSetPeakDetect(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PEAK Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:PEAK set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscGetPeakDetect(scpi_t *context) {
+    bool value;
+    int result = rpApp_OscGetPeakDetect(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PEAK? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBool(context, value);
+    syslog(LOG_INFO, "*OSC:PEAK? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscSetRollMode(scpi_t *context) {
+    bool value;
+    if (!SCPI_ParamBool(context, &value, true)) {
+        syslog(LOG_ERR, "*OSC:ROLL is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscSetRollMode(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:ROLL Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:ROLL set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscGetRollMode(scpi_t *context) {
+    bool value;
+    int result = rpApp_OscGetRollMode(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:ROLL? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBool(context, value);
+    syslog(LOG_INFO, "*OSC:ROLL? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscSetPersistence(scpi_t *context) {
+    const char * param;
+    size_t param_len;
+    char string[25];
+    if (!SCPI_ParamString(context, &param, &param_len, true)) {
+        syslog(LOG_ERR, "*OSC:PERS is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    if (param_len >= sizeof(string)) {
+        param_len = sizeof(string) - 1;
+    }
+    strncpy(string, param, param_len);
+    string[param_len] = '\0';
+    rpApp_osc_persist_t value;
+    if (getRpAppPersistence(string, &value)) {
+        syslog(LOG_ERR, "*OSC:PERS parameter invalid.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscSetPersistence(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PERS Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:PERS set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscGetPersistence(scpi_t *context) {
+    rpApp_osc_persist_t value;
+    int result = rpApp_OscGetPersistence(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PERS? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    char string[20];
+    if (getRpAppPersistenceString(value, string)) {
+        syslog(LOG_ERR, "*OSC:PERS? failed to convert to string.");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultString(context, string);
+    syslog(LOG_INFO, "*OSC:PERS? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscSetPersistenceTime(scpi_t *context) {
+    double value;
+    if (!SCPI_ParamDouble(context, &value, true)) {
+        syslog(LOG_ERR, "*OSC:PERS:TIME is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscSetPersistenceTime((float) value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PERS:TIME Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:PERS:TIME set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscGetPersistenceTime(scpi_t *context) {
+    float value;
+    int result = rpApp_OscGetPersistenceTime(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PERS:TIME? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, value);
+    syslog(LOG_INFO, "*OSC:PERS:TIME? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscResetPersistence(scpi_t *context) {
+    int result = rpApp_OscResetPersistence();
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:PERS:RST Failed: %s.", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:PERS:RST Successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscSetInterpolation(scpi_t *context) {
+    const char * param;
+    size_t param_len;
+    char string[25];
+    if (!SCPI_ParamString(context, &param, &param_len, true)) {
+        syslog(LOG_ERR, "*OSC:INTERP is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    if (param_len >= sizeof(string)) {
+        param_len = sizeof(string) - 1;
+    }
+    strncpy(string, param, param_len);
+    string[param_len] = '\0';
+    rpApp_osc_interp_t value;
+    if (getRpAppInterpolation(string, &value)) {
+        syslog(LOG_ERR, "*OSC:INTERP parameter invalid.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscSetInterpolation(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:INTERP Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:INTERP set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_OscGetInterpolation(scpi_t *context) {
+    rpApp_osc_interp_t value;
+    int result = rpApp_OscGetInterpolation(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:INTERP? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    char string[20];
+    if (getRpAppInterpolationString(value, string)) {
+        syslog(LOG_ERR, "*OSC:INTERP? failed to convert to string.");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultString(context, string);
+    syslog(LOG_INFO, "*OSC:INTERP? get successfully.");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_APP_OscGetAmplitudeOffset(rpApp_osc_source source, scpi_t *context) {
     double value;
     int result = rpApp_OscGetAmplitudeOffset(source, &value);
@@ -869,6 +1115,51 @@ scpi_result_t RP_APP_OscGetViewData(rpApp_osc_source source, scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+/* Returns min/max pairs, one per view point */
+scpi_result_t RP_APP_OscGetViewEnvelope(rpApp_osc_source source, scpi_t *context) {
+    uint32_t viewSize;
+    rpApp_OscGetViewSize(&viewSize);
+    float min[viewSize], max[viewSize], data[2 * viewSize];
+
+    int result = rpApp_OscGetViewEnvelope(source, min, max, viewSize);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:CH<n>:DATA:PEAK? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    for (int i = 0; i < viewSize; ++i) {
+        data[2 * i] = min[i];
+        data[2 * i + 1] = max[i];
+    }
+    SCPI_ResultBufferFloat(context, data, 2 * viewSize);
+    syslog(LOG_INFO, "*OSC:CH<n>:DATA:PEAK? get successfully.");
+    return SCPI_RES_OK;
+}
+
+/* Returns RPAPP_OSC_PERSIST_ROWS rows of view size intensity bytes, top row first */
+scpi_result_t RP_APP_OscGetPersistenceImage(rpApp_osc_source source, scpi_t *context) {
+    uint32_t viewSize;
+    rpApp_OscGetViewSize(&viewSize);
+    uint32_t size = viewSize * RPAPP_OSC_PERSIST_ROWS;
+    uint8_t *image = malloc(size);
+    if (image == NULL) {
+        syslog(LOG_ERR, "*OSC:CH<n>:DATA:PERS? Failed to allocate image.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscGetPersistenceImage(source, image, size);
+    if (RP_OK != result) {
+        free(image);
+        syslog(LOG_ERR, "*OSC:CH<n>:DATA:PERS? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBufferUInt8(context, image, size);
+    free(image);
+    syslog(LOG_INFO, "*OSC:CH<n>:DATA:PERS? get successfully.");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_APP_OscMeasureAmplitudeMin(rpApp_osc_source source, scpi_t *context) {
     float value;
     int result = rpApp_OscMeasureAmplitudeMin(source, &value);
@@ -954,6 +1245,75 @@ scpi_result_t RP_APP_OscMeasureDutyCycle(rpApp_osc_source source, scpi_t *contex
     return SCPI_RES_OK;
 }
 
+/* Returns count, mean, standard deviation, min and max of the measurement given as parameter */
+scpi_result_t RP_APP_OscMeasureStatistics(rpApp_osc_source source, scpi_t *context) {
+    const char * param;
+    size_t param_len;
+    char string[15];
+    if (!SCPI_ParamString(context, &param, &param_len, true)) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT? is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    if (param_len >= sizeof(string)) {
+        param_len = sizeof(string) - 1;
+    }
+    strncpy(string, param, param_len);
+    string[param_len] = '\0';
+    rpApp_osc_meas_t meas;
+    if (getRpAppMeasure(string, &meas)) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT? parameter invalid.");
+        return SCPI_RES_ERR;
+    }
+
+    rpApp_osc_meas_stats_t stats;
+    int result = rpApp_OscGetMeasureStatistics(source, meas, &stats);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultUInt(context, stats.count);
+    SCPI_ResultDouble(context, stats.mean);
+    SCPI_ResultDouble(context, stats.stddev);
+    SCPI_ResultDouble(context, stats.min);
+    SCPI_ResultDouble(context, stats.max);
+    syslog(LOG_INFO, "*OSC:MEAS:CH<n>:STAT? get successfully.");
+    return SCPI_RES_OK;
+}
+
+/* Enables or disables the statistics of the measurement given as first parameter */
+scpi_result_t RP_APP_OscEnableMeasureStatistics(rpApp_osc_source source, scpi_t *context) {
+    const char * param;
+    size_t param_len;
+    char string[15];
+    bool value;
+    if (!SCPI_ParamString(context, &param, &param_len, true)) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT:EN is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    if (param_len >= sizeof(string)) {
+        param_len = sizeof(string) - 1;
+    }
+    strncpy(string, param, param_len);
+    string[param_len] = '\0';
+    rpApp_osc_meas_t meas;
+    if (getRpAppMeasure(string, &meas)) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT:EN parameter invalid.");
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamBool(context, &value, true)) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT:EN is missing second parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_OscSetMeasureStatistics(source, meas, value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*OSC:MEAS:CH<n>:STAT:EN Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*OSC:MEAS:CH<n>:STAT:EN set successfully.");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_APP_OscMeasureRMS(rpApp_osc_source source, scpi_t *context) {
     float value;
     int result = rpApp_OscMeasureRootMeanSquare(source, &value);
@@ -66,9 +66,26 @@ scpi_result_t RP_APP_OscGetTriggerLevel(scpi_t *context);
 scpi_result_t RP_APP_OscSetViewSize(scpi_t *context);
 scpi_result_t RP_APP_OscGetViewSize(scpi_t *context);
 scpi_result_t RP_APP_OscGetViewPart(scpi_t *context);
+scpi_result_t RP_APP_OscSetPeakDetect(scpi_t *context);
+scpi_result_t RP_APP_OscGetPeakDetect(scpi_t *context);
+scpi_result_t RP_APP_OscSetRollMode(scpi_t *context);
+scpi_result_t RP_APP_OscGetRollMode(scpi_t *context);
+scpi_result_t RP_APP_OscSetPersistence(scpi_t *context);
+scpi_result_t RP_APP_OscGetPersistence(scpi_t *context);
+scpi_result_t RP_APP_OscSetPersistenceTime(scpi_t *context);
+scpi_result_t RP_APP_OscGetPersistenceTime(scpi_t *context);
+scpi_result_t RP_APP_OscResetPersistence(scpi_t *context);
+scpi_result_t RP_APP_OscChannel1GetPersistenceImage(scpi_t *context);
+scpi_result_t RP_APP_OscChannel2GetPersistenceImage(scpi_t *context);
+scpi_result_t RP_APP_OscChannel3GetPersistenceImage(scpi_t *context);
+scpi_result_t RP_APP_OscGetPersistenceImage(rpApp_osc_source source, scpi_t *context);
+scpi_result_t RP_APP_OscSetInterpolation(scpi_t *context);
+scpi_result_t RP_APP_OscGetInterpolation(scpi_t *context);
 scpi_result_t RP_APP_OscChannel1GetViewData(scpi_t *context);
 scpi_result_t RP_APP_OscChannel2GetViewData(scpi_t *context);
 scpi_result_t RP_APP_OscChannel3GetViewData(scpi_t *context);
+scpi_result_t RP_APP_OscChannel1GetViewEnvelope(scpi_t *context);
+scpi_result_t RP_APP_OscChannel2GetViewEnvelope(scpi_t *context);
 scpi_result_t RP_APP_OscChannel1MeasureAmplitude(scpi_t *context);
 scpi_result_t RP_APP_OscChannel2MeasureAmplitude(scpi_t *context);
 scpi_result_t RP_APP_OscChannel3MeasureAmplitude(scpi_t *context);
@@ -93,6 +110,13 @@ scpi_result_t RP_APP_OscChannel3MeasureDutyCycle(scpi_t *context);
 scpi_result_t RP_APP_OscChannel1RMS(scpi_t *context);
 scpi_result_t RP_APP_OscChannel2RMS(scpi_t *context);
 scpi_result_t RP_APP_OscChannel3RMS(scpi_t *context);
+scpi_result_t RP_APP_OscChannel1MeasureStatistics(scpi_t *context);
+scpi_result_t RP_APP_OscChannel2MeasureStatistics(scpi_t *context);
+scpi_result_t RP_APP_OscChannel3MeasureStatistics(scpi_t *context);
+scpi_result_t RP_APP_OscChannel1EnableMeasureStatistics(scpi_t *context);
+scpi_result_t RP_APP_OscChannel2EnableMeasureStatistics(scpi_t *context);
+scpi_result_t RP_APP_OscChannel3EnableMeasureStatistics(scpi_t *context);
+scpi_result_t RP_APP_OscResetMeasureStatistics(scpi_t *context);
 scpi_result_t RP_APP_OscChannel1GetCursorVoltage(scpi_t *context);
 scpi_result_t RP_APP_OscChannel2GetCursorVoltage(scpi_t *context);
 scpi_result_t RP_APP_OscChannel3GetCursorVoltage(scpi_t *context);
@@ -116,6 +140,7 @@ scpi_result_t RP_APP_OscGetProbeAtt(rp_channel_t channel, scpi_t *context);
 scpi_result_t RP_APP_OscSetInputGain(rp_channel_t channel, scpi_t *context);
 scpi_result_t RP_APP_OscGetInputGain(rp_channel_t channel, scpi_t *context);
 scpi_result_t RP_APP_OscGetViewData(rpApp_osc_source channel, scpi_t *context);
+scpi_result_t RP_APP_OscGetViewEnvelope(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscMeasureAmplitude(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscMeasureMeanVoltage(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscMeasureAmplitudeMax(rpApp_osc_source channel, scpi_t *context);
@@ -124,6 +149,8 @@ scpi_result_t RP_APP_OscMeasureFrequency(rpApp_osc_source channel, scpi_t *conte
 scpi_result_t RP_APP_OscMeasurePeriod(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscMeasureDutyCycle(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscMeasureRMS(rpApp_osc_source channel, scpi_t *context);
+scpi_result_t RP_APP_OscMeasureStatistics(rpApp_osc_source channel, scpi_t *context);
+scpi_result_t RP_APP_OscEnableMeasureStatistics(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscGetCursorVoltage(rpApp_osc_source channel, scpi_t *context);
 scpi_result_t RP_APP_OscGetCursorDeltaAmplitude(rpApp_osc_source channel, scpi_t *context);
 
@@ -189,6 +189,12 @@ static const scpi_command_t scpi_commands[] = {
         {.pattern = "ACQ:SOUR2:DATA:OLD:N?", .callback = RP_AcqGetChanel2OldestData,},
         {.pattern = "ACQ:SOUR1:DATA:LAT:N?", .callback = RP_AcqGetChanel1LatestData,},
         {.pattern = "ACQ:SOUR2:DATA:LAT:N?", .callback = RP_AcqGetChanel2LatestData,},
+        {.pattern = "ACQ:SOUR1:DATA:AVG?", .callback = RP_AcqGetChanel1AvgData,},
+        {.pattern = "ACQ:SOUR2:DATA:AVG?", .callback = RP_AcqGetChanel2AvgData,},
+        {.pattern = "ACQ:SOUR1:DATA:AVG:COUNT?", .callback = RP_AcqGetChanel1AvgCount,},
+        {.pattern = "ACQ:SOUR2:DATA:AVG:COUNT?", .callback = RP_AcqGetChanel2AvgCount,},
+        {.pattern = "ACQ:SOUR1:DATA:AVG:VAR?", .callback = RP_AcqGetChanel1AvgVariance,},
+        {.pattern = "ACQ:SOUR2:DATA:AVG:VAR?", .callback = RP_AcqGetChanel2AvgVariance,},
         {.pattern = "ACQ:BUF:SIZE?", .callback = RP_AcqGetBufferSize,},
 
         /* Generate */
@@ -292,9 +298,25 @@ static const scpi_command_t scpi_commands[] = {
         {.pattern = "OSC:CH1:DATA?", .callback = RP_APP_OscChannel1GetViewData,},
         {.pattern = "OSC:CH2:DATA?", .callback = RP_APP_OscChannel2GetViewData,},
         {.pattern = "OSC:MATH:DATA?", .callback = RP_APP_OscChannel3GetViewData,},
+        {.pattern = "OSC:CH1:DATA:PEAK?", .callback = RP_APP_OscChannel1GetViewEnvelope,},
+        {.pattern = "OSC:CH2:DATA:PEAK?", .callback = RP_APP_OscChannel2GetViewEnvelope,},
         {.pattern = "OSC:DATA:SIZE", .callback = RP_APP_OscSetViewSize,},
         {.pattern = "OSC:DATA:SIZE?", .callback = RP_APP_OscGetViewSize,},
         {.pattern = "OSC:VIEW:PART?", .callback = RP_APP_OscGetViewPart,},
+        {.pattern = "OSC:PEAK", .callback = RP_APP_OscSetPeakDetect,},
+        {.pattern = "OSC:PEAK?", .callback = RP_APP_OscGetPeakDetect,},
+        {.pattern = "OSC:ROLL", .callback = RP_APP_OscSetRollMode,},
+        {.pattern = "OSC:ROLL?", .callback = RP_APP_OscGetRollMode,},
+        {.pattern = "OSC:PERS", .callback = RP_APP_OscSetPersistence,},
+        {.pattern = "OSC:PERS?", .callback = RP_APP_OscGetPersistence,},
+        {.pattern = "OSC:PERS:TIME", .callback = RP_APP_OscSetPersistenceTime,},
+        {.pattern = "OSC:PERS:TIME?", .callback = RP_APP_OscGetPersistenceTime,},
+        {.pattern = "OSC:PERS:RST", .callback = RP_APP_OscResetPersistence,},
+        {.pattern = "OSC:CH1:DATA:PERS?", .callback = RP_APP_OscChannel1GetPersistenceImage,},
+        {.pattern = "OSC:CH2:DATA:PERS?", .callback = RP_APP_OscChannel2GetPersistenceImage,},
+        {.pattern = "OSC:MATH:DATA:PERS?", .callback = RP_APP_OscChannel3GetPersistenceImage,},
+        {.pattern = "OSC:INTERP", .callback = RP_APP_OscSetInterpolation,},
+        {.pattern = "OSC:INTERP?", .callback = RP_APP_OscGetInterpolation,},
         {.pattern = "OSC:MEAS:CH1:VPP?", .callback = RP_APP_OscChannel1MeasureAmplitude,},
         {.pattern = "OSC:MEAS:CH2:VPP?", .callback = RP_APP_OscChannel2MeasureAmplitude,},
         {.pattern = "OSC:MEAS:MATH:VPP?", .callback = RP_APP_OscChannel3MeasureAmplitude,},
@@ -319,6 +341,13 @@ static const scpi_command_t scpi_commands[] = {
         {.pattern = "OSC:MEAS:CH1:RMS?", .callback = RP_APP_OscChannel1RMS,},
         {.pattern = "OSC:MEAS:CH2:RMS?", .callback = RP_APP_OscChannel2RMS,},
         {.pattern = "OSC:MEAS:MATH:RMS?", .callback = RP_APP_OscChannel3RMS,},
+        {.pattern = "OSC:MEAS:CH1:STAT?", .callback = RP_APP_OscChannel1MeasureStatistics,},
+        {.pattern = "OSC:MEAS:CH2:STAT?", .callback = RP_APP_OscChannel2MeasureStatistics,},
+        {.pattern = "OSC:MEAS:MATH:STAT?", .callback = RP_APP_OscChannel3MeasureStatistics,},
+        {.pattern = "OSC:MEAS:CH1:STAT:EN", .callback = RP_APP_OscChannel1EnableMeasureStatistics,},
+        {.pattern = "OSC:MEAS:CH2:STAT:EN", .callback = RP_APP_OscChannel2EnableMeasureStatistics,},
+        {.pattern = "OSC:MEAS:MATH:STAT:EN", .callback = RP_APP_OscChannel3EnableMeasureStatistics,},
+        {.pattern = "OSC:MEAS:STAT:RST", .callback = RP_APP_OscResetMeasureStatistics,},
         {.pattern = "OSC:CUR:CH1:V?", .callback = RP_APP_OscChannel1GetCursorVoltage,},
         {.pattern = "OSC:CUR:CH2:V?", .callback = RP_APP_OscChannel2GetCursorVoltage,},
         {.pattern = "OSC:CUR:MATH:V?", .callback = RP_APP_OscChannel3GetCursorVoltage,},
@@ -341,6 +370,10 @@ static const scpi_command_t scpi_commands[] = {
 
         {.pattern = "SPEC:CH1:DATA?", .callback = RP_APP_SpecChannel1GetViewData,},
         {.pattern = "SPEC:CH2:DATA?", .callback = RP_APP_SpecChannel2GetViewData,},
+        {.pattern = "SPEC:CH1:DATA:MAX?", .callback = RP_APP_SpecChannel1GetMaxHold,},
+        {.pattern = "SPEC:CH2:DATA:MAX?", .callback = RP_APP_SpecChannel2GetMaxHold,},
+        {.pattern = "SPEC:CH1:DATA:MIN?", .callback = RP_APP_SpecChannel1GetMinHold,},
+        {.pattern = "SPEC:CH2:DATA:MIN?", .callback = RP_APP_SpecChannel2GetMinHold,},
         {.pattern = "SPEC:DATA:SIZE?", .callback = RP_APP_SpecGetViewSize,},
         {.pattern = "SPEC:DATA:SIZE", .callback = RP_APP_SpecSetViewSize,}, // TODO ??
 
@@ -348,6 +381,7 @@ static const scpi_command_t scpi_commands[] = {
         {.pattern = "SPEC:CH2:PEAK?", .callback = RP_APP_SpecChannel2GetPeak,},
         {.pattern = "SPEC:CH1:PEAK:FREQ?", .callback = RP_APP_SpecChannel1GetPeakFreq,},
         {.pattern = "SPEC:CH2:PEAK:FREQ?", .callback = RP_APP_SpecChannel2GetPeakFreq,},
+        {.pattern = "SPEC:RATE?", .callback = RP_APP_SpecGetSpectraRate,},
 
         {.pattern = "SPEC:FREQ:MIN?", .callback = RP_APP_SpecGetFreqMin,},
         {.pattern = "SPEC:FREQ:MAX?", .callback = RP_APP_SpecGetFreqMax,},
@@ -355,6 +389,14 @@ static const scpi_command_t scpi_commands[] = {
         {.pattern = "SPEC:FREQ:MAX", .callback = RP_APP_SpecSetFreqMax,},
         {.pattern = "SPEC:FPGA:FREQ?", .callback = RP_APP_SpecGetFpgaFreq,},
 
+        {.pattern = "SPEC:AVG:SEG", .callback = RP_APP_SpecSetWelchSegments,},
+        {.pattern = "SPEC:AVG:SEG?", .callback = RP_APP_SpecGetWelchSegments,},
+        {.pattern = "SPEC:AVG:MODE", .callback = RP_APP_SpecSetAvgMode,},
+        {.pattern = "SPEC:AVG:MODE?", .callback = RP_APP_SpecGetAvgMode,},
+        {.pattern = "SPEC:AVG:COUNT", .callback = RP_APP_SpecSetAvgCount,},
+        {.pattern = "SPEC:AVG:COUNT?", .callback = RP_APP_SpecGetAvgCount,},
+        {.pattern = "SPEC:AVG:RST", .callback = RP_APP_SpecResetAveraging,},
+
     SCPI_CMD_LIST_END
 };
 
@@ -22,15 +22,16 @@
 #include "utils.h"
 
 
-scpi_result_t RP_APP_SpecGetViewData(rpApp_osc_source source, scpi_t *context) {
+/* signal indexes the view signals, see RPAPP_SPEC_SIG_NUM */
+scpi_result_t RP_APP_SpecGetViewData(int signal, scpi_t *context) {
     uint32_t viewSize = 0;
     rpApp_SpecGetViewSize(&viewSize);
 
-	static float* data[3] = {0};
+	static float* data[RPAPP_SPEC_SIG_NUM] = {0};
 	if (data[0] == 0)
 	{
 		size_t i;
-		for (i = 0; i < 3; ++i)
+		for (i = 0; i < RPAPP_SPEC_SIG_NUM; ++i)
 			data[i] = malloc(sizeof(float)*viewSize);
 	}
 
@@ -40,11 +41,35 @@ scpi_result_t RP_APP_SpecGetViewData(rpApp_osc_source source, scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    SCPI_ResultBufferFloat(context, data[source], viewSize);
+    SCPI_ResultBufferFloat(context, data[signal], viewSize);
     syslog(LOG_INFO, "*SPEC:CH<n>:DATA? get successfully.");
     return SCPI_RES_OK;
 }
 
+/* signal indexes the hold signals, see RPAPP_SPEC_HOLD_NUM */
+scpi_result_t RP_APP_SpecGetHoldData(int signal, scpi_t *context) {
+    uint32_t viewSize = 0;
+    rpApp_SpecGetViewSize(&viewSize);
+
+	static float* data[RPAPP_SPEC_HOLD_NUM] = {0};
+	if (data[0] == 0)
+	{
+		size_t i;
+		for (i = 0; i < RPAPP_SPEC_HOLD_NUM; ++i)
+			data[i] = malloc(sizeof(float)*viewSize);
+	}
+
+    int result = rpApp_SpecGetHoldData(data, viewSize);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:CH<n>:DATA:MAX|MIN? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBufferFloat(context, data[signal], viewSize);
+    syslog(LOG_INFO, "*SPEC:CH<n>:DATA:MAX|MIN? get successfully.");
+    return SCPI_RES_OK;
+}
+
 
 scpi_result_t RP_APP_SpecRun(scpi_t *context) {
     syslog(LOG_INFO, "*SPEC:RUN start.");
@@ -85,12 +110,29 @@ scpi_result_t RP_APP_SpecRunning(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+/* signal 0 is the frequency axis */
 scpi_result_t RP_APP_SpecChannel1GetViewData(scpi_t *context) {
-    return RP_APP_SpecGetViewData(RPAPP_OSC_SOUR_CH1, context);
+    return RP_APP_SpecGetViewData(1, context);
 }
 
 scpi_result_t RP_APP_SpecChannel2GetViewData(scpi_t *context) {
-    return RP_APP_SpecGetViewData(RPAPP_OSC_SOUR_CH2, context);
+    return RP_APP_SpecGetViewData(2, context);
+}
+
+scpi_result_t RP_APP_SpecChannel1GetMaxHold(scpi_t *context) {
+    return RP_APP_SpecGetHoldData(0, context);
+}
+
+scpi_result_t RP_APP_SpecChannel2GetMaxHold(scpi_t *context) {
+    return RP_APP_SpecGetHoldData(1, context);
+}
+
+scpi_result_t RP_APP_SpecChannel1GetMinHold(scpi_t *context) {
+    return RP_APP_SpecGetHoldData(2, context);
+}
+
+scpi_result_t RP_APP_SpecChannel2GetMinHold(scpi_t *context) {
+    return RP_APP_SpecGetHoldData(3, context);
 }
 
 scpi_result_t RP_APP_SpecGetViewSize(scpi_t *context) {
@@ -171,6 +213,19 @@ scpi_result_t RP_APP_SpecChannel2GetPeakFreq(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t RP_APP_SpecGetSpectraRate(scpi_t *context) {
+	float rate;
+    int result = rpApp_SpecGetSpectraRate(&rate);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:RATE? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, rate);
+    syslog(LOG_INFO, "*SPEC:RATE? get successfully.");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_APP_SpecGetFreqMin(scpi_t *context) {
 	float freq;
     int result = rpApp_SpecGetFreqMin(&freq);
@@ -243,4 +298,117 @@ scpi_result_t RP_APP_SpecGetFpgaFreq(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t RP_APP_SpecSetWelchSegments(scpi_t *context) {
+    int32_t value;
+    if (!SCPI_ParamInt(context, &value, true)) {
+        syslog(LOG_ERR, "*SPEC:AVG:SEG is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_SpecSetWelchSegments(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:SEG Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*SPEC:AVG:SEG set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_SpecGetWelchSegments(scpi_t *context) {
+    int value;
+    int result = rpApp_SpecGetWelchSegments(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:SEG? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
 
+    SCPI_ResultInt(context, value);
+    syslog(LOG_INFO, "*SPEC:AVG:SEG? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_SpecSetAvgMode(scpi_t *context) {
+    const char * param;
+    size_t param_len;
+    char string[25];
+    if (!SCPI_ParamString(context, &param, &param_len, true)) {
+        syslog(LOG_ERR, "*SPEC:AVG:MODE is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+    if (param_len >= sizeof(string)) {
+        param_len = sizeof(string) - 1;
+    }
+    strncpy(string, param, param_len);
+    string[param_len] = '\0';
+    rpApp_spec_avg_t value;
+    if (getRpAppSpecAvg(string, &value)) {
+        syslog(LOG_ERR, "*SPEC:AVG:MODE parameter invalid.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_SpecSetAvgMode(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:MODE Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*SPEC:AVG:MODE set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_SpecGetAvgMode(scpi_t *context) {
+    rpApp_spec_avg_t value;
+    int result = rpApp_SpecGetAvgMode(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:MODE? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    char string[20];
+    if (getRpAppSpecAvgString(value, string)) {
+        syslog(LOG_ERR, "*SPEC:AVG:MODE? failed to convert to string.");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultString(context, string);
+    syslog(LOG_INFO, "*SPEC:AVG:MODE? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_SpecSetAvgCount(scpi_t *context) {
+    int32_t value;
+    if (!SCPI_ParamInt(context, &value, true)) {
+        syslog(LOG_ERR, "*SPEC:AVG:COUNT is missing first parameter.");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rpApp_SpecSetAvgCount(value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:COUNT Failed to set: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*SPEC:AVG:COUNT set successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_SpecGetAvgCount(scpi_t *context) {
+    int value;
+    int result = rpApp_SpecGetAvgCount(&value);
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:COUNT? Failed to get: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultInt(context, value);
+    syslog(LOG_INFO, "*SPEC:AVG:COUNT? get successfully.");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_APP_SpecResetAveraging(scpi_t *context) {
+    int result = rpApp_SpecResetAveraging();
+    if (RP_OK != result) {
+        syslog(LOG_ERR, "*SPEC:AVG:RST Failed: %s.", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    syslog(LOG_INFO, "*SPEC:AVG:RST Successfully.");
+    return SCPI_RES_OK;
+}
@@ -28,6 +28,10 @@ scpi_result_t RP_APP_SpecRunning(scpi_t *context); // :RUNNING
 
 scpi_result_t RP_APP_SpecChannel1GetViewData(scpi_t *context); // :CH1:DATA?
 scpi_result_t RP_APP_SpecChannel2GetViewData(scpi_t *context); // :CH2:DATA?
+scpi_result_t RP_APP_SpecChannel1GetMaxHold(scpi_t *context); // :CH1:DATA:MAX?
+scpi_result_t RP_APP_SpecChannel2GetMaxHold(scpi_t *context); // :CH2:DATA:MAX?
+scpi_result_t RP_APP_SpecChannel1GetMinHold(scpi_t *context); // :CH1:DATA:MIN?
+scpi_result_t RP_APP_SpecChannel2GetMinHold(scpi_t *context); // :CH2:DATA:MIN?
 scpi_result_t RP_APP_SpecGetViewSize(scpi_t *context); // :DATA:SIZE?
 scpi_result_t RP_APP_SpecSetViewSize(scpi_t *context); // :DATA:SIZE
 
@@ -35,6 +39,7 @@ scpi_result_t RP_APP_SpecChannel1GetPeak(scpi_t *context); // :CH1:PEAK
 scpi_result_t RP_APP_SpecChannel2GetPeak(scpi_t *context); // :CH2:PEAK
 scpi_result_t RP_APP_SpecChannel1GetPeakFreq(scpi_t *context); // :CH1:PEAK:FREQ
 scpi_result_t RP_APP_SpecChannel2GetPeakFreq(scpi_t *context); // :CH2:PEAK:FREQ
+scpi_result_t RP_APP_SpecGetSpectraRate(scpi_t *context); // :RATE?
 scpi_result_t RP_APP_SpecChannel1Freeze(scpi_t *context); // :CH1:FREEZE
 scpi_result_t RP_APP_SpecChannel2Freeze(scpi_t *context); // :CH2:FREEZE
 
@@ -44,4 +49,12 @@ scpi_result_t RP_APP_SpecSetFreqMin(scpi_t *context); // :FREQ:MIN
 scpi_result_t RP_APP_SpecSetFreqMax(scpi_t *context); // :FREQ:MAX
 scpi_result_t RP_APP_SpecGetFpgaFreq(scpi_t *context); // :FPGA:FREQ
 
+scpi_result_t RP_APP_SpecSetWelchSegments(scpi_t *context); // :AVG:SEG
+scpi_result_t RP_APP_SpecGetWelchSegments(scpi_t *context); // :AVG:SEG?
+scpi_result_t RP_APP_SpecSetAvgMode(scpi_t *context); // :AVG:MODE
+scpi_result_t RP_APP_SpecGetAvgMode(scpi_t *context); // :AVG:MODE?
+scpi_result_t RP_APP_SpecSetAvgCount(scpi_t *context); // :AVG:COUNT
+scpi_result_t RP_APP_SpecGetAvgCount(scpi_t *context); // :AVG:COUNT?
+scpi_result_t RP_APP_SpecResetAveraging(scpi_t *context); // :AVG:RST
+
 #endif /* OSCILLOSCOPE_APP_H_ */
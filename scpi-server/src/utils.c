@@ -299,6 +299,40 @@ int getRpAppTrigSweepString(rpApp_osc_trig_sweep_t sweep, char *string) {
 	return RP_OK;
 }
 
+int getRpAppPersistence(const char *string, rpApp_osc_persist_t *mode) {
+	if      (strcmp(string, "OFF"  ) == 0)  *mode = RPAPP_OSC_PERSIST_OFF;
+	else if (strcmp(string, "DECAY") == 0)  *mode = RPAPP_OSC_PERSIST_DECAY;
+	else if (strcmp(string, "INF"  ) == 0)  *mode = RPAPP_OSC_PERSIST_INFINITE;
+	else                                    return RP_EOOR;
+	return RP_OK;
+}
+
+int getRpAppPersistenceString(rpApp_osc_persist_t mode, char *string) {
+	switch (mode) {
+		case RPAPP_OSC_PERSIST_OFF     :  strcpy(string, "OFF"  );  break;
+		case RPAPP_OSC_PERSIST_DECAY   :  strcpy(string, "DECAY");  break;
+		case RPAPP_OSC_PERSIST_INFINITE:  strcpy(string, "INF"  );  break;
+		default                        :  return RP_EOOR;
+	}
+	return RP_OK;
+}
+
+int getRpAppInterpolation(const char *string, rpApp_osc_interp_t *interp) {
+	if      (strcmp(string, "LINEAR") == 0)  *interp = RPAPP_OSC_INTERP_LINEAR;
+	else if (strcmp(string, "SINC"  ) == 0)  *interp = RPAPP_OSC_INTERP_SINC;
+	else                                     return RP_EOOR;
+	return RP_OK;
+}
+
+int getRpAppInterpolationString(rpApp_osc_interp_t interp, char *string) {
+	switch (interp) {
+		case RPAPP_OSC_INTERP_LINEAR:  strcpy(string, "LINEAR");  break;
+		case RPAPP_OSC_INTERP_SINC  :  strcpy(string, "SINC"  );  break;
+		default                     :  return RP_EOOR;
+	}
+	return RP_OK;
+}
+
 int getRpAppMathOperation(const char *string, rpApp_osc_math_oper_t *op) {
 	if      (strcmp(string, "NONE") == 0)  *op = RPAPP_OSC_MATH_NONE;
 	else if (strcmp(string, "ADD" ) == 0)  *op = RPAPP_OSC_MATH_ADD ;
@@ -308,6 +342,7 @@ int getRpAppMathOperation(const char *string, rpApp_osc_math_oper_t *op) {
 	else if (strcmp(string, "ABS" ) == 0)  *op = RPAPP_OSC_MATH_ABS ;
 	else if (strcmp(string, "DER" ) == 0)  *op = RPAPP_OSC_MATH_DER ;
 	else if (strcmp(string, "INT" ) == 0)  *op = RPAPP_OSC_MATH_INT ;
+	else if (strcmp(string, "FFT" ) == 0)  *op = RPAPP_OSC_MATH_FFT ;
 	else                                   return RP_EOOR;
 	return RP_OK;
 }
@@ -322,11 +357,42 @@ int getRpAppMathOperationString(rpApp_osc_math_oper_t op, char *string) {
 		case RPAPP_OSC_MATH_ABS :  strcpy(string, "ABS" );  break;
 		case RPAPP_OSC_MATH_DER :  strcpy(string, "DER" );  break;
 		case RPAPP_OSC_MATH_INT :  strcpy(string, "INT" );  break;
+		case RPAPP_OSC_MATH_FFT :  strcpy(string, "FFT" );  break;
 		default                 :  return RP_EOOR;
 	}
 	return RP_OK;
 }
 
+int getRpAppSpecAvg(const char *string, rpApp_spec_avg_t *mode) {
+	if      (strcmp(string, "LIN") == 0)  *mode = RPAPP_SPEC_AVG_LINEAR;
+	else if (strcmp(string, "EXP") == 0)  *mode = RPAPP_SPEC_AVG_EXP;
+	else                                  return RP_EOOR;
+	return RP_OK;
+}
+
+int getRpAppSpecAvgString(rpApp_spec_avg_t mode, char *string) {
+	switch (mode) {
+		case RPAPP_SPEC_AVG_LINEAR:  strcpy(string, "LIN");  break;
+		case RPAPP_SPEC_AVG_EXP   :  strcpy(string, "EXP");  break;
+		default                   :  return RP_EOOR;
+	}
+	return RP_OK;
+}
+
+/* Measurement names follow the OSC:MEAS:CH<n>:<name>? commands */
+int getRpAppMeasure(const char *string, rpApp_osc_meas_t *meas) {
+	if      (strcmp(string, "VPP"  ) == 0)  *meas = RPAPP_OSC_MEAS_VPP   ;
+	else if (strcmp(string, "VMEAN") == 0)  *meas = RPAPP_OSC_MEAS_VMEAN ;
+	else if (strcmp(string, "VMAX" ) == 0)  *meas = RPAPP_OSC_MEAS_VMAX  ;
+	else if (strcmp(string, "VMIN" ) == 0)  *meas = RPAPP_OSC_MEAS_VMIN  ;
+	else if (strcmp(string, "FREQ" ) == 0)  *meas = RPAPP_OSC_MEAS_FREQ  ;
+	else if (strcmp(string, "T0"   ) == 0)  *meas = RPAPP_OSC_MEAS_PERIOD;
+	else if (strcmp(string, "DCYC" ) == 0)  *meas = RPAPP_OSC_MEAS_DUTY  ;
+	else if (strcmp(string, "RMS"  ) == 0)  *meas = RPAPP_OSC_MEAS_RMS   ;
+	else                                    return RP_EOOR;
+	return RP_OK;
+}
+
 int getRpInfinityInteger(const char *string, int32_t *value) {
     if (strcmp(string, "INF") == 0)  *value = 0;
     else                             *value = atoi(string);
@@ -53,8 +53,15 @@ int getRpAppTrigSlope(const char *string, rpApp_osc_trig_slope_t *slope);
 int getRpAppTrigSlopeString(rpApp_osc_trig_slope_t slope, char *string);
 int getRpAppTrigSweep(const char *string, rpApp_osc_trig_sweep_t *sweep);
 int getRpAppTrigSweepString(rpApp_osc_trig_sweep_t sweep, char *string);
+int getRpAppPersistence(const char *string, rpApp_osc_persist_t *mode);
+int getRpAppPersistenceString(rpApp_osc_persist_t mode, char *string);
+int getRpAppInterpolation(const char *string, rpApp_osc_interp_t *interp);
+int getRpAppInterpolationString(rpApp_osc_interp_t interp, char *string);
 int getRpAppMathOperation(const char *string, rpApp_osc_math_oper_t *op);
 int getRpAppMathOperationString(rpApp_osc_math_oper_t op, char *string);
+int getRpAppMeasure(const char *string, rpApp_osc_meas_t *meas);
+int getRpAppSpecAvg(const char *string, rpApp_spec_avg_t *mode);
+int getRpAppSpecAvgString(rpApp_spec_avg_t mode, char *string);
 
 int getRpInfinityInteger(const char *string, int32_t *value);
 int getRpInfinityIntegerString(int32_t value, char *string);